@@ -0,0 +1,185 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace tom::bench {
+
+/**
+ * Keep the compiler from deleting a computation whose result is unused
+ */
+template <typename T>
+inline void keep(T const& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * Average nanoseconds per call of op over `iterations` calls, after the
+ * same number of calls to warm up caches and branch predictors
+ */
+template <typename Op>
+double ns_per_op(std::size_t iterations, Op&& op)
+{
+    for (std::size_t i = 0; i < iterations; i++) {
+        op();
+    }
+
+    auto const start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; i++) {
+        op();
+    }
+    auto const end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(end - start).count() /
+           static_cast<double>(iterations);
+}
+
+inline void report(std::string_view name, double ns)
+{
+    std::cout << std::left << std::setw(40) << name << std::right
+              << std::setw(10) << std::fixed << std::setprecision(2) << ns
+              << " ns/op\n";
+}
+
+/**
+ * Nanoseconds per call over many repetitions of `iterations` calls each, so
+ * that a single slow repetition (an interrupt, a page fault) shows up in p99
+ * instead of skewing the result
+ */
+struct Stats {
+    double      min;
+    double      median;
+    double      p99;
+    double      mean;
+    std::size_t repetitions;
+    std::size_t iterations;
+};
+
+struct Repetitions {
+    std::size_t warmup      = 3;
+    std::size_t repetitions = 31;
+};
+
+template <typename Op>
+Stats measure(std::size_t iterations, Op&& op, Repetitions reps = {})
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<double> samples;
+    samples.reserve(reps.repetitions);
+    for (std::size_t r = 0; r < reps.warmup + reps.repetitions; r++) {
+        auto const start = Clock::now();
+        for (std::size_t i = 0; i < iterations; i++) {
+            op();
+        }
+        auto const end = Clock::now();
+        if (r >= reps.warmup) {
+            samples.push_back(
+                std::chrono::duration<double, std::nano>(end - start).count() /
+                static_cast<double>(iterations));
+        }
+    }
+
+    std::ranges::sort(samples);
+    auto const at = [&](double quantile) {
+        return samples[static_cast<std::size_t>(
+            quantile * static_cast<double>(samples.size() - 1) + 0.5)];
+    };
+    double sum = 0.0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+    return {.min         = samples.front(),
+            .median      = at(0.5),
+            .p99         = at(0.99),
+            .mean        = sum / static_cast<double>(samples.size()),
+            .repetitions = samples.size(),
+            .iterations  = iterations};
+}
+
+/**
+ * Collects named results, prints each as it comes in and writes them all
+ * as JSON at the end, for comparing runs before and after a change
+ */
+class Suite {
+   public:
+    explicit Suite(std::string name) : name(std::move(name))
+    {
+        std::cout << std::left << std::setw(44) << this->name << std::right
+                  << std::setw(12) << "min" << std::setw(12) << "median"
+                  << std::setw(12) << "p99" << "  (ns/op)\n";
+    }
+
+    Stats const& add(std::string case_name, Stats const& stats)
+    {
+        std::cout << std::left << std::setw(44) << case_name << std::right
+                  << std::fixed << std::setprecision(2) << std::setw(12)
+                  << stats.min << std::setw(12) << stats.median
+                  << std::setw(12) << stats.p99 << "\n";
+        results.push_back({std::move(case_name), stats});
+        return results.back().stats;
+    }
+
+    template <typename Op>
+    Stats const& run(std::string case_name, std::size_t iterations, Op&& op,
+                     Repetitions reps = {})
+    {
+        return add(std::move(case_name),
+                   measure(iterations, std::forward<Op>(op), reps));
+    }
+
+    void write_json(std::ostream& out) const
+    {
+        out << "{\"suite\": \"" << name << "\", \"unit\": \"ns/op\", "
+            << "\"results\": [";
+        for (std::size_t i = 0; i < results.size(); i++) {
+            auto const& [case_name, stats] = results[i];
+            out << (i == 0 ? "\n" : ",\n") << "  {\"name\": \"" << case_name
+                << "\", \"min\": " << stats.min
+                << ", \"median\": " << stats.median
+                << ", \"p99\": " << stats.p99 << ", \"mean\": " << stats.mean
+                << ", \"repetitions\": " << stats.repetitions
+                << ", \"iterations\": " << stats.iterations << "}";
+        }
+        out << "\n]}\n";
+    }
+
+    /**
+     * Write the JSON to the file named after --json on the command line, if
+     * there is one. Returns false if it cannot be written
+     */
+    bool write_json(int argc, char const* argv[]) const
+    {
+        for (int i = 1; i + 1 < argc; i++) {
+            if (std::string_view(argv[i]) == "--json") {
+                std::ofstream out(argv[i + 1]);
+                write_json(out);
+                return static_cast<bool>(out);
+            }
+        }
+        return true;
+    }
+
+   private:
+    struct Result {
+        std::string name;
+        Stats       stats;
+    };
+
+    std::string         name;
+    std::vector<Result> results;
+};
+
+}  // namespace tom::bench
+
+#endif  // BENCH_H
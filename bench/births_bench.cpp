@@ -0,0 +1,77 @@
+// Births per second: everything random that happens when vehicles reproduce
+// or explode and food spawns, without the rest of the tick around it
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include "bench.h"
+#include "dna.h"
+#include "fooddna.h"
+#include "randomstream.h"
+#include "utils.h"
+#include "vehicle.h"
+
+using namespace tom;
+
+static constexpr std::size_t ITERATIONS = 2'000'000;
+
+int main()
+{
+    std::uint32_t id = 0;
+
+    // every birth happens inside of some entity's stream during a tick
+    auto                stream = RandomStream::for_world(42, 0);
+    RandomStream::Scope scope(stream);
+
+    DNA const mom;
+    DNA const dad;
+
+    auto const reproduction = bench::ns_per_op(ITERATIONS, [&] {
+        DNA child = mom.crossover(dad);
+        child.mutate();
+        bench::keep(child);
+    });
+    bench::report("reproduction (crossover + mutate)", reproduction);
+
+    auto const explosion = bench::ns_per_op(ITERATIONS, [&] {
+        DNA child = mom;
+        child.mutate();
+        bench::keep(child);
+    });
+    bench::report("explosion child (copy + mutate)", explosion);
+
+    // an exploding vehicle draws the mutations of its whole litter at once
+    constexpr std::size_t LITTER = 8;
+    std::array<double, LITTER * DNA::MUTATION_DRAWS> uniforms;
+    auto const litter = bench::ns_per_op(ITERATIONS / LITTER, [&] {
+        random_fill(uniforms);
+        for (std::size_t i = 0; i < LITTER; i++) {
+            DNA child = mom;
+            child.mutate(std::span<double const>(uniforms)
+                             .subspan(i * DNA::MUTATION_DRAWS)
+                             .first<DNA::MUTATION_DRAWS>());
+            bench::keep(child);
+        }
+    }) / LITTER;
+    bench::report("explosion child (litter of 8)", litter);
+
+    auto const vehicle = bench::ns_per_op(ITERATIONS, [&] {
+        Vehicle v(Vec2D{static_cast<double>(id++ % 800), 300.0});
+        bench::keep(v);
+    });
+    bench::report("new random vehicle", vehicle);
+
+    auto const food = bench::ns_per_op(ITERATIONS, [&] {
+        FoodDNA child;
+        child.mutate();
+        bench::keep(child);
+    });
+    bench::report("food spawn (new dna + mutate)", food);
+
+    std::cout << "\nreproductions/s " << 1e9 / reproduction
+              << "\nexplosion children/s " << 1e9 / explosion
+              << "\nexplosion children/s (litters) " << 1e9 / litter
+              << "\nnew vehicles/s " << 1e9 / vehicle << "\nfood spawns/s "
+              << 1e9 / food << "\n";
+}
@@ -0,0 +1,111 @@
+// Baselines for the primitives every tick is made of: vector math, nearest
+// neighbour queries, DNA recombination, random draws and option checks.
+// Pass --json FILE to keep the results for comparing against a later run
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "bench.h"
+#include "dna.h"
+#include "optionset.h"
+#include "randomstream.h"
+#include "utils.h"
+#include "vec2d.h"
+#include "vehicle.h"
+#include "world.h"
+
+using namespace tom;
+
+static constexpr std::size_t ITERATIONS = 100'000;
+
+int main(int argc, char const* argv[])
+{
+    bench::Suite suite("core");
+
+    // everything random happens inside of some entity's stream during a tick
+    auto                stream = RandomStream::for_world(42, 0);
+    RandomStream::Scope scope(stream);
+
+    Vec2D const position{400.0, 300.0};
+    Vec2D const velocity{1.5, -2.0};
+    Vec2D const target{420.0, 310.0};
+    suite.run("Vec2D::limit", ITERATIONS, [&] {
+        Vec2D force = velocity * 3.0;
+        force.limit(0.45);
+        bench::keep(force);
+    });
+    suite.run("Vec2D::set_mag", ITERATIONS, [&] {
+        Vec2D force = velocity;
+        force.set_mag(2.0);
+        bench::keep(force);
+    });
+    suite.run("Vec2D::seek_force", ITERATIONS, [&] {
+        bench::keep(Vec2D::seek_force(target, position, velocity, 4.0));
+    });
+
+    // the serial tick searches the world's map, the tiled tick a tile's refs
+    for (std::size_t count : {10, 100, 1'000, 10'000}) {
+        World::Vehicles    vehicles;
+        World::VehicleRefs refs;
+        for (std::size_t i = 0; i < count; i++) {
+            Vehicle vehicle(Vec2D{random_in_range(0.0, 800.0),
+                                  random_in_range(0.0, 600.0)});
+            auto const id = vehicle.id;
+            vehicles.emplace(id, std::move(vehicle));
+        }
+        for (auto& [id, vehicle] : vehicles) {
+            refs.emplace_back(id, &vehicle);
+        }
+        Vehicle    seeker(position);
+        auto const iterations = std::max<std::size_t>(10, ITERATIONS / count);
+        double     distance   = 0.0;
+        suite.run("Vehicle::find_nearest map " + std::to_string(count),
+                  iterations, [&] {
+                      bench::keep(seeker.find_nearest(vehicles, distance));
+                  });
+        suite.run("Vehicle::find_nearest refs " + std::to_string(count),
+                  iterations, [&] {
+                      bench::keep(seeker.find_nearest(refs, distance));
+                  });
+    }
+
+    DNA const mom;
+    DNA const dad;
+    suite.run("DNA::crossover", ITERATIONS, [&] {
+        bench::keep(mom.crossover(dad));
+    });
+    suite.run("DNA::mutate", ITERATIONS, [&] {
+        DNA child = mom;
+        child.mutate();
+        bench::keep(child);
+    });
+
+    // the counter based streams the simulation draws from against the
+    // mt19937 it drew from before
+    suite.run("random_in_range (stream)", ITERATIONS * 10, [] {
+        bench::keep(random_in_range(0.0, 1.0));
+    });
+    std::mt19937                     generator(42);
+    std::uniform_real_distribution<> uniform(0.0, 1.0);
+    suite.run("random_in_range (mt19937)", ITERATIONS * 10, [&] {
+        bench::keep(uniform(generator));
+    });
+
+    OptionSet<World::ViewMode> modes(World::ViewMode::FOOD_SEEKING);
+    suite.run("OptionSet::contains (hit)", ITERATIONS * 10, [&] {
+        bench::keep(modes.contains(World::ViewMode::FOOD_SEEKING));
+    });
+    suite.run("OptionSet::contains (miss)", ITERATIONS * 10, [&] {
+        bench::keep(modes.contains(World::ViewMode::VEHICLE_SEEKING));
+    });
+
+    if (!suite.write_json(argc, argv)) {
+        std::cerr << "Could not write the JSON results\n";
+        return EXIT_FAILURE;
+    }
+}
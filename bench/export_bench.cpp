@@ -0,0 +1,106 @@
+// Bulk export through the C interface: copying out a whole population of
+// 100k vehicles again must take less than BUDGET_MS; exits with a failure if
+// any export does not. The first export after a step also lays the
+// population out, which is timed on its own
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "bench.h"
+#include "vehicles_c.h"
+
+using namespace tom;
+
+static constexpr int         VEHICLES   = 100'000;
+static constexpr std::size_t ITERATIONS = 200;
+static constexpr int         STEPS      = 10;
+static constexpr double      BUDGET_MS  = 1.0;
+
+int main()
+{
+    auto config     = vw_default_config();
+    config.seed     = 42;
+    config.width    = 20'000;
+    config.height   = 20'000;
+    config.vehicles = VEHICLES;
+    config.food     = VEHICLES;
+    config.max_food = VEHICLES;
+    config.workers  = 4;
+
+    vw_world* world = vw_create(&config);
+    if (world == nullptr) {
+        std::cerr << vw_last_error() << "\n";
+        return EXIT_FAILURE;
+    }
+    // a few (tiled) ticks so that the maps look like in a running world
+    vw_step(world, 3);
+
+    auto const vehicles = vw_export_positions(world, nullptr, 0);
+    auto const food     = vw_export_food_positions(world, nullptr, 0);
+    // room for the population growing over the steps at the end
+    std::vector<float>     xy(4 * std::max(vehicles, food));
+    std::vector<vw_traits> traits(2 * vehicles);
+
+    auto const positions = bench::ns_per_op(ITERATIONS, [&] {
+        bench::keep(vw_export_positions(world, xy.data(), vehicles));
+        bench::keep(xy[0]);
+    });
+    bench::report("vehicle positions (whole population)", positions);
+
+    auto const food_positions = bench::ns_per_op(ITERATIONS, [&] {
+        bench::keep(vw_export_food_positions(world, xy.data(), food));
+        bench::keep(xy[0]);
+    });
+    bench::report("food positions (whole population)", food_positions);
+
+    auto const all_traits = bench::ns_per_op(ITERATIONS, [&] {
+        bench::keep(vw_export_traits(world, traits.data(), vehicles));
+        bench::keep(traits[0]);
+    });
+    bench::report("vehicle traits (whole population)", all_traits);
+
+    // the first export of every kind after a step, and the step
+    using Clock = std::chrono::steady_clock;
+    double     first[3] = {};
+    double     step     = 0.0;
+    auto const ns       = [](Clock::time_point since) {
+        return std::chrono::duration<double, std::nano>(Clock::now() - since)
+            .count();
+    };
+    for (int i = 0; i < STEPS; i++) {
+        auto start = Clock::now();
+        bench::keep(vw_step(world, 1));
+        step += ns(start) / STEPS;
+        start = Clock::now();
+        bench::keep(vw_export_positions(world, xy.data(), xy.size() / 2));
+        first[0] += ns(start) / STEPS;
+        start = Clock::now();
+        bench::keep(
+            vw_export_food_positions(world, xy.data(), xy.size() / 2));
+        first[1] += ns(start) / STEPS;
+        start = Clock::now();
+        bench::keep(vw_export_traits(world, traits.data(), traits.size()));
+        first[2] += ns(start) / STEPS;
+    }
+    bench::report("step (one tick)", step);
+    bench::report("vehicle positions (first after a step)", first[0]);
+    bench::report("food positions (first after a step)", first[1]);
+    bench::report("vehicle traits (first after a step)", first[2]);
+
+    std::cout << "\n"
+              << vehicles << " vehicles, " << food << " food\n"
+              << "positions ms " << first[0] / 1e6 << " first, "
+              << positions / 1e6 << " again\nfood positions ms "
+              << first[1] / 1e6 << " first, " << food_positions / 1e6
+              << " again\ntraits ms " << first[2] / 1e6 << " first, "
+              << all_traits / 1e6 << " again\n";
+    vw_destroy(world);
+
+    if (std::max({positions, food_positions, all_traits}) / 1e6 > BUDGET_MS) {
+        std::cerr << "over the budget of " << BUDGET_MS << " ms\n";
+        return EXIT_FAILURE;
+    }
+}
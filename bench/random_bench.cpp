@@ -0,0 +1,64 @@
+// Cost of one random draw: the generators the simulation used before against
+// the counter based streams it uses now
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+
+#include "bench.h"
+#include "randomstream.h"
+
+using namespace tom;
+
+static constexpr std::size_t ITERATIONS = 20'000'000;
+
+int main()
+{
+    srand(42);
+    bench::report("rand() in range", bench::ns_per_op(ITERATIONS, [] {
+                      double const min = 0.0;
+                      double const max = 1.0;
+                      bench::keep(min + (rand() / (RAND_MAX / (max - min))));
+                  }));
+
+    std::mt19937 gen(42);
+    bench::report("mt19937 + uniform_real_distribution",
+                  bench::ns_per_op(ITERATIONS, [&] {
+                      std::uniform_real_distribution<> dis(0.0, 1.0);
+                      bench::keep(dis(gen));
+                  }));
+    bench::report("mt19937 + uniform_int_distribution",
+                  bench::ns_per_op(ITERATIONS, [&] {
+                      std::uniform_int_distribution<> dis(500, 1000);
+                      bench::keep(dis(gen));
+                  }));
+
+    auto stream = RandomStream::for_world(42, 0);
+    bench::report("Philox stream uniform(min, max)",
+                  bench::ns_per_op(ITERATIONS, [&] {
+                      bench::keep(stream.uniform(0.0, 1.0));
+                  }));
+    bench::report("Philox stream below(n)", bench::ns_per_op(ITERATIONS, [&] {
+                      bench::keep(stream.below(501));
+                  }));
+
+    std::array<double, 32> bulk;
+    bench::report("fill_uniform, xoshiro256+ x4 (per number)",
+                  bench::ns_per_op(ITERATIONS / bulk.size(), [&] {
+                      stream.fill_uniform(bulk);
+                      bench::keep(bulk);
+                  }) / bulk.size());
+
+    // what an entity pays per tick: a fresh stream and a handful of draws
+    std::uint32_t tick = 0;
+    bench::report("Philox fresh entity stream + 4 draws",
+                  bench::ns_per_op(ITERATIONS / 4, [&] {
+                      auto s = RandomStream::for_entity(
+                          42, RandomStream::Domain::VEHICLE, 7,
+                          RandomStream::Phase::BEHAVIOR, tick++);
+                      for (int i = 0; i < 4; i++) {
+                          bench::keep(s.uniform());
+                      }
+                  }));
+}
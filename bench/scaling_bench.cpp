@@ -0,0 +1,401 @@
+// How the cost of a tick grows with the population: worlds of 100 up to 1M
+// entities (half vehicles, half food) at the same density, ticked serially
+// and tiled. The serial tick compares every entity with every other one, so
+// its curve bends up to a slope of 2 on the log-log plot; the tiled one
+// should stay near 1.
+//
+//   scaling_bench [--max N] [--workers N] [--ticks N] [--budget MS]
+//                 [--scenario NAME] [--svg FILE]
+//
+// A mode stops growing once one of its ticks takes longer than the budget.
+// The worlds are uniform unless another scenario (see scenario.h) fills them.
+// Where Linux lets it read the hardware counters, it also shows what a tick
+// costs per entity in cycles, instructions and misses; where it does not,
+// it says why and leaves them out
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "perfcounters.h"
+#include "scenario.h"
+#include "utils.h"
+#include "world.h"
+
+using namespace tom;
+
+namespace {
+
+// the density of the default 800x600 world with 20 vehicles and 100 food
+constexpr double AREA_PER_ENTITY = 800.0 * 600.0 / 120.0;
+constexpr int    WARMUP_TICKS    = 2;
+
+struct Options {
+    std::size_t max_entities = 1'000'000;
+    unsigned    workers = std::max(1u, std::thread::hardware_concurrency());
+    int         ticks        = 10;
+    double      budget_ms    = 2'000.0;
+    std::string svg;
+
+    Scenario const* scenario = scenarios().data();
+};
+
+struct Sample {
+    std::size_t       entities;
+    unsigned          workers;
+    World::PhaseTimes phases;
+
+    double per_tick_ms(World::Duration World::PhaseTimes::*phase) const
+    {
+        return std::chrono::duration<double, std::milli>(phases.*phase)
+                   .count() /
+               phases.ticks;
+    }
+
+    // per entity and tick, over all phases of the tick
+    double per_entity(PerfCounters::Event event) const
+    {
+        std::uint64_t total = 0;
+        for (auto const& counted : phases.counted) {
+            total += counted[event];
+        }
+        return static_cast<double>(total) /
+               static_cast<double>(entities) / phases.ticks;
+    }
+
+    double total_ms() const
+    {
+        return per_tick_ms(&World::PhaseTimes::events) +
+               per_tick_ms(&World::PhaseTimes::prune) +
+               per_tick_ms(&World::PhaseTimes::index) +
+               per_tick_ms(&World::PhaseTimes::food) +
+               per_tick_ms(&World::PhaseTimes::vehicles);
+    }
+};
+
+Options parse(int argc, char const* argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string_view const arg(argv[i]);
+        if (i + 1 == argc) {
+            throw std::runtime_error("Missing value for " + std::string(arg));
+        }
+        std::string const value(argv[++i]);
+        if (arg == "--max") {
+            options.max_entities = std::stoul(value);
+        } else if (arg == "--workers") {
+            options.workers = static_cast<unsigned>(std::stoul(value));
+        } else if (arg == "--ticks") {
+            options.ticks = std::max(1, std::stoi(value));
+        } else if (arg == "--budget") {
+            options.budget_ms = std::stod(value);
+        } else if (arg == "--scenario") {
+            options.scenario = &find_scenario(value);
+        } else if (arg == "--svg") {
+            options.svg = value;
+        } else {
+            throw std::runtime_error("Unknown option " + std::string(arg));
+        }
+    }
+    if (options.workers == 0) {
+        throw std::runtime_error("--workers must be positive, the serial "
+                                 "tick is always measured");
+    }
+    return options;
+}
+
+// 100, 300, 1k, 3k, ... up to max
+std::vector<std::size_t> sizes(std::size_t max)
+{
+    std::vector<std::size_t> result;
+    for (std::size_t decade = 100; decade <= max; decade *= 10) {
+        result.push_back(decade);
+        if (decade * 3 <= max) {
+            result.push_back(decade * 3);
+        }
+    }
+    return result;
+}
+
+Sample measure(std::size_t         entities,
+               unsigned            workers,
+               Options const&      options,
+               PerfCounters const& counters)
+{
+    auto const vehicles = static_cast<int>(entities / 2);
+    auto const food     = static_cast<int>(entities - entities / 2);
+    auto const side     = static_cast<int>(
+        std::sqrt(static_cast<double>(entities) * AREA_PER_ENTITY));
+
+    set_seed(42);
+    World world(42, side, side);
+    world.max_food = static_cast<unsigned>(food);
+    options.scenario->populate(world, vehicles, food);
+    world.enable_workers(workers);
+
+    for (int i = 0; i < WARMUP_TICKS; i++) {
+        world.tick();
+    }
+
+    // stop early rather than spend minutes on the last size of a mode
+    Sample sample{.entities = entities, .workers = workers, .phases = {}};
+    if (counters.available()) {
+        sample.phases.counters = &counters;
+    }
+    world.phase_times = &sample.phases;
+    auto const start  = World::Clock::now();
+    while (sample.phases.ticks < options.ticks) {
+        world.tick();
+        std::chrono::duration<double, std::milli> const elapsed =
+            World::Clock::now() - start;
+        if (elapsed.count() > options.budget_ms) {
+            break;
+        }
+    }
+    world.phase_times = nullptr;
+    return sample;
+}
+
+std::string mode(Sample const& sample)
+{
+    return sample.workers ? "tiled/" + std::to_string(sample.workers)
+                          : "serial";
+}
+
+void print_table(std::vector<Sample> const& samples)
+{
+    std::cout << std::setw(9) << "entities" << std::setw(10) << "mode"
+              << std::setw(12) << "ms/tick" << std::setw(10) << "events"
+              << std::setw(10) << "prune" << std::setw(10) << "index"
+              << std::setw(10) << "food" << std::setw(10) << "vehicles"
+              << "\n";
+    std::cout << std::fixed << std::setprecision(3);
+    for (auto const& sample : samples) {
+        using P = World::PhaseTimes;
+        std::cout << std::setw(9) << sample.entities << std::setw(10)
+                  << mode(sample) << std::setw(12) << sample.total_ms()
+                  << std::setw(10) << sample.per_tick_ms(&P::events)
+                  << std::setw(10) << sample.per_tick_ms(&P::prune)
+                  << std::setw(10) << sample.per_tick_ms(&P::index)
+                  << std::setw(10) << sample.per_tick_ms(&P::food)
+                  << std::setw(10) << sample.per_tick_ms(&P::vehicles)
+                  << "\n";
+    }
+}
+
+// "-" for the counters that could not be opened
+void print_counters(std::vector<Sample> const& samples,
+                    PerfCounters const&        counters)
+{
+    using E = PerfCounters::Event;
+    std::cout << "\nper entity and tick\n"
+              << std::setw(9) << "entities" << std::setw(10) << "mode"
+              << std::setw(12) << "cycles" << std::setw(14) << "instructions"
+              << std::setw(8) << "IPC" << std::setw(12) << "L1D misses"
+              << std::setw(12) << "LLC misses" << std::setw(15)
+              << "branch misses" << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+    for (auto const& sample : samples) {
+        auto const column = [&](E event, int width) {
+            std::cout << std::setw(width);
+            if (counters.has(event)) {
+                std::cout << sample.per_entity(event);
+            } else {
+                std::cout << "-";
+            }
+        };
+        std::cout << std::setw(9) << sample.entities << std::setw(10)
+                  << mode(sample);
+        column(E::CYCLES, 12);
+        column(E::INSTRUCTIONS, 14);
+        std::cout << std::setw(8);
+        if (counters.has(E::CYCLES) && counters.has(E::INSTRUCTIONS)) {
+            std::cout << sample.per_entity(E::INSTRUCTIONS) /
+                             sample.per_entity(E::CYCLES);
+        } else {
+            std::cout << "-";
+        }
+        column(E::L1D_MISSES, 12);
+        column(E::LLC_MISSES, 12);
+        column(E::BRANCH_MISSES, 15);
+        std::cout << "\n";
+    }
+}
+
+// log10 of the extents of the samples, at least a decade on each axis
+struct Bounds {
+    double min_x, max_x, min_y, max_y;
+
+    explicit Bounds(std::vector<Sample> const& samples)
+        : min_x(1e300), max_x(-1e300), min_y(1e300), max_y(-1e300)
+    {
+        for (auto const& sample : samples) {
+            auto const x = std::log10(static_cast<double>(sample.entities));
+            auto const y = std::log10(std::max(sample.total_ms(), 1e-4));
+            min_x        = std::min(min_x, x);
+            max_x        = std::max(max_x, x);
+            min_y        = std::min(min_y, y);
+            max_y        = std::max(max_y, y);
+        }
+        max_x = std::max(max_x, min_x + 1.0);
+        max_y = std::max(max_y, min_y + 1.0);
+    }
+
+    double x(Sample const& sample) const
+    {
+        return (std::log10(static_cast<double>(sample.entities)) - min_x) /
+               (max_x - min_x);
+    }
+
+    double y(Sample const& sample) const
+    {
+        return (std::log10(std::max(sample.total_ms(), 1e-4)) - min_y) /
+               (max_y - min_y);
+    }
+};
+
+void print_plot(std::vector<Sample> const& samples)
+{
+    constexpr int WIDTH  = 60;
+    constexpr int HEIGHT = 20;
+
+    Bounds const             bounds(samples);
+    std::vector<std::string> grid(HEIGHT + 1, std::string(WIDTH + 1, ' '));
+    for (auto const& sample : samples) {
+        auto const column = static_cast<int>(std::lround(bounds.x(sample) *
+                                                         WIDTH));
+        auto const row    = HEIGHT - static_cast<int>(std::lround(
+                                      bounds.y(sample) * HEIGHT));
+        grid[row][column] = sample.workers ? 'o' : '*';
+    }
+
+    std::cout << "\nms per tick (log) against entities (log), * serial, "
+                 "o tiled\n";
+    std::cout << std::scientific << std::setprecision(1);
+    for (int row = 0; row <= HEIGHT; row++) {
+        if (row == 0 || row == HEIGHT) {
+            auto const y = row == 0 ? bounds.max_y : bounds.min_y;
+            std::cout << std::setw(9) << std::pow(10.0, y) << " |";
+        } else {
+            std::cout << std::setw(11) << "|";
+        }
+        std::cout << grid[row] << "\n";
+    }
+    std::cout << std::setw(11) << "+" << std::string(WIDTH + 1, '-') << "\n"
+              << std::setw(12) << std::pow(10.0, bounds.min_x)
+              << std::setw(WIDTH) << std::pow(10.0, bounds.max_x) << "\n";
+}
+
+void write_svg(std::vector<Sample> const& samples, std::string const& path)
+{
+    constexpr double WIDTH  = 640.0;
+    constexpr double HEIGHT = 400.0;
+    constexpr double MARGIN = 50.0;
+
+    std::ofstream out(path);
+    Bounds const  bounds(samples);
+    auto const    x = [&](Sample const& sample) {
+        return MARGIN + bounds.x(sample) * (WIDTH - 2 * MARGIN);
+    };
+    auto const y = [&](Sample const& sample) {
+        return HEIGHT - MARGIN - bounds.y(sample) * (HEIGHT - 2 * MARGIN);
+    };
+
+    out << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << WIDTH
+        << "\" height=\"" << HEIGHT << "\" font-family=\"sans-serif\" "
+        << "font-size=\"12\">\n"
+        << "<rect width=\"100%\" height=\"100%\" fill=\"white\"/>\n"
+        << "<path d=\"M" << MARGIN << " " << MARGIN << "V"
+        << HEIGHT - MARGIN << "H" << WIDTH - MARGIN
+        << "\" fill=\"none\" stroke=\"black\"/>\n"
+        << "<text x=\"" << WIDTH / 2 << "\" y=\"" << HEIGHT - 10
+        << "\" text-anchor=\"middle\">entities (log)</text>\n"
+        << "<text x=\"12\" y=\"" << HEIGHT / 2 << "\" transform=\"rotate(-90 "
+        << "12 " << HEIGHT / 2
+        << ")\" text-anchor=\"middle\">ms per tick (log)</text>\n";
+
+    // one line per mode, in the order they were measured
+    std::vector<std::string> const colours{"#d62728", "#1f77b4"};
+    for (unsigned pass = 0; pass < 2; pass++) {
+        std::string points;
+        std::string label;
+        for (auto const& sample : samples) {
+            if ((sample.workers != 0) != (pass == 1)) {
+                continue;
+            }
+            points += std::to_string(x(sample)) + "," +
+                      std::to_string(y(sample)) + " ";
+            label = mode(sample);
+            out << "<circle cx=\"" << x(sample) << "\" cy=\"" << y(sample)
+                << "\" r=\"3\" fill=\"" << colours[pass] << "\"><title>"
+                << sample.entities << " entities, " << sample.total_ms()
+                << " ms</title></circle>\n";
+        }
+        out << "<polyline points=\"" << points << "\" fill=\"none\" stroke=\""
+            << colours[pass] << "\"/>\n"
+            << "<text x=\"" << MARGIN + 10 << "\" y=\""
+            << MARGIN + 15 * pass << "\" fill=\"" << colours[pass] << "\">"
+            << label << "</text>\n";
+    }
+    out << "</svg>\n";
+    if (!out) {
+        throw std::runtime_error("Could not write " + path);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char const* argv[])
+{
+    try {
+        auto const options = parse(argc, argv);
+        // before any world starts its workers, so that they are counted too
+        PerfCounters const counters;
+        if (!counters.error().empty()) {
+            std::cerr << "hardware counters "
+                      << (counters.available() ? "incomplete: "
+                                               : "unavailable: ")
+                      << counters.error() << "\n";
+        }
+
+        // the serial tick first, then the same sizes tiled
+        std::cout << "scenario " << options.scenario->name << ": "
+                  << options.scenario->description << "\n\n";
+        std::vector<Sample> samples;
+        for (unsigned workers : {0u, options.workers}) {
+            for (std::size_t entities : sizes(options.max_entities)) {
+                auto const& sample =
+                    samples.emplace_back(
+                    measure(entities, workers, options, counters));
+                std::cerr << entities << " entities " << mode(sample) << ": "
+                          << sample.total_ms() << " ms per tick\n";
+                if (sample.total_ms() > options.budget_ms) {
+                    break;
+                }
+            }
+        }
+
+        print_table(samples);
+        if (counters.available()) {
+            print_counters(samples, counters);
+        }
+        print_plot(samples);
+        if (!options.svg.empty()) {
+            write_svg(samples, options.svg);
+        }
+    } catch (std::exception const& e) {
+        std::cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+}
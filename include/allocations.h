@@ -0,0 +1,38 @@
+#ifndef ALLOCATIONS_H
+#define ALLOCATIONS_H
+
+#include <cstdint>
+
+namespace tom {
+
+/**
+ * Heap allocations made through operator new, by every thread of the
+ * process. They are only counted in builds with COUNT_ALLOCATIONS, which
+ * replaces the global operator new and delete; otherwise they stay 0
+ */
+struct AllocationCounts {
+#ifdef COUNT_ALLOCATIONS
+    static constexpr bool ENABLED = true;
+#else
+    static constexpr bool ENABLED = false;
+#endif
+
+    std::uint64_t allocations = 0;
+    std::uint64_t bytes       = 0;
+
+    /**
+     * Everything allocated since the program started
+     */
+    [[nodiscard]]
+    static AllocationCounts so_far() noexcept;
+
+    AllocationCounts operator-(AllocationCounts const& earlier) const noexcept
+    {
+        return {.allocations = allocations - earlier.allocations,
+                .bytes       = bytes - earlier.bytes};
+    }
+};
+
+}  // namespace tom
+
+#endif  // ALLOCATIONS_H
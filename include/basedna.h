@@ -3,6 +3,17 @@
 
 namespace tom {
 
+/**
+ * Tag for constructors that leave an object's state to be filled in by the
+ * caller. Used when entities are rebuilt from records so that no random
+ * numbers are drawn and no ids are allocated.
+ */
+struct RestoreTag {
+    explicit RestoreTag() = default;
+};
+
+inline constexpr RestoreTag restore_tag{};
+
 template <typename Self>
 struct BaseDNA {
     virtual ~BaseDNA() = default;
@@ -0,0 +1,76 @@
+#ifndef CHECKPOINTER_H
+#define CHECKPOINTER_H
+
+#include <sys/types.h>
+#include <chrono>
+#include <optional>
+#include <string>
+
+namespace tom {
+
+struct World;
+
+/**
+ * Periodic snapshots of a running world (see Snapshot) that do not hold up
+ * the simulation. When a checkpoint is due the process forks, and the child
+ * writes the world as it was at that moment from its copy-on-write view of
+ * memory while the parent goes on ticking. Only the pages the parent changes
+ * in the meantime are ever copied.
+ *
+ * Checkpoints are named after their tick and only appear in the directory
+ * once they are complete, so a crash at any moment leaves the last good one
+ * behind. Only the newest `keep` are kept.
+ */
+class Checkpointer {
+   public:
+    struct Config {
+        std::string directory;
+        int         every_ticks   = 0;    // 0 to not count ticks
+        double      every_seconds = 0.0;  // 0 to not look at the clock
+        int         keep          = 3;
+    };
+
+    explicit Checkpointer(Config config);
+
+    Checkpointer(Checkpointer const&)            = delete;
+    Checkpointer& operator=(Checkpointer const&) = delete;
+
+    /**
+     * Waits for a checkpoint that is still being written
+     */
+    ~Checkpointer();
+
+    /**
+     * Call between ticks. Starts writing a checkpoint if one is due and the
+     * previous one is done
+     */
+    void between_ticks(World& world);
+
+    /**
+     * The newest complete checkpoint in directory, if there is any
+     */
+    [[nodiscard]]
+    static std::optional<std::string> latest(std::string const& directory);
+
+   private:
+    using Clock = std::chrono::steady_clock;
+
+    [[nodiscard]]
+    bool is_due(World const& world) const;
+
+    // true once no writer is running anymore. Reports a writer that failed
+    bool reap(bool block);
+
+    void write(World& world) const;
+
+    void rotate() const;
+
+    Config            config;
+    pid_t             writer    = -1;
+    int               last_tick = -1;  // not started yet
+    Clock::time_point last_time = Clock::now();
+};
+
+}  // namespace tom
+
+#endif  // CHECKPOINTER_H
@@ -0,0 +1,120 @@
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace tom {
+
+struct World;
+
+/**
+ * Something a person does to a running world: a click in the drawing area,
+ * a control window button, a console menu entry. Everything that changes the
+ * simulation from the outside goes through World::issue() as a Command so
+ * that a run can be recorded and replayed exactly (see CommandLog). Things
+ * that only change how the world is shown (pausing, sprinting, view modes)
+ * are not commands.
+ */
+struct Command {
+    enum struct Kind : std::uint32_t {
+        KILL,             // vehicles within `value` of (x, y) die
+        FEED,             // `value` pieces of food around (x, y)
+        SELECT,           // toggle verbose on the vehicle nearest (x, y)
+        CLEAR_SELECTION,  // no vehicle is verbose
+        ADD_VEHICLES,     // `value` vehicles at random places
+        ADD_FOOD,         // `value` pieces of random food
+        SET_FOOD_CHANCE,  // World::food_pct_chance = value
+        SET_MAX_FOOD,     // World::max_food = value
+        SET_TARGET_TPS,   // World::target_tps = value
+        TOGGLE_NIGHT,     // World::disable_night = !disable_night
+        END               // the run ended; written last
+    };
+
+    // set by World::issue(): the number of ticks done when it happened
+    std::uint32_t tick = 0;
+    Kind          kind;
+    double        x     = 0.0;
+    double        y     = 0.0;
+    double        value = 0.0;
+};
+
+static_assert(std::is_trivially_copyable_v<Command>);
+static_assert(sizeof(Command) == 32);
+
+/**
+ * A binary file with everything needed to run the same simulation again: the
+ * arguments the world was created with followed by every command issued to
+ * it, in order. Replaying draws the same random numbers as the recorded run
+ * (see RandomStream) so it ends in the same state
+ */
+class CommandLog {
+   public:
+    struct Header {
+        char          magic[4] = {'V', 'C', 'M', 'D'};
+        std::uint32_t version  = VERSION;
+        std::int64_t  seed;
+        std::int32_t  width;
+        std::int32_t  height;
+        std::int32_t  vehicles;
+        std::int32_t  food;
+        std::uint32_t max_food;
+        std::uint32_t workers;
+        double        food_pct_chance;
+        double        edge_threshold;
+        double        poison_chance;
+        double        max_force;
+        double        max_health;
+        std::int32_t  target_tps;
+        std::uint32_t disable_night;
+        std::uint32_t scenario;  // what populated the world, see scenarios()
+    };
+
+    struct Recording {
+        Header               header;
+        std::vector<Command> commands;
+
+        /**
+         * The tick at which the recorded run ended. A log without an END
+         * command (the program crashed) ends with its last command
+         */
+        [[nodiscard]]
+        std::uint32_t end_tick() const noexcept;
+    };
+
+    /**
+     * Start a new log at path, replacing any file that is there
+     */
+    CommandLog(std::string const& path, Header const& header);
+
+    CommandLog(CommandLog const&)            = delete;
+    CommandLog& operator=(CommandLog const&) = delete;
+
+    /**
+     * Write one command. Commands come from people and are rare, so every
+     * one goes to disk immediately and a crash loses nothing
+     */
+    void append(Command const& command);
+
+    static Recording load(std::string const& path);
+
+   private:
+    static constexpr std::uint32_t VERSION = 3;
+
+    std::ofstream out;
+};
+
+/**
+ * Run a recording without any renderer and as fast as possible: every
+ * command is issued before the tick it was recorded before, until the tick
+ * at which the recording ended. The world must have been created from the
+ * recording's header
+ */
+void replay(World& world, CommandLog::Recording const& recording);
+
+}  // namespace tom
+
+#endif  // COMMAND_H
@@ -0,0 +1,46 @@
+#ifndef COUNTDOWN_H
+#define COUNTDOWN_H
+
+#include <cstdint>
+
+namespace tom {
+
+/**
+ * A rare event that has the same small chance to happen on every trial
+ * (every tick, every vehicle that food sees...).
+ *
+ * Instead of drawing a random number per trial, the number of trials until
+ * the event happens is drawn once from the geometric distribution and
+ * counted down, which has exactly the same statistics. Because the
+ * distribution is memoryless the countdown can simply be drawn again
+ * whenever the probability changes.
+ *
+ * Plain data so that entity records can store it as is
+ */
+struct Countdown {
+    double        probability = -1.0;  // what remaining was drawn for
+    std::uint32_t remaining   = 0;
+
+    /**
+     * One trial of an event with the given probability. True when the event
+     * happens; the next countdown is drawn on the next trial
+     */
+    bool trial(double p) noexcept
+    {
+        if (p != probability || remaining == 0) {
+            probability = p;
+            remaining   = trials_until_event(p);
+        }
+        return --remaining == 0;
+    }
+
+    /**
+     * Geometric sample: the number of trials up to and including the first
+     * success, drawn from the random stream bound to the calling thread
+     */
+    static std::uint32_t trials_until_event(double p) noexcept;
+};
+
+}  // namespace tom
+
+#endif  // COUNTDOWN_H
@@ -1,6 +1,8 @@
 #ifndef DNA_H
 #define DNA_H
 
+#include <cstddef>
+#include <span>
 #include "basedna.h"
 namespace tom {
 
@@ -21,11 +23,24 @@ struct DNA : public BaseDNA<DNA> {
     int    age_of_maturity;
     double edge_repulsion;
 
+    // uniforms consumed by a new random DNA and by one mutation, for drawing
+    // them in bulk when many vehicles are born at once
+    static constexpr std::size_t GENE_DRAWS     = 14;
+    static constexpr std::size_t MUTATION_DRAWS = 2 * GENE_DRAWS;
+
+    using GeneDraws     = std::span<double const, GENE_DRAWS>;
+    using MutationDraws = std::span<double const, MUTATION_DRAWS>;
+
     DNA() noexcept;
 
+    explicit DNA(GeneDraws uniforms) noexcept;
+
+    explicit DNA(RestoreTag) noexcept;
+
     [[nodiscard]]
     DNA  crossover(DNA const& partner) const noexcept;
     void mutate() noexcept;
+    void mutate(MutationDraws uniforms) noexcept;
 };
 
 }  // namespace tom
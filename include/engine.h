@@ -0,0 +1,136 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+#include "entityrecord.h"
+
+namespace tom {
+
+struct World;
+
+/**
+ * The simulation without any UI, for programs that embed it: make a world,
+ * step it as many ticks at a time as they like, and look at the entities and
+ * counters in between. Everything here is part of the vehicles_core library,
+ * which has no FLTK or console code in it and installs no signal handlers;
+ * what the simulation has to say goes to the sink of set_log_sink() (see
+ * log.h).
+ *
+ * Entities are handed out as the flat records of entityrecord.h, which stay
+ * the same when the classes behind them change. Some settings (the edge
+ * threshold, poison chance, max force and max health) are process globals
+ * in the simulation, so every Engine of a process shares the values of the
+ * one created (or loaded) last.
+ */
+class Engine {
+   public:
+    struct Config {
+        long         seed            = 0;
+        int          width           = 800;
+        int          height          = 600;
+        int          vehicles        = 20;
+        int          food            = 100;
+        unsigned int max_food        = 750;
+        double       food_pct_chance = 35.0;
+        double       edge_threshold  = 20.0;
+        double       poison_chance   = 0.1;
+        double       max_force       = 0.45;
+        double       max_health      = 45.0;
+        bool         disable_night   = false;
+        unsigned     workers         = 0;  // threads per tick, 0 for none
+    };
+
+    struct Stats {
+        int         tick;
+        std::size_t vehicles;
+        std::size_t food;
+        int         births;
+        int         deaths;
+        int         max_age;
+        bool        day;
+    };
+
+    /**
+     * Called from inside step(). born sees a vehicle before its first tick,
+     * died one in the state it died in, and ticked the stats after every
+     * tick. The records are only valid during the call
+     */
+    struct Hooks {
+        std::function<void(VehicleRecord const&)> born;
+        std::function<void(VehicleRecord const&)> died;
+        std::function<void(Stats const&)>         ticked;
+    };
+
+    /**
+     * A new world populated as config says
+     */
+    explicit Engine(Config const& config);
+
+    /**
+     * Continue the world saved in the snapshot at path (see Snapshot).
+     * Throws std::runtime_error if it cannot be read
+     */
+    [[nodiscard]]
+    static Engine load(std::string const& path, unsigned workers = 0);
+
+    Engine(Engine&&) noexcept;
+    Engine& operator=(Engine&&) noexcept;
+    ~Engine();
+
+    /**
+     * Tick up to `ticks` times; fewer if every vehicle dies. Returns the
+     * number of ticks run
+     */
+    int step(int ticks = 1);
+
+    [[nodiscard]]
+    Stats stats() const noexcept;
+
+    /**
+     * Every vehicle (food) as it is now, in no particular order. The span
+     * stays valid until the next call of step() or of the same function
+     */
+    [[nodiscard]]
+    std::span<VehicleRecord const> vehicles();
+
+    [[nodiscard]]
+    std::span<FoodRecord const> food();
+
+    void set_hooks(Hooks hooks);
+
+    /**
+     * Write the world to path (see Snapshot::save)
+     */
+    void save(std::string const& path);
+
+    /**
+     * The world itself, for whatever this class does not offer. Unlike the
+     * rest of the class it changes along with the simulation
+     */
+    [[nodiscard]]
+    World& world() noexcept;
+
+    [[nodiscard]]
+    World const& world() const noexcept;
+
+   private:
+    explicit Engine(std::unique_ptr<World> world);
+
+    void connect_hooks();
+
+    // on the heap so that entities and the world's hooks can keep pointing
+    // at them when the engine is moved
+    std::unique_ptr<World>     state;
+    std::unique_ptr<Hooks>     hooks = std::make_unique<Hooks>();
+    std::vector<VehicleRecord> vehicle_records;
+    std::vector<FoodRecord>    food_records;
+};
+
+}  // namespace tom
+
+#endif  // ENGINE_H
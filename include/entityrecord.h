@@ -0,0 +1,133 @@
+#ifndef ENTITYRECORD_H
+#define ENTITYRECORD_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include "countdown.h"
+#include "dna.h"
+#include "fooddna.h"
+#include "vec2d.h"
+#include "world.h"
+
+namespace tom {
+
+class Vehicle;
+struct Food;
+
+/**
+ * Flat, trivially copyable images of the simulation entities.
+ *
+ * Vehicle and Food carry vtables (through DNA and Lifespan) and an OptionSet,
+ * so they cannot be copied byte-wise into shared memory or a file. A record
+ * holds the same state as plain fields; capture() builds one from a live
+ * entity and restore() turns it back into one without drawing any random
+ * numbers or allocating a new id.
+ */
+struct DNARecord {
+    double       perception_radius;
+    double       max_speed;
+    double       mutation_rate;
+    double       reproduction_cost;
+    double       malice_desire;
+    double       altruism_desire;
+    double       malice_probability;
+    double       altruism_probability;
+    double       malice_damage;
+    double       altruism_heal;
+    double       explosion_chance;
+    double       explosion_tries;
+    std::int32_t reproduction_cooldown;
+    std::int32_t age_of_maturity;
+    double       edge_repulsion;
+
+    static constexpr std::size_t GENES = 15;
+
+    // the fields above, in their order
+    static constexpr std::array<std::string_view, GENES> GENE_NAMES = {
+        "perception_radius",     "max_speed",        "mutation_rate",
+        "reproduction_cost",     "malice_desire",    "altruism_desire",
+        "malice_probability",    "altruism_probability", "malice_damage",
+        "altruism_heal",         "explosion_chance", "explosion_tries",
+        "reproduction_cooldown", "age_of_maturity",  "edge_repulsion",
+    };
+
+    static DNARecord capture(DNA const& dna) noexcept;
+
+    [[nodiscard]]
+    DNA restore() const noexcept;
+
+    /**
+     * The fields as numbers, in the order of GENE_NAMES
+     */
+    [[nodiscard]]
+    std::array<double, GENES> genes() const noexcept;
+};
+
+struct FoodDNARecord {
+    double nutrition;
+    double lifeticks;
+    double speed;
+    double explosionChance;
+    double explosionCount;
+    double mutationRate;
+    double perceptionRadius;
+    double fleeChance;
+    double fleeStrength;
+
+    static FoodDNARecord capture(FoodDNA const& dna) noexcept;
+
+    [[nodiscard]]
+    FoodDNA restore() const noexcept;
+};
+
+struct VehicleRecord {
+    std::uint64_t id;
+    std::uint64_t last_sought_vehicle_id;
+    std::uint64_t last_sought_food_id;
+    Vec2D         position;
+    Vec2D         velocity;
+    Vec2D         acceleration;
+    Vec2D         wander_target;
+    double        health;
+    double        mass;
+    std::int32_t  age;
+    std::int32_t  time_since_last_reproduction;
+    std::int32_t  generation;
+    std::uint32_t behavior_state;  // bitwise or of Vehicle::BehaviorState
+    std::uint32_t verbose;
+    Countdown     explosion_countdown;
+    DNARecord     dna;
+
+    static VehicleRecord capture(Vehicle const& vehicle) noexcept;
+
+    [[nodiscard]]
+    Vehicle restore(World* world) const;
+};
+
+struct FoodRecord {
+    std::uint64_t id;
+    Vec2D         position;
+    Vec2D         velocity;
+    Vec2D         acceleration;
+    double        velocity_dampening;
+    std::int32_t  lifespan;
+    Countdown     flee_countdown;
+    Countdown     spawn_countdown;
+    Countdown     explosion_countdown;
+    FoodDNARecord dna;
+
+    static FoodRecord capture(Food const& food) noexcept;
+
+    [[nodiscard]]
+    Food restore(World* world) const;
+};
+
+static_assert(std::is_trivially_copyable_v<VehicleRecord>);
+static_assert(std::is_trivially_copyable_v<FoodRecord>);
+
+}  // namespace tom
+
+#endif  // ENTITYRECORD_H
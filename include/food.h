@@ -1,6 +1,9 @@
 #ifndef FOOD_H
 #define FOOD_H
 
+#include <cstddef>
+#include <span>
+#include "countdown.h"
 #include "fooddna.h"
 #include "lifespan.h"
 #include "utils.h"
@@ -21,6 +24,8 @@ struct Environmental {
     Vec2D            velocity{};
     Vec2D            acceleration{};
     Lifespan<int, 1> lifespan;
+    // see Vehicle::ghost
+    bool ghost = false;
 
     template <typename T, T tick_amt>
     Environmental(World*                       world,
@@ -47,13 +52,33 @@ struct Environmental {
         return ++global_id_counter;
     }
 
+    /**
+     * See Vehicle::set_id_base
+     */
+    static void set_id_base(IdType base) noexcept
+    {
+        global_id_counter = base;
+    }
+
+    /**
+     * See Vehicle::id_base
+     */
+    [[nodiscard]]
+    static IdType id_base() noexcept
+    {
+        return global_id_counter;
+    }
+
+   protected:
+    explicit Environmental(RestoreTag) noexcept;
+
    private:
     static IdType global_id_counter;
 };
 
 struct Food : Environmental {
     using IdType = World::FoodIdType;
-    double velocity_dampening;
+    double velocity_dampening = 0.0;
 
     FoodDNA dna{};
 
@@ -85,6 +110,8 @@ struct Food : Environmental {
 
     void behaviors(World::Vehicles const& vehicles);
 
+    void behaviors(World::VehicleRefs const& vehicles);
+
     void perform_explosion(World* world) const;
 
     void perform_spawn(World* world) const;
@@ -97,8 +124,25 @@ struct Food : Environmental {
     }
 
    private:
+    // uniforms for one spawned food: its mutation and the chance (and
+    // strength) of turning poisonous
+    static constexpr std::size_t SPAWN_DRAWS = FoodDNA::MUTATION_DRAWS + 2;
+
+    using SpawnDraws = std::span<double const, SPAWN_DRAWS>;
+
+    void spawn(World* world, SpawnDraws uniforms) const;
+
+    explicit Food(RestoreTag) noexcept;
+
     Vec2D         velocity = Vec2D::random(0.25);
     static IdType global_id_counter;
+
+    // rare events, see Countdown
+    Countdown flee_countdown;
+    Countdown spawn_countdown;
+    Countdown explosion_countdown;
+
+    friend struct FoodRecord;
 };
 
 }  // namespace tom
@@ -1,6 +1,8 @@
 #ifndef FOODDNA_H
 #define FOODDNA_H
 
+#include <cstddef>
+#include <span>
 #include "basedna.h"
 
 namespace tom {
@@ -15,11 +17,23 @@ struct FoodDNA : public BaseDNA<FoodDNA> {
     double fleeChance;
     double fleeStrength;
 
+    // uniforms consumed by a new random FoodDNA and by one mutation
+    static constexpr std::size_t GENE_DRAWS     = 5;
+    static constexpr std::size_t MUTATION_DRAWS = 16;
+
+    using GeneDraws     = std::span<double const, GENE_DRAWS>;
+    using MutationDraws = std::span<double const, MUTATION_DRAWS>;
+
     FoodDNA();
 
+    explicit FoodDNA(GeneDraws uniforms) noexcept;
+
+    explicit FoodDNA(RestoreTag) noexcept;
+
     [[nodiscard]]
     virtual FoodDNA crossover(FoodDNA const& partner) const noexcept;
     virtual void    mutate() noexcept;
+    void            mutate(MutationDraws uniforms) noexcept;
 };
 }  // namespace tom
 
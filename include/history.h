@@ -0,0 +1,159 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_set>
+#include <vector>
+#include "command.h"
+#include "vec2d.h"
+
+namespace tom {
+
+struct World;
+class Vehicle;
+struct Food;
+
+/**
+ * The recent past of a world, kept so that the viewer can step back to an
+ * interesting moment (see the rewind slider of ControlWindow).
+ *
+ * Every `keyframe_ticks` ticks the whole world is kept as an in-memory
+ * Snapshot. Every tick in between only keeps a Frame: which entities were
+ * born, which died and how far the others moved, with positions quantized
+ * to a few bits. Frames are enough to draw the past; going back to a tick
+ * for real restores the keyframe before it and simulates forward from
+ * there, issuing the same commands again, which reaches exactly the state
+ * the world was in.
+ *
+ * The oldest keyframes (and their frames) are dropped once everything
+ * together takes more than `memory_budget` bytes.
+ */
+class History {
+   public:
+    struct Config {
+        int         keyframe_ticks = 100;
+        std::size_t memory_budget  = std::size_t{256} << 20;
+    };
+
+    /**
+     * What is drawn of an entity at some tick in the past
+     */
+    struct Sprite {
+        std::uint64_t id;
+        std::uint16_t x;        // in steps, see position_of()
+        std::uint16_t y;
+        std::uint8_t  heading;  // in 256ths of a turn
+        std::uint8_t  size;     // in pixels, at most MAX_SIZE
+        std::uint8_t  look;     // Vehicle::BehaviorState bits, or 1 for poison
+        bool          vehicle;
+    };
+
+    static constexpr std::uint8_t MAX_SIZE = 15;
+
+    History(World const& world, Config config);
+
+    /**
+     * Call between ticks; keeps whatever happened since the last call. A
+     * gap (ticks done behind the history's back) starts a new keyframe
+     */
+    void record(World& world);
+
+    /**
+     * Called by World::issue() so that rewinding can issue it again
+     */
+    void record(Command const& command);
+
+    [[nodiscard]]
+    int first_tick() const noexcept;
+
+    [[nodiscard]]
+    int last_tick() const noexcept;
+
+    /**
+     * Everything there was at tick, which must be between first_tick() and
+     * last_tick()
+     */
+    [[nodiscard]]
+    std::vector<Sprite> view(int tick) const;
+
+    [[nodiscard]]
+    Vec2D position_of(Sprite const& sprite) const noexcept;
+
+    [[nodiscard]]
+    std::size_t memory_use() const noexcept;
+
+    /**
+     * Put world back into the state it was in right after tick. Whatever
+     * was kept after that tick is forgotten; it is recorded again as the
+     * world goes on
+     */
+    void rewind(World& world, int tick);
+
+   private:
+    // a sprite that is still there, changed by at most a byte per field
+    struct Move {
+        std::uint32_t index;  // into the sprites after deaths and births
+        std::int8_t   dx;
+        std::int8_t   dy;
+        std::uint8_t  heading;
+        std::uint8_t  look_and_size;  // look << 4 | size
+    };
+
+    /**
+     * From one tick to the next: the sprites at the indices in deaths go
+     * away, births are added at the end, then moves are applied
+     */
+    struct Frame {
+        std::vector<std::uint32_t> deaths;
+        std::vector<Sprite>        births;
+        std::vector<Move>          moves;
+
+        [[nodiscard]]
+        std::size_t bytes() const noexcept;
+    };
+
+    struct Keyframe {
+        int                    tick;
+        std::vector<std::byte> snapshot;
+        std::vector<Sprite>    sprites;
+        std::vector<Frame>     frames;  // frames[i] leads to tick + i + 1
+        std::vector<Command>   commands;
+        std::size_t            bytes = 0;
+    };
+
+    void add_keyframe(World& world);
+
+    [[nodiscard]]
+    Frame diff(World const& world);
+
+    static void apply(Frame const& frame, std::vector<Sprite>& sprites);
+
+    [[nodiscard]]
+    Sprite sprite_of(std::uint64_t id, Vehicle const& vehicle) const noexcept;
+
+    [[nodiscard]]
+    Sprite sprite_of(std::uint64_t id, Food const& food) const noexcept;
+
+    [[nodiscard]]
+    std::vector<Sprite> sprites_of(World const& world) const;
+
+    void remember(std::vector<Sprite> sprites);
+
+    void trim();
+
+    Config               config;
+    double               step;  // pixels per unit of Sprite::x and y
+    std::deque<Keyframe> keyframes;
+    std::size_t          bytes     = 0;
+    bool                 rewinding = false;
+
+    // the sprites as of the last recorded tick, and who they belong to
+    std::vector<Sprite>               current;
+    std::unordered_set<std::uint64_t> known;
+};
+
+}  // namespace tom
+
+#endif  // HISTORY_H
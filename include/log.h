@@ -0,0 +1,55 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <cstdint>
+#include <functional>
+#include <sstream>
+#include <string_view>
+#include <utility>
+
+namespace tom {
+
+/**
+ * The messages of the simulation itself: what a verbose vehicle is up to
+ * and the errors that World::run() carries on after. vehicles_core writes
+ * nothing to the console; its messages go to the sink the program set, and
+ * nowhere when none is.
+ *
+ * The sink is called from whatever thread the message comes from, workers
+ * of a tiled tick included, so it must be safe to call concurrently
+ */
+enum struct LogLevel : std::uint8_t {
+    STATUS,  // the state of the moment, replacing the last one
+    INFO,    // a line worth keeping
+    ERROR,   // something that failed
+};
+
+using LogSink = std::function<void(LogLevel, std::string_view)>;
+
+/**
+ * Set once, before any world runs
+ */
+void set_log_sink(LogSink sink);
+
+[[nodiscard]]
+bool has_log_sink() noexcept;
+
+void write_log(LogLevel level, std::string_view message);
+
+/**
+ * The arguments streamed into one message; costs nothing without a sink
+ */
+template <typename... Args>
+void log_message(LogLevel level, Args&&... args)
+{
+    if (!has_log_sink()) {
+        return;
+    }
+    std::ostringstream message;
+    ((message << std::forward<Args>(args)), ...);
+    write_log(level, message.str());
+}
+
+}  // namespace tom
+
+#endif  // LOG_H
@@ -0,0 +1,163 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "entityrecord.h"
+
+namespace tom {
+
+struct World;
+
+/**
+ * The history of a running world as numbers: population, births, deaths,
+ * food, poison, how many vehicles feel each behaviour state, the mean and
+ * variance of every gene and the tick rate.
+ *
+ * Every tick becomes a Sample, and so does every second and every minute
+ * of wall clock time, averaged over the ticks in it (births and deaths are
+ * added up). The last `capacity` samples of each tier are kept in rings of
+ * fixed size. The samples of one tier can also be streamed to a file as
+ * they are made, as CSV or as a Header followed by raw Samples, so that a
+ * run of days writes to disk rather than growing in memory.
+ */
+class Metrics {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    enum struct Tier : std::uint8_t { TICK, SECOND, MINUTE, COUNT };
+    enum struct Format : std::uint8_t { CSV, BINARY };
+
+    static constexpr std::size_t TIERS = static_cast<std::size_t>(
+        Tier::COUNT);
+    // the DNA genes, in the order of DNARecord::GENE_NAMES
+    static constexpr std::size_t GENES  = DNARecord::GENES;
+    // WANDERING, HUNGRY, OUTGOING and DESPERATE, which a vehicle may mix
+    static constexpr std::size_t STATES = 4;
+
+    struct Gene {
+        double mean;
+        double variance;
+    };
+
+    struct Sample {
+        std::int32_t tick;     // the last tick it covers
+        std::int32_t ticks;    // how many it covers
+        double       seconds;  // since the first sample, at its end
+        double       vehicles;
+        double       food;
+        double       births;
+        double       deaths;
+        double       poison;  // the share of food that is poisonous
+        // World::tps() for single ticks, the rate achieved over the others
+        double                     tps;
+        std::array<double, STATES> states;  // vehicles that feel each
+        std::array<Gene, GENES>    genes;
+    };
+
+    struct Header {
+        char          magic[4] = {'V', 'M', 'T', 'R'};
+        std::uint32_t version  = VERSION;
+        std::uint32_t tier;
+        std::uint32_t sample_size = sizeof(Sample);
+    };
+
+    static_assert(std::is_trivially_copyable_v<Sample>);
+
+    struct Config {
+        std::size_t capacity = 3600;  // samples kept of each tier
+        std::string output;           // "" to not write any
+        Format      format = Format::CSV;
+        Tier        every  = Tier::SECOND;  // the tier written to output
+    };
+
+    /**
+     * Throws std::runtime_error if the output cannot be opened
+     */
+    explicit Metrics(Config config);
+
+    Metrics(Metrics const&)            = delete;
+    Metrics& operator=(Metrics const&) = delete;
+
+    /**
+     * Call between ticks; does nothing unless the world ticked since the
+     * last call. Throws std::runtime_error if the output cannot be written
+     */
+    void record(World const& world);
+
+    /**
+     * Close the seconds and minutes that are under way as shorter samples,
+     * so that the end of a run is not lost; call once the world stopped.
+     * Throws std::runtime_error if the output cannot be written
+     */
+    void finish();
+
+    /**
+     * The samples of tier that are kept, oldest first
+     */
+    [[nodiscard]]
+    std::vector<Sample> samples(Tier tier) const;
+
+    /**
+     * The numbers of world as it is, with no births, deaths or rate
+     */
+    [[nodiscard]]
+    static Sample measure(World const& world);
+
+    [[nodiscard]]
+    static std::string_view gene_name(std::size_t gene) noexcept;
+
+    [[nodiscard]]
+    static std::string_view state_name(std::size_t state) noexcept;
+
+    /**
+     * "tick", "second" or "minute"; throws std::invalid_argument otherwise
+     */
+    [[nodiscard]]
+    static Tier parse_tier(std::string_view name);
+
+   private:
+    static constexpr std::uint32_t VERSION = 1;
+
+    struct Ring {
+        std::vector<Sample> samples;
+        std::size_t         next = 0;  // where the next sample goes
+    };
+
+    // the finer samples that make up the next sample of a coarser tier,
+    // summed up weighted by their ticks; the genes by their vehicles
+    struct Pending {
+        Sample sums{};
+        double vehicle_ticks = 0.0;  // the weight of the genes
+        double started       = 0.0;  // seconds of the sample before
+        double ends          = 0.0;
+    };
+
+    void push(Tier tier, Sample const& sample);
+
+    void add(Tier tier, Sample const& sample);
+
+    void close(Tier tier);
+
+    void write(Sample const& sample);
+
+    Config                     config;
+    std::ofstream              out;
+    std::array<Ring, TIERS>    rings;
+    std::array<Pending, TIERS> pending;  // of SECOND and MINUTE
+    Clock::time_point          first;
+    int                        last_tick = -1;  // nothing recorded yet
+    int                        born      = 0;
+    int                        dead      = 0;
+};
+
+}  // namespace tom
+
+#endif  // METRICS_H
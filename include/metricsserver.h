@@ -0,0 +1,102 @@
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include "profiler.h"
+#include "seqlock.h"
+
+namespace tom {
+
+struct World;
+
+/**
+ * Serves the counters of a running world in the Prometheus text format to
+ * whatever scrapes them, over HTTP on a Unix domain socket or on a port of
+ * localhost.
+ *
+ * World::run() publishes the counters between ticks, at most every
+ * PUBLISH_INTERVAL, into a SeqLock. The server thread only ever reads the
+ * last published copy, so a scrape neither waits for the tick loop nor
+ * holds it up, and a slow client only delays other clients.
+ */
+class MetricsServer {
+   public:
+    static constexpr std::chrono::milliseconds PUBLISH_INTERVAL{100};
+
+    struct Counters {
+        std::int64_t  tick     = 0;
+        std::int64_t  vehicles = 0;
+        std::int64_t  food     = 0;
+        std::int64_t  births   = 0;
+        std::int64_t  deaths   = 0;
+        std::int64_t  max_age  = 0;
+        double        tps      = 0.0;
+        // since the program started, when allocations are counted
+        std::uint64_t allocations     = 0;
+        std::uint64_t allocated_bytes = 0;
+        // empty unless built with PROFILE_TICKS
+        std::array<Profiler::Summary, Profiler::PHASES> phases{};
+    };
+
+    /**
+     * Listen on address: a port number for 127.0.0.1, anything else is the
+     * path of a Unix socket (replacing a stale one). Throws
+     * std::runtime_error if it cannot
+     */
+    explicit MetricsServer(std::string address);
+
+    MetricsServer(MetricsServer const&)            = delete;
+    MetricsServer& operator=(MetricsServer const&) = delete;
+
+    /**
+     * Stops serving and removes the Unix socket
+     */
+    ~MetricsServer();
+
+    /**
+     * Call between ticks; copies the counters of world if the last copy is
+     * older than PUBLISH_INTERVAL
+     */
+    void publish(World const& world);
+
+    /**
+     * Copy the counters of world now
+     */
+    void publish_now(World const& world);
+
+    [[nodiscard]]
+    Counters counters() const noexcept
+    {
+        return published.load();
+    }
+
+    /**
+     * The counters in the Prometheus text exposition format
+     */
+    [[nodiscard]]
+    static std::string format(Counters const& counters);
+
+   private:
+    using Clock = std::chrono::steady_clock;
+
+    void serve();
+
+    void answer(int client) const;
+
+    std::string        address;
+    bool               unix_socket;
+    int                listener = -1;
+    SeqLock<Counters>  published;
+    Clock::time_point  next_publish{};
+    std::atomic<bool>  stopping{false};
+    std::thread        thread;
+};
+
+}  // namespace tom
+
+#endif  // METRICSSERVER_H
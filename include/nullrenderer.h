@@ -0,0 +1,42 @@
+#ifndef NULLRENDERER_H
+#define NULLRENDERER_H
+
+#include <chrono>
+#include "irenderer.h"
+
+namespace tom::render {
+
+/**
+ * Shows nothing at all, so that a headless run costs only the simulation.
+ * World::run() still calls it between ticks, which is where it ends the run
+ * once its budget of ticks or seconds is used up
+ */
+class NullRenderer : public IRenderer {
+   public:
+    struct Budget {
+        int    ticks   = 0;    // 0 for no limit
+        double seconds = 0.0;  // 0 for no limit
+    };
+
+    NullRenderer(World* world, Budget budget);
+
+    void clear_screen() override;
+
+    void render(bool transient) override;
+
+    void refresh() override;
+
+    void terminate() override;
+
+   private:
+    using Clock = std::chrono::steady_clock;
+
+    World*            world;
+    Budget            budget;
+    int               start_tick;
+    Clock::time_point start_time = Clock::now();
+};
+
+}  // namespace tom::render
+
+#endif  // NULLRENDERER_H
@@ -0,0 +1,89 @@
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace tom {
+
+/**
+ * Hardware performance counters of the calling thread and of the threads it
+ * starts afterwards (so create worker pools after the counters), counted in
+ * user space through Linux's perf_event_open.
+ *
+ * Counters the kernel refuses (no PMU in a virtual machine, a strict
+ * perf_event_paranoid, another OS) stay closed and read as 0; error() says
+ * why. Nothing throws, so a benchmark can always go on without them
+ */
+class PerfCounters {
+   public:
+    enum struct Event : std::uint8_t {
+        CYCLES,
+        INSTRUCTIONS,
+        L1D_MISSES,  // level 1 data cache read misses
+        LLC_MISSES,  // last level cache misses
+        BRANCH_MISSES,
+        COUNT
+    };
+
+    static constexpr std::size_t EVENTS = static_cast<std::size_t>(
+        Event::COUNT);
+
+    struct Values {
+        std::array<std::uint64_t, EVENTS> counts{};
+
+        [[nodiscard]]
+        std::uint64_t operator[](Event event) const noexcept
+        {
+            return counts[static_cast<std::size_t>(event)];
+        }
+
+        Values& operator+=(Values const& other) noexcept;
+
+        [[nodiscard]]
+        Values operator-(Values const& earlier) const noexcept;
+    };
+
+    PerfCounters();
+
+    PerfCounters(PerfCounters const&)            = delete;
+    PerfCounters& operator=(PerfCounters const&) = delete;
+
+    ~PerfCounters();
+
+    [[nodiscard]]
+    bool has(Event event) const noexcept;
+
+    /**
+     * Whether any counter could be opened
+     */
+    [[nodiscard]]
+    bool available() const noexcept;
+
+    /**
+     * Why some counter could not be opened, "" if all of them were
+     */
+    [[nodiscard]]
+    std::string const& error() const noexcept;
+
+    /**
+     * Everything counted since the counters were opened, scaled up when the
+     * kernel had to share the hardware between more counters than it has
+     */
+    [[nodiscard]]
+    Values read() const noexcept;
+
+    [[nodiscard]]
+    static std::string_view name(Event event) noexcept;
+
+   private:
+    std::array<int, EVENTS> fds;
+    std::string             why;
+};
+
+}  // namespace tom
+
+#endif  // PERFCOUNTERS_H
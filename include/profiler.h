@@ -0,0 +1,201 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string_view>
+#include "allocations.h"
+
+namespace tom {
+
+/**
+ * Latencies in log-linear buckets, like an HDR histogram: 16 buckets per
+ * power of two, so any value is known to within about 6% no matter how
+ * large, with the largest value kept exactly. Values are nanoseconds
+ */
+class Histogram {
+   public:
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr int SUB_BUCKETS     = 1 << SUB_BUCKET_BITS;
+    // up to 2^40 ns, about 18 minutes; anything longer counts as that
+    static constexpr int         MAX_BITS = 40;
+    static constexpr std::size_t BUCKETS =
+        (MAX_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    void record(std::uint64_t value) noexcept;
+
+    void add(Histogram const& other) noexcept;
+
+    void clear() noexcept;
+
+    /**
+     * The smallest value that at least `quantile` of the values are not
+     * above, to bucket precision; 0 when empty
+     */
+    [[nodiscard]]
+    std::uint64_t at(double quantile) const noexcept;
+
+    [[nodiscard]]
+    std::uint64_t count() const noexcept
+    {
+        return total;
+    }
+
+    [[nodiscard]]
+    std::uint64_t max() const noexcept
+    {
+        return largest;
+    }
+
+    [[nodiscard]]
+    static std::size_t bucket_of(std::uint64_t value) noexcept;
+
+    // the middle of the values that fall into the bucket
+    [[nodiscard]]
+    static std::uint64_t value_of(std::size_t bucket) noexcept;
+
+   private:
+    std::array<std::uint32_t, BUCKETS> counts{};
+    std::uint64_t                      total   = 0;
+    std::uint64_t                      largest = 0;
+};
+
+/**
+ * The samples of the recent past, in two windows: the one being filled and
+ * the full one before it, which is dropped when the current one fills up.
+ * Together they cover between WINDOW and 2 * WINDOW of the last samples.
+ * Window is a Histogram or anything else with count() and add()
+ */
+template <typename Window = Histogram>
+class RollingHistogram {
+   public:
+    static constexpr std::uint64_t WINDOW = 2048;
+
+    /**
+     * The window the next sample goes into
+     */
+    [[nodiscard]]
+    Window& next() noexcept
+    {
+        if (current.count() == WINDOW) {
+            previous = current;
+            current  = {};
+        }
+        return current;
+    }
+
+    /**
+     * Both windows in one
+     */
+    [[nodiscard]]
+    Window merged() const noexcept
+    {
+        Window both = current;
+        both.add(previous);
+        return both;
+    }
+
+   private:
+    Window current{};
+    Window previous{};
+};
+
+/**
+ * How long each phase of a tick (and drawing it) took over the last few
+ * thousand ticks, and how much it allocated when allocations are counted
+ * (see AllocationCounts). World feeds its profiler only when built with
+ * PROFILE_TICKS; otherwise the timers compile to nothing and the profiler
+ * stays empty
+ */
+class Profiler {
+   public:
+    using Duration = std::chrono::steady_clock::duration;
+
+    enum struct Phase : std::uint8_t {
+        EVENTS,          // World::process_events()
+        TIME_OF_DAY,     // World::check_time_of_day()
+        PRUNE_FOOD,      // World::prune_eaten_food()
+        INDEX,           // sorting entities into tiles, tiled ticks only
+        FOOD,            // every food's behaviour and movement
+        PRUNE_VEHICLES,  // World::prune_dead_vehicles()
+        VEHICLES,        // every vehicle's behaviour and movement
+        RENDER,          // IRenderer::render() in World::run()
+        COUNT
+    };
+
+    static constexpr std::size_t PHASES = static_cast<std::size_t>(
+        Phase::COUNT);
+
+#ifdef PROFILE_TICKS
+    static constexpr bool ENABLED = true;
+#else
+    static constexpr bool ENABLED = false;
+#endif
+
+    struct Summary {
+        Duration      p50{};
+        Duration      p95{};
+        Duration      p99{};
+        Duration      max{};
+        std::uint64_t samples = 0;
+        // per sample, on average and at most
+        double        allocations      = 0.0;
+        double        bytes            = 0.0;
+        std::uint64_t most_allocations = 0;
+    };
+
+    Profiler();
+    Profiler(Profiler const& other);
+    Profiler& operator=(Profiler const& other);
+    Profiler(Profiler&&) noexcept;
+    Profiler& operator=(Profiler&&) noexcept;
+    ~Profiler();
+
+    void record(Phase            phase,
+                Duration         elapsed,
+                AllocationCounts allocated = {}) noexcept;
+
+    [[nodiscard]]
+    Summary summary(Phase phase) const noexcept;
+
+    void reset() noexcept;
+
+    [[nodiscard]]
+    static std::string_view name(Phase phase) noexcept;
+
+    /**
+     * One line of p50/p95/p99/max in microseconds (and the allocations per
+     * sample, when counted) for every phase that has samples, nothing if
+     * none has
+     */
+    void write(std::ostream& out) const;
+
+   private:
+    struct Window {
+        Histogram        times;
+        AllocationCounts allocated;
+        std::uint64_t    most_allocations = 0;
+
+        [[nodiscard]]
+        std::uint64_t count() const noexcept
+        {
+            return times.count();
+        }
+
+        void add(Window const& other) noexcept;
+    };
+
+    using Phases = std::array<RollingHistogram<Window>, PHASES>;
+
+    // allocated on the first sample, so that a world that is never profiled
+    // carries none of it
+    std::unique_ptr<Phases> phases;
+};
+
+}  // namespace tom
+
+#endif  // PROFILER_H
@@ -0,0 +1,230 @@
+#ifndef RANDOMSTREAM_H
+#define RANDOMSTREAM_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace tom {
+
+/**
+ * The Philox4x32-10 counter based generator (Salmon et al., "Parallel random
+ * numbers: as easy as 1, 2, 3"). Instead of carrying state from one number
+ * to the next it turns a 128 bit counter and a 64 bit key into 128 random
+ * bits, so any number of a stream can be computed directly
+ */
+struct Philox4x32 {
+    using Counter = std::array<std::uint32_t, 4>;
+    using Key     = std::array<std::uint32_t, 2>;
+
+    static constexpr Counter block(Counter counter, Key key) noexcept
+    {
+        for (int round = 0; round < 10; round++) {
+            std::uint64_t const p0 = std::uint64_t{MULTIPLIER_0} * counter[0];
+            std::uint64_t const p1 = std::uint64_t{MULTIPLIER_1} * counter[2];
+            counter = {static_cast<std::uint32_t>(p1 >> 32) ^ counter[1] ^
+                           key[0],
+                       static_cast<std::uint32_t>(p1),
+                       static_cast<std::uint32_t>(p0 >> 32) ^ counter[3] ^
+                           key[1],
+                       static_cast<std::uint32_t>(p0)};
+            key[0] += WEYL_0;
+            key[1] += WEYL_1;
+        }
+        return counter;
+    }
+
+   private:
+    static constexpr std::uint32_t MULTIPLIER_0 = 0xD2511F53;
+    static constexpr std::uint32_t MULTIPLIER_1 = 0xCD9E8D57;
+    static constexpr std::uint32_t WEYL_0       = 0x9E3779B9;
+    static constexpr std::uint32_t WEYL_1       = 0xBB67AE85;
+};
+
+/**
+ * xoshiro256+ (Blackman and Vigna) on four independent lanes. A step is a few
+ * adds, shifts and xors per lane, so the lanes run side by side in vector
+ * registers and arrays fill several times faster than through Philox. It is
+ * only ever seeded from a RandomStream (see RandomStream::fill_uniform) and
+ * so is exactly as reproducible as the stream it came from
+ */
+class Xoshiro256x4 {
+   public:
+    static constexpr std::size_t LANES = 4;
+
+    /**
+     * Expand the seed into the state of all lanes with SplitMix64
+     */
+    explicit Xoshiro256x4(std::uint64_t seed) noexcept;
+
+    /**
+     * Fill out with uniforms in [0, 1) from the top 53 bits of each number
+     */
+    void fill_uniform(std::span<double> out) noexcept;
+
+   private:
+    using Lane = std::array<std::uint64_t, LANES>;
+
+    Lane s0;
+    Lane s1;
+    Lane s2;
+    Lane s3;
+};
+
+/**
+ * One independent sequence of random numbers, identified by the world seed,
+ * a stream id and a tick. Two streams with the same identity produce the same
+ * numbers no matter which thread draws them or what was drawn before, which
+ * is what keeps a run reproducible when entities are ticked in a different
+ * order or on different threads.
+ *
+ * Entities get a stream per tick and phase through for_entity(), as does
+ * every command issued between ticks (see World::issue); everything else
+ * draws from a stream per tick for the world as a whole. The free
+ * functions random_in_range() etc. in utils.h draw from whichever stream is
+ * currently bound on the calling thread (see Scope)
+ */
+class RandomStream {
+   public:
+    enum struct Domain : std::uint64_t { WORLD, VEHICLE, FOOD, COMMAND };
+
+    // several independent streams of the same entity in one tick
+    enum struct Phase : std::uint64_t { BEHAVIOR, UPDATE };
+
+    /**
+     * The seed is the key; stream id, tick and the index of the draw make up
+     * the counter, so no two streams ever overlap
+     */
+    constexpr RandomStream(std::uint64_t seed,
+                           std::uint64_t stream,
+                           std::uint32_t tick) noexcept
+        : key{static_cast<std::uint32_t>(seed),
+              static_cast<std::uint32_t>(seed >> 32)},
+          counter{0, static_cast<std::uint32_t>(stream),
+                  static_cast<std::uint32_t>(stream >> 32), tick}
+    {
+    }
+
+    static constexpr RandomStream for_entity(std::uint64_t seed,
+                                             Domain        domain,
+                                             std::uint64_t id,
+                                             Phase         phase,
+                                             std::uint32_t tick) noexcept
+    {
+        auto const stream = (static_cast<std::uint64_t>(domain) << 62) |
+                            (static_cast<std::uint64_t>(phase) << 60) |
+                            (id & ((std::uint64_t{1} << 60) - 1));
+        return RandomStream{seed, stream, tick};
+    }
+
+    static constexpr RandomStream for_world(std::uint64_t seed,
+                                            std::uint32_t tick) noexcept
+    {
+        return for_entity(seed, Domain::WORLD, 0, Phase::BEHAVIOR, tick);
+    }
+
+    constexpr std::uint32_t next_u32() noexcept
+    {
+        if (available == 0) {
+            buffer = Philox4x32::block(counter, key);
+            counter[0]++;
+            available = 4;
+        }
+        return buffer[--available];
+    }
+
+    /**
+     * Uniform in [0, 1) with the full 53 bits of precision of a double
+     */
+    constexpr double uniform() noexcept
+    {
+        auto const high = next_u32();
+        return to_uniform(high, next_u32());
+    }
+
+    /**
+     * Fill out with uniforms in [0, 1). One block of the stream seeds an
+     * Xoshiro256x4 that makes the numbers, which is much cheaper than
+     * calling uniform() in a loop when many numbers are needed at once (a
+     * new DNA, a litter of children). Numbers left over from uniform() etc.
+     * are skipped
+     */
+    void fill_uniform(std::span<double> out) noexcept;
+
+    constexpr double uniform(double min, double max) noexcept
+    {
+        return min + uniform() * (max - min);
+    }
+
+    /**
+     * Uniform in [0, bound) by multiplying into 64 bits (Lemire); the bias
+     * is below 2^-32 for every bound the simulation uses
+     */
+    constexpr std::uint32_t below(std::uint32_t bound) noexcept
+    {
+        return static_cast<std::uint32_t>(
+            (std::uint64_t{next_u32()} * bound) >> 32);
+    }
+
+    /**
+     * Make this stream the one random_in_range() and friends draw from on
+     * the current thread until the Scope ends. Scopes nest; the previously
+     * bound stream comes back afterwards
+     */
+    class Scope {
+       public:
+        explicit Scope(RandomStream& stream) noexcept;
+
+        Scope(Scope const&)            = delete;
+        Scope& operator=(Scope const&) = delete;
+
+        ~Scope();
+
+       private:
+        RandomStream* previous;
+    };
+
+    /**
+     * The stream bound on this thread, or a fallback stream keyed by the
+     * last set_seed() for draws outside of any tick (setting up a world etc.)
+     */
+    static RandomStream& current() noexcept
+    {
+        return bound ? *bound : fallback;
+    }
+
+    /**
+     * Restart the fallback stream of the calling thread
+     */
+    static void reseed(std::uint64_t seed) noexcept;
+
+    /**
+     * The fallback stream of the calling thread itself, so that it can be
+     * saved and restored along with a world (see Snapshot)
+     */
+    static RandomStream& unbound() noexcept
+    {
+        return fallback;
+    }
+
+   private:
+    static constexpr double to_uniform(std::uint32_t high,
+                                       std::uint32_t low) noexcept
+    {
+        auto const bits = (std::uint64_t{high >> 5} << 26) | (low >> 6);
+        return static_cast<double>(bits) * 0x1.0p-53;
+    }
+
+    Philox4x32::Key     key;
+    Philox4x32::Counter counter;
+    Philox4x32::Counter buffer{};
+    int                 available = 0;
+
+    static thread_local RandomStream* bound;
+    static thread_local RandomStream  fallback;
+};
+
+}  // namespace tom
+
+#endif  // RANDOMSTREAM_H
@@ -0,0 +1,50 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace tom {
+
+struct World;
+
+/**
+ * A named way to fill a new world, standing in for World::populate_world().
+ * How fast a tick is depends a lot on what the world looks like, so
+ * benchmarks and traces should not only look at vehicles scattered
+ * uniformly over the map.
+ *
+ * Every scenario draws only from the random stream bound to the calling
+ * thread (see set_seed()), so the same seed, size and counts always build
+ * the same world. Scenarios may change the settings of the world they fill
+ * (max_food, the time of day...) but not its size.
+ */
+struct Scenario {
+    std::string_view name;
+    std::string_view description;
+    void (*populate)(World& world, int vehicles, int food);
+};
+
+/**
+ * All scenarios; the first one is plain World::populate_world()
+ */
+[[nodiscard]]
+std::span<Scenario const> scenarios() noexcept;
+
+/**
+ * The scenario called name. Throws std::invalid_argument listing the known
+ * names if there is none
+ */
+[[nodiscard]]
+Scenario const& find_scenario(std::string_view name);
+
+/**
+ * The names of all scenarios, separated by ", "
+ */
+[[nodiscard]]
+std::string scenario_names();
+
+}  // namespace tom
+
+#endif  // SCENARIO_H
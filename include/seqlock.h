@@ -0,0 +1,84 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace tom {
+
+/**
+ * A value that one thread publishes and any number of others read, where
+ * the writer must never wait. store() bumps a sequence number to odd, writes
+ * the value and bumps it back to even; load() copies the value out and
+ * tries again if the sequence was odd or changed in the meantime. Readers
+ * only ever wait for a store that is under way, never the other way round.
+ *
+ * The value is kept in atomic words so that a read torn by a concurrent
+ * store is merely thrown away, not undefined behaviour
+ */
+template <typename T>
+    requires std::is_trivially_copyable_v<T>
+class SeqLock {
+   public:
+    // only ever from one thread at a time
+    void store(T const& value) noexcept
+    {
+        std::array<std::uint64_t, WORDS> buffer{};
+        std::memcpy(buffer.data(), &value, sizeof(T));
+
+        auto const before = sequence.load(std::memory_order_relaxed);
+        sequence.store(before + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < WORDS; i++) {
+            words[i].store(buffer[i], std::memory_order_relaxed);
+        }
+        sequence.store(before + 2, std::memory_order_release);
+    }
+
+    [[nodiscard]]
+    T load() const noexcept
+    {
+        std::array<std::uint64_t, WORDS> buffer{};
+        while (true) {
+            auto const before = sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            for (std::size_t i = 0; i < WORDS; i++) {
+                buffer[i] = words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before) {
+                break;
+            }
+        }
+        T value;
+        std::memcpy(static_cast<void*>(&value), buffer.data(), sizeof(T));
+        return value;
+    }
+
+    /**
+     * How many stores there have been
+     */
+    [[nodiscard]]
+    std::uint64_t version() const noexcept
+    {
+        return sequence.load(std::memory_order_acquire) / 2;
+    }
+
+   private:
+    static constexpr std::size_t WORDS = (sizeof(T) + 7) / 8;
+
+    std::atomic<std::uint64_t>                    sequence{0};
+    std::array<std::atomic<std::uint64_t>, WORDS> words{};
+};
+
+}  // namespace tom
+
+#endif  // SEQLOCK_H
@@ -0,0 +1,43 @@
+#ifndef SHARD_H
+#define SHARD_H
+
+namespace tom::shard {
+
+/**
+ * A sharded run cuts the world into vertical strips of equal width and
+ * simulates every strip in its own process. The processes share one POSIX
+ * shared memory segment through which they exchange, once per tick:
+ *
+ *  - halo:    copies of the entities close enough to a strip edge to be seen
+ *             from the neighbouring strip. The neighbour inserts them as
+ *             ghosts (see Vehicle::ghost) for the length of one tick
+ *  - handoff: entities that crossed a strip edge and now belong to the
+ *             neighbour
+ *  - effects: what happened to ghosts during the tick (health taken or given,
+ *             food eaten) so that the owner can apply it to the real entity
+ *
+ * The coordinator (the parent process) drives the tick barriers, merges the
+ * per shard counters and decides when the run ends.
+ */
+struct Config {
+    int          shards          = 2;
+    int          width           = 800;
+    int          height          = 600;
+    long         seed            = 0;
+    int          vehicles        = 20;
+    int          food            = 100;
+    unsigned int max_food        = 750;
+    double       food_pct_chance = 35.0;
+    bool         disable_night   = false;
+};
+
+/**
+ * Fork one process per shard and coordinate them until the run is
+ * interrupted or no shard has any vehicles left. Returns the exit code for
+ * main()
+ */
+int run_coordinator(Config const& config);
+
+}  // namespace tom::shard
+
+#endif  // SHARD_H
@@ -0,0 +1,133 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "entityrecord.h"
+#include "randomstream.h"
+
+namespace tom {
+
+struct World;
+
+/**
+ * A whole world in one binary file: a Header with the settings, counters and
+ * random number state of the world, followed by one VehicleRecord per
+ * vehicle and one FoodRecord per piece of food, each array starting on a
+ * cache line. A world continued from a snapshot ticks exactly like the world
+ * the snapshot was taken from.
+ *
+ * The file is mapped rather than read, so opening even a very large
+ * snapshot costs next to nothing; restore() then builds the entities
+ * straight out of the mapping. Snapshots can also be kept in memory in the
+ * same format (see capture()).
+ */
+class Snapshot {
+   public:
+    struct Header {
+        char          magic[4] = {'V', 'S', 'N', 'P'};
+        std::uint32_t version  = VERSION;
+        // records are written as they are laid out by this build
+        std::uint32_t vehicle_record_size = sizeof(VehicleRecord);
+        std::uint32_t food_record_size    = sizeof(FoodRecord);
+
+        std::uint64_t vehicle_count;
+        std::uint64_t vehicles_offset;
+        std::uint64_t vehicle_buckets;
+        std::uint64_t food_count;
+        std::uint64_t food_offset;
+        std::uint64_t food_buckets;
+
+        std::int64_t  seed;
+        std::int32_t  width;
+        std::int32_t  height;
+        std::uint32_t disable_night;
+        std::uint32_t max_food;
+        double        food_pct_chance;
+        std::int32_t  feed_count;
+        std::int32_t  tick_counter;
+        std::int32_t  born_counter;
+        std::int32_t  dead_counter;
+        std::int32_t  max_age;
+        std::int32_t  daytime;
+        std::int32_t  target_tps;
+        double        edge_threshold;
+        double        poison_chance;
+        double        max_force;
+        double        max_health;
+        std::uint64_t fittest_id;
+        double        fittest_fitness;
+
+        std::uint64_t vehicle_id_base;
+        std::uint64_t food_id_base;
+        std::uint64_t commands_issued;
+        RandomStream  unbound{0, 0, 0};
+    };
+
+    static_assert(std::is_trivially_copyable_v<Header>);
+
+    /**
+     * Write world to path, replacing any file that is there. Actions still
+     * queued from the last tick cannot be written down, so they are run
+     * first (see World::flush_events); everything else is left as it is
+     */
+    static void save(World& world, std::string const& path);
+
+    /**
+     * Like save() but into memory, for a Snapshot over the bytes later
+     */
+    [[nodiscard]]
+    static std::vector<std::byte> capture(World& world);
+
+    /**
+     * Map the snapshot at path. Throws if it is not a snapshot written by
+     * this build
+     */
+    explicit Snapshot(std::string const& path);
+
+    /**
+     * A snapshot made by capture(). The bytes must outlive the Snapshot
+     */
+    explicit Snapshot(std::span<std::byte const> bytes);
+
+    Snapshot(Snapshot const&)            = delete;
+    Snapshot& operator=(Snapshot const&) = delete;
+
+    ~Snapshot();
+
+    [[nodiscard]]
+    Header const& header() const noexcept;
+
+    [[nodiscard]]
+    std::span<VehicleRecord const> vehicles() const noexcept;
+
+    [[nodiscard]]
+    std::span<FoodRecord const> food() const noexcept;
+
+    /**
+     * Replace everything in world, which must have been created with the
+     * seed, width and height of the header, by the snapshot
+     */
+    void restore(World& world) const;
+
+   private:
+    static constexpr std::uint32_t VERSION = 2;
+
+    [[nodiscard]]
+    static Header header_of(World const& world);
+
+    // throws (and unmaps) unless base holds a snapshot of this build
+    void validate(std::string const& name);
+
+    void const* base   = nullptr;
+    std::size_t size   = 0;
+    bool        mapped = false;
+};
+
+}  // namespace tom
+
+#endif  // SNAPSHOT_H
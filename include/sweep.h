@@ -0,0 +1,113 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <string>
+#include <vector>
+
+namespace tom {
+
+class Snapshot;
+
+}  // namespace tom
+
+namespace tom::sweep {
+
+/**
+ * A sweep runs one headless world for every combination of parameter values
+ * and seed, as many at a time as there are cores, each in its own forked
+ * process. Every finished run becomes one CSV row: the run number, the seed,
+ * the swept values, how long the vehicles survived, the peak and mean
+ * population and its variance over the ticks, births, deaths and the mean of
+ * every DNA gene of the vehicles alive at the end.
+ *
+ * Rows are written as runs finish. Starting the same sweep with the same
+ * output again skips the runs already in the file, so a long sweep that was
+ * interrupted picks up where it stopped. A file of another sweep (another
+ * seed, seed count or sample count) is refused rather than added to.
+ */
+struct Parameter {
+    std::string         name;    // one of the world settings below
+    std::vector<double> values;  // the grid points, or
+    double              low  = 0.0;  // ... a range to sample from
+    double              high = 0.0;
+};
+
+struct Config {
+    std::vector<Parameter> parameters;
+    std::string            output;
+    long                   seed    = 0;
+    int                    seeds   = 1;     // seed, seed + 1, ...
+    int                    samples = 0;     // 0 for the whole grid
+    int                    ticks   = 5000;  // per run, fewer if all die
+    unsigned               jobs    = 0;     // 0 for one per core
+    // every run continues this world instead of populating a new one; the
+    // settings below are then those of the snapshot
+    Snapshot const*        start   = nullptr;
+
+    // the world settings that are not swept
+    int          width           = 800;
+    int          height          = 600;
+    int          vehicles        = 20;
+    int          food            = 100;
+    unsigned int max_food        = 750;
+    double       food_pct_chance = 35.0;
+    double       edge_threshold  = 20.0;
+    double       poison_chance   = 0.1;
+    double       max_force       = 0.45;
+    double       max_health      = 45.0;
+    bool         disable_night   = false;
+};
+
+/**
+ * "name=first:last:step" or "name=a,b,c" for grid points and "name=low:high"
+ * for a range to sample from. Throws std::invalid_argument for anything
+ * else, or for a name that cannot be swept
+ */
+[[nodiscard]]
+Parameter parse_parameter(std::string const& spec);
+
+/**
+ * Run the sweep until every run is in the output or it is interrupted.
+ * Returns the exit code for main()
+ */
+int run(Config const& config);
+
+/**
+ * What optimize() maximizes, averaged over the seeds of a candidate:
+ * SURVIVAL is the number of ticks until every vehicle died (or the run
+ * ended), POPULATION the mean number of vehicles over the ticks and
+ * STABILITY that mean divided by one plus its standard deviation, so that a
+ * population that stays put beats one that booms and busts (or dies out)
+ */
+enum class Objective { SURVIVAL, POPULATION, STABILITY };
+
+struct Search {
+    Objective objective   = Objective::SURVIVAL;
+    int       generations = 20;
+    int       population  = 0;  // candidates per generation, 0 to pick one
+};
+
+/**
+ * "survival", "population" or "stability". Throws std::invalid_argument
+ * for anything else
+ */
+[[nodiscard]]
+Objective parse_objective(std::string const& name);
+
+/**
+ * Search the ranges of config.parameters (grid points count as the range
+ * they span) for the settings that maximize search.objective with a
+ * (mu/mu_w, lambda) evolution strategy: every generation samples candidates
+ * around a mean with a spread per parameter, runs each with config.seeds
+ * seeds the way a sweep does, and moves the mean and the spreads towards
+ * the better half. Every candidate is written to config.output as a CSV row
+ * and the best one is printed as command line options at the end.
+ *
+ * The same seeds are used for every candidate, so candidates differ only by
+ * their settings. Returns the exit code for main()
+ */
+int optimize(Config const& config, Search const& search);
+
+}  // namespace tom::sweep
+
+#endif  // SWEEP_H
@@ -0,0 +1,83 @@
+#ifndef TICKRATE_H
+#define TICKRATE_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include "profiler.h"
+
+namespace tom {
+
+/**
+ * How fast World::run() really ticks: the ticks achieved over the last
+ * second and the last ten seconds, sleeping and drawing included, how long
+ * each tick took before the sleep (over the last few thousand ticks, see
+ * RollingHistogram) and how often that was longer than the tick a target TPS
+ * allows.
+ *
+ * Ticks are counted in slots of SLOT, the last SLOTS of which are kept, so
+ * the rate of a window is exact to within a slot and costs nothing to keep.
+ */
+class TickRate {
+   public:
+    using Clock     = std::chrono::steady_clock;
+    using Duration  = Clock::duration;
+    using TimePoint = Clock::time_point;
+
+    static constexpr Duration    SLOT  = std::chrono::milliseconds{100};
+    static constexpr std::size_t SLOTS = 100;
+
+    struct Summary {
+        double        tps_1s  = 0.0;
+        double        tps_10s = 0.0;
+        Duration      p50{};
+        Duration      p95{};
+        Duration      p99{};
+        Duration      max{};
+        std::uint64_t ticks  = 0;  // since the first one
+        std::uint64_t missed = 0;  // deadlines, of the ticks that had one
+        std::uint64_t paced  = 0;
+    };
+
+    /**
+     * One tick that started at start and had its work done by done.
+     * A deadline of zero means the tick was not paced and cannot miss
+     */
+    void record(TimePoint start, TimePoint done, Duration deadline) noexcept;
+
+    /**
+     * Ticks per second over the window up to now, which is cut short to
+     * the time since the first tick and to SLOTS * SLOT at most
+     */
+    [[nodiscard]]
+    double tps(Duration window, TimePoint now = Clock::now()) const noexcept;
+
+    [[nodiscard]]
+    Summary summary(TimePoint now = Clock::now()) const noexcept;
+
+    void reset() noexcept;
+
+    /**
+     * One line of the rates, the p50/p95/p99/max of the tick in
+     * milliseconds and the missed deadlines, if any tick was paced
+     */
+    void write(std::ostream& out) const;
+
+   private:
+    [[nodiscard]]
+    std::int64_t slot_of(TimePoint time) const noexcept;
+
+    std::array<std::uint32_t, SLOTS> counts{};
+    std::int64_t                     last_slot = -1;  // no tick yet
+    TimePoint                        first{};
+    RollingHistogram<>               latencies;
+    std::uint64_t                    ticks  = 0;
+    std::uint64_t                    missed = 0;
+    std::uint64_t                    paced  = 0;
+};
+
+}  // namespace tom
+
+#endif  // TICKRATE_H
@@ -0,0 +1,66 @@
+#ifndef TILEGRID_H
+#define TILEGRID_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "vec2d.h"
+
+namespace tom {
+
+class Vehicle;
+struct Food;
+struct World;
+
+/**
+ * Uniform grid over the world used to split a tick into independent pieces
+ * of work.
+ *
+ * Every entity is owned by exactly one tile. The tile together with the ring
+ * of tiles around it is its neighbourhood; the ring is the tile's ghost zone,
+ * which it may read but never write. Tiles are at least as wide as the
+ * largest perception radius in the world, so nothing an entity can see lies
+ * outside of its tile's neighbourhood.
+ */
+struct TileGrid {
+    using VehicleRefs = std::vector<std::pair<unsigned long, Vehicle*>>;
+    using FoodRefs    = std::vector<std::pair<unsigned long, Food*>>;
+
+    double                   tile_size = 0.0;
+    double                   margin    = 0.0;
+    int                      columns   = 0;
+    int                      rows      = 0;
+    std::vector<VehicleRefs> vehicles;
+    std::vector<FoodRefs>    food;
+
+    /**
+     * Size the grid for the current perception radii and sort every entity
+     * of the world into its tile. Cheap to call every tick: the per tile
+     * vectors keep their capacity
+     */
+    void rebuild(World& world);
+
+    [[nodiscard]]
+    std::size_t tile_count() const noexcept;
+
+    [[nodiscard]]
+    std::size_t tile_of(Vec2D const& position) const noexcept;
+
+    /**
+     * Collect the vehicles (or food) of the tile and its ghost zone into out,
+     * replacing what it held
+     */
+    void neighbourhood(std::size_t tile, VehicleRefs& out) const;
+
+    void neighbourhood(std::size_t tile, FoodRefs& out) const;
+
+   private:
+    template <typename Refs>
+    void gather(std::size_t              tile,
+                std::vector<Refs> const& from,
+                Refs&                    out) const;
+};
+
+}  // namespace tom
+
+#endif  // TILEGRID_H
@@ -0,0 +1,104 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace tom {
+
+/**
+ * What every thread was doing when, written as Chrome trace event JSON for
+ * chrome://tracing or ui.perfetto.dev: ticks and their phases, drawing,
+ * every delayed action by kind and the share of each worker in every
+ * parallel_for().
+ *
+ * Each thread writes its spans into a ring of its own without locking,
+ * keeping the last CAPACITY of them. Nothing is kept while the timeline is
+ * not recording, which costs a Span one relaxed load. The rings are read
+ * by write() and dump(), which must only be called while no thread records,
+ * between ticks or at the end of the run.
+ */
+class Timeline {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::size_t CAPACITY = std::size_t{1} << 15;
+
+    /**
+     * A stretch of time on the calling thread; recorded when it ends, if the
+     * timeline was recording when it began. Category and name must be
+     * string literals
+     */
+    class Span {
+       public:
+        Span(char const* category, char const* name) noexcept
+            : category(category), name(name)
+        {
+            if (recording()) {
+                begin = Clock::now();
+            }
+        }
+        Span(Span const&)            = delete;
+        Span& operator=(Span const&) = delete;
+        ~Span()
+        {
+            if (begin != Clock::time_point{}) {
+                record(category, name, begin, Clock::now());
+            }
+        }
+
+       private:
+        char const*       category;
+        char const*       name;
+        Clock::time_point begin{};
+    };
+
+    /**
+     * Record from now on. dump() writes to path
+     */
+    static void start(std::string path);
+
+    static void stop() noexcept;
+
+    [[nodiscard]]
+    static bool recording() noexcept
+    {
+        return active.load(std::memory_order_relaxed);
+    }
+
+    static void record(char const*       category,
+                       char const*       name,
+                       Clock::time_point begin,
+                       Clock::time_point end) noexcept;
+
+    static void write(std::ostream& out);
+
+    /**
+     * Write everything recorded so far to the path given to start(). Throws
+     * std::runtime_error if it cannot be written
+     */
+    static void dump();
+
+    /**
+     * Ask for a dump at the next chance World::run() has. Safe to call from
+     * a signal handler
+     */
+    static void request_dump() noexcept;
+
+    /**
+     * Whether a dump was requested since the last call
+     */
+    [[nodiscard]]
+    static bool take_dump_request() noexcept;
+
+   private:
+    static std::atomic<bool> active;
+    static std::atomic<bool> dump_requested;
+};
+
+}  // namespace tom
+
+#endif  // TIMELINE_H
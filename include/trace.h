@@ -0,0 +1,106 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "command.h"
+
+namespace tom {
+
+struct World;
+class Vehicle;
+struct Food;
+
+/**
+ * 64-bit hashes of the simulation state. Two entities hash alike when their
+ * ids, positions, velocities, health, counters and DNA are the same to the
+ * bit, so a change that is meant to make the simulation faster without
+ * changing what it does can be checked against the hashes of a run made
+ * before the change.
+ *
+ * The hash of a world does not depend on the order its maps iterate in, so
+ * runs with different numbers of workers can be compared.
+ */
+[[nodiscard]]
+std::uint64_t state_hash(Vehicle const& vehicle) noexcept;
+
+[[nodiscard]]
+std::uint64_t state_hash(Food const& food) noexcept;
+
+[[nodiscard]]
+std::uint64_t state_hash(World const& world) noexcept;
+
+/**
+ * The state hash of every tick of a run, written by trace() and compared
+ * against a run of the current build by check_trace(). Each tick also keeps
+ * the hash of every entity (16 bytes each) so that a divergence can be
+ * pinned on the entity that diverged
+ */
+class Trace {
+   public:
+    struct Header {
+        char               magic[4] = {'V', 'T', 'R', 'C'};
+        std::uint32_t      version  = VERSION;
+        CommandLog::Header world;  // how the traced world was made
+        std::int32_t       ticks;
+    };
+
+    struct Tick {
+        std::int32_t  tick;
+        std::uint32_t entity_count;  // Entity records that follow
+        std::uint64_t hash;
+    };
+
+    struct Entity {
+        std::uint64_t key;  // id << 1, | 1 for vehicles
+        std::uint64_t hash;
+    };
+
+    static_assert(std::is_trivially_copyable_v<Header>);
+
+    /**
+     * Start a new trace at path, replacing any file that is there
+     */
+    Trace(std::string const& path, Header const& header);
+
+    Trace(Trace const&)            = delete;
+    Trace& operator=(Trace const&) = delete;
+
+    void append(World const& world);
+
+    [[nodiscard]]
+    static Header read_header(std::string const& path);
+
+    /**
+     * Every entity of world with its hash, ordered by key
+     */
+    [[nodiscard]]
+    static std::vector<Entity> entities_of(World const& world);
+
+   private:
+    static constexpr std::uint32_t VERSION = 3;
+
+    std::ofstream out;
+};
+
+/**
+ * Write the hash of world as it is and after each of the next
+ * header.ticks ticks to path
+ */
+void trace(World& world, Trace::Header const& header, std::string const& path);
+
+/**
+ * Tick world, which must have been created from the trace's header, along
+ * the trace at path. Returns what went wrong at the first tick whose hash
+ * differs, nothing when all of them match
+ */
+[[nodiscard]]
+std::optional<std::string> check_trace(World& world, std::string const& path);
+
+}  // namespace tom
+
+#endif  // TRACE_H
@@ -3,11 +3,14 @@
 
 #include <FL/Fl_Box.H>
 #include <FL/Fl_Button.H>
+#include <FL/Fl_Hor_Value_Slider.H>
 #include <FL/fl_draw.H>
 
 #include <FL/Fl_Window.H>
 #include <functional>
 #include <memory>
+#include <vector>
+#include "history.h"
 #include "qtbase.h"
 
 #include "irenderer.h"
@@ -19,8 +22,25 @@ struct QtSeparator : QtBase, Fl_Box {
     void draw() override;
 };
 
+/**
+ * Drags the view back through World::history; letting go rewinds the world
+ * to the tick shown
+ */
+struct QtScrubber : QtBase, Fl_Hor_Value_Slider {
+    World* world;
+
+    QtScrubber(World* world, int w);
+    int handle(int event) override;
+
+    void show_past();
+    void go_back();
+};
+
 struct ControlWindow : public Fl_Window {
     static bool                          show_info;
+    // what the drawer shows instead of the world while scrubbing
+    static int                           past_tick;  // -1 when not scrubbing
+    static std::vector<History::Sprite>  past;
     World*                               world;
     std::vector<std::unique_ptr<QtBase>> buttons;
 
@@ -41,6 +61,8 @@ struct ControlWindow : public Fl_Window {
         std::function<bool()>   is_on = [] { return false; });
 
     void create_separator(int button_width);
+
+    void create_scrubber(int button_width);
 };
 }  // namespace tom::render
 #endif
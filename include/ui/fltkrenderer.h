@@ -21,10 +21,15 @@ struct FLTKCustomDrawer : public Fl_Box {
 
     void draw_vehicle(Vehicle const& vehicle);
 
+    void draw_triangle(Vec2D const& pos, double heading, int size);
+
     void draw_food(Food const& food_item);
 
     void draw_living_world();
 
+    // ControlWindow::past instead of the world as it is now
+    void draw_past_world();
+
     void draw_dead_world();
 
     void clear_screen() const;
@@ -1,8 +1,10 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <array>
 #include <cassert>
 #include <concepts>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -12,11 +14,13 @@
 #include <numeric>
 #include <ostream>
 #include <random>
+#include <span>
 #include <sstream>
 #include <string>
 #include <type_traits>
 #include <utility>
 #include <vector>
+#include "randomstream.h"
 #include "vec2d.h"
 
 #ifndef NDEBUG
@@ -36,28 +40,17 @@ concept Positionable = requires(T a) {
     { a.get_position() } -> std::convertible_to<Vec2D>;
 };
 
-#ifdef FAST_RANDOM
-
+/**
+ * Seed the random numbers drawn outside of a world tick. Inside of a tick
+ * every entity draws from its own stream keyed by the world seed (see
+ * RandomStream), so this only affects setting up a world
+ */
 [[maybe_unused]]
 static inline void set_seed(auto seed) noexcept
 {
-    srand(static_cast<unsigned int>(seed));
+    RandomStream::reseed(static_cast<std::uint64_t>(seed));
 }
 
-#else
-
-static std::random_device rd;
-static std::mt19937       gen(rd());
-
-template <typename T>
-    requires requires(T t) { gen.seed(t); }
-void set_seed(T seed)
-{
-    gen.seed(seed);
-}
-
-#endif
-
 bool random_bool() noexcept;
 
 double random_delta(double scale = 0.1) noexcept;
@@ -66,6 +59,40 @@ double random_in_range(double min, double max) noexcept;
 
 int random_int(int min, int max) noexcept;
 
+/**
+ * 32 random bits at once, e.g. one coin flip per bit
+ */
+std::uint32_t random_bits() noexcept;
+
+/**
+ * Fill out with uniforms in [0, 1) in one go; see RandomStream::fill_uniform
+ */
+void random_fill(std::span<double> out) noexcept;
+
+/**
+ * Map a uniform in [0, 1) (see random_fill()) to [min, max)
+ */
+inline double uniform_to_range(double uniform, double min, double max) noexcept
+{
+    return min + uniform * (max - min);
+}
+
+/**
+ * Map a uniform in [0, 1) to an int in [min, max] like random_int()
+ */
+inline int uniform_to_int(double uniform, int min, int max) noexcept
+{
+    return min + static_cast<int>(uniform * (max - min + 1.0));
+}
+
+template <std::size_t N>
+std::array<double, N> random_uniforms() noexcept
+{
+    std::array<double, N> uniforms;
+    random_fill(uniforms);
+    return uniforms;
+}
+
 static inline bool double_equal(double a,
                                 double b,
                                 double epsilon = 0.001) noexcept
@@ -93,8 +120,6 @@ T remap(T value, T from1, T to1, T from2, T to2)
     return (value - from1) / (to1 - from1) * (to2 - from2) + from2;
 }
 
-void clear_screen();
-
 namespace ansi {
 static constexpr std::string RESET_ESC = "\033[0m";
 
@@ -1,6 +1,7 @@
 #ifndef VEHICLE_H
 #define VEHICLE_H
 
+#include "countdown.h"
 #include "dna.h"
 #include "lifespan.h"
 #include "optionset.h"
@@ -112,8 +113,17 @@ class Vehicle {
     bool is_dead() const;
     void update();
     void kill();
+
+    /**
+     * Add health, or take it away for a negative amount, measured in the
+     * same ticks as Vehicle::health += and -=
+     */
+    void change_health(double ticks);
+
     void avoid_edges();
     void behaviors(Vehicles& vehicles, Foods& food_positions);
+    void behaviors(World::VehicleRefs& vehicles,
+                   World::FoodRefs&    food_positions);
     void populate_in_place(IdType       id,
                            World*       world,
                            Vec2D const& position,
@@ -123,22 +133,29 @@ class Vehicle {
                            LifespanType health,
                            bool         verbose);
 
-    template <class Container, typename T = Container::value_type::second_type>
+    /**
+     * Nearest entity in a map of entities or in a list of (id, pointer)
+     * references such as a tile neighbourhood
+     */
+    template <class Container,
+              typename T = std::remove_pointer_t<
+                  typename Container::value_type::second_type>>
     T* find_nearest(Container& items, double& out_distance)
     {
         T*     nearest = nullptr;
         double record  = std::numeric_limits<double>::infinity();
 
         for (auto& [item_id, item] : items) {
-            if constexpr (std::is_same_v<T, decltype(item)>) {
+            if constexpr (std::is_same_v<T, Vehicle>) {
                 if (item_id == id) {
                     continue;
                 }
             }
-            auto distance = find_distance(position, item);
+            T&   candidate = entry(item);
+            auto distance  = find_distance(position, candidate);
             if (distance < record) {
                 record  = distance;
-                nearest = &item;
+                nearest = &candidate;
             }
         }
 
@@ -149,11 +166,14 @@ class Vehicle {
     [[nodiscard]]
     bool is_less_fit(Vehicle const& other) const;
 
-    static int const    WANDER_DISTANCE;
-    static double const MAX_FORCE;
-    static double const MAX_HEALTH;
+    static int const WANDER_DISTANCE;
+    // settings rather than constants, so that they can be tuned per run
+    static double    MAX_FORCE;
+    static double    MAX_HEALTH;
 
    private:
+    explicit Vehicle(RestoreTag) noexcept;
+
     static IdType global_id_counter;
     void          determine_behavior();
     void          seek_for_eat(Food* target, double record);
@@ -172,10 +192,26 @@ class Vehicle {
     [[nodiscard]]
     Food& last_sought_food(double& record) const;
 
-    void food_behaviors(Foods& food_positions);
+    template <typename T>
+    static T& entry(T& item)
+    {
+        return item;
+    }
+
+    template <typename T>
+    static T& entry(T* item)
+    {
+        return *item;
+    }
+
+    template <class VehicleRange, class FoodRange>
+    void behaviors_among(VehicleRange& vehicles, FoodRange& food_positions);
+    template <class FoodRange>
+    void food_behaviors(FoodRange& food_positions);
     void check_sought_vehicle();
     void check_sought_food();
-    void vehicle_behaviors(Vehicles& vehicles);
+    template <class VehicleRange>
+    void vehicle_behaviors(VehicleRange& vehicles);
     void try_explosion();
     void apply_force(Vec2D force, bool unlimited = false);
     void perform_reproduction(Vehicle const& mom, Vehicle const& dad) const;
@@ -194,6 +230,8 @@ class Vehicle {
     Vec2D acceleration{};
     Vec2D wanderTarget{velocity};
 
+    Countdown explosion_countdown;  // see Countdown
+
    public:
     OptionSet<BehaviorState> behavior_state{};
 
@@ -202,14 +240,36 @@ class Vehicle {
         return ++global_id_counter;
     }
 
+    /**
+     * Move the id counter to a new base so that several processes can hand
+     * vehicles to each other without their ids colliding
+     */
+    static void set_id_base(IdType base)
+    {
+        global_id_counter = base;
+    }
+
+    /**
+     * Where the id counter stands, to hand to set_id_base() later
+     */
+    [[nodiscard]]
+    static IdType id_base() noexcept
+    {
+        return global_id_counter;
+    }
+
     IdType            id;
     IdType            last_sought_vehicle_id = 0;
     World::FoodIdType last_sought_food_id    = 0;
     bool              verbose                = false;
     bool              highlighted            = false;
+    // a read-only copy of a vehicle owned by another shard; the world
+    // lets others see it but never updates or prunes it
+    bool ghost = false;
 
     friend struct World;
     friend struct Food;
+    friend struct VehicleRecord;
 };
 
 }  // namespace tom
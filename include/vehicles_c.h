@@ -0,0 +1,103 @@
+#ifndef VEHICLES_C_H
+#define VEHICLES_C_H
+
+/*
+ * A plain C interface to the simulation (see tom::Engine), for callers in
+ * other languages. Nothing here throws: functions that can fail return NULL
+ * or a negative number and leave a message for vw_last_error().
+ *
+ * The export functions copy one value (or struct) per entity into arrays the
+ * caller owns, in the same order for every export between two steps, so
+ * whole populations move across in one call each. They return how many
+ * entities there are, which may be more than fit; call with a capacity of 0
+ * to size the arrays first. The first export of a kind after a step lays
+ * the population out for it, and every further one until the next step is a
+ * plain copy; a world is not to be exported from two threads at once.
+ *
+ * Passing a NULL world (what a failed vw_create() returned, for example)
+ * fails like anything else: -1, or zeros and 0 entities, with a message.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct vw_world vw_world;
+
+typedef struct vw_config {
+    int64_t  seed;
+    int32_t  width;
+    int32_t  height;
+    int32_t  vehicles;
+    int32_t  food;
+    uint32_t max_food;
+    double   food_pct_chance;
+    double   edge_threshold;
+    double   poison_chance;
+    double   max_force;
+    double   max_health;
+    int32_t  disable_night;
+    uint32_t workers; /* threads per tick, 0 for none */
+} vw_config;
+
+typedef struct vw_stats {
+    int32_t  tick;
+    int32_t  births;
+    int32_t  deaths;
+    int32_t  max_age;
+    uint64_t vehicles;
+    uint64_t food;
+    int32_t  day;
+} vw_stats;
+
+/* one vehicle, as exported by vw_export_traits() */
+typedef struct vw_traits {
+    uint64_t id;
+    float    health;
+    int32_t  age;
+    int32_t  generation;
+    float    perception_radius;
+    float    max_speed;
+    float    mutation_rate;
+    float    reproduction_cost;
+    float    malice_desire;
+    float    altruism_desire;
+    float    explosion_chance;
+    float    edge_repulsion;
+} vw_traits;
+
+/* the defaults of the program */
+vw_config vw_default_config(void);
+
+vw_world* vw_create(vw_config const* config);
+
+/* continue the world saved in a snapshot */
+vw_world* vw_load(char const* path, uint32_t workers);
+
+int vw_save(vw_world* world, char const* path);
+
+void vw_destroy(vw_world* world);
+
+/* tick up to n times, fewer if every vehicle dies; returns the ticks run */
+int vw_step(vw_world* world, int n);
+
+vw_stats vw_get_stats(vw_world const* world);
+
+/* x and y of every vehicle, interleaved: xy holds cap pairs */
+size_t vw_export_positions(vw_world const* world, float* xy, size_t cap);
+
+size_t vw_export_food_positions(vw_world const* world, float* xy, size_t cap);
+
+size_t vw_export_traits(vw_world const* world, vw_traits* out, size_t cap);
+
+/* what went wrong last on this thread, "" if nothing did */
+char const* vw_last_error(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VEHICLES_C_H */
@@ -1,3 +1,6 @@
+#ifndef WINDOWS_SHIM_H
+#define WINDOWS_SHIM_H
+
 // #ifdef WIN32
 
 // define our own usleep and getopt
@@ -10,6 +13,20 @@ extern int         argpos;
 extern int         optopt_shim;
 
 int getopt_shim(int argc, char const* argv[], char const* argstr);
+
+// --name style options; val is returned when name matches
+struct option_shim {
+    char const* name;
+    int         has_arg;
+    int         val;
+};
+
+// like getopt_shim but also accepts --name options from the null-terminated
+// longopts table
+int getopt_long_shim(int                       argc,
+                     char const*               argv[],
+                     char const*               argstr,
+                     struct option_shim const* longopts);
 }
 
 // #else
@@ -18,3 +35,5 @@ int getopt_shim(int argc, char const* argv[], char const* argstr);
 //  use built-in POSIX functions
 
 // #endif
+
+#endif  // WINDOWS_SHIM_H
@@ -0,0 +1,63 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tom {
+
+/**
+ * A fixed set of threads that are started once and reused for every
+ * parallel_for() so that per tick work does not pay for thread creation
+ */
+class WorkerPool {
+   public:
+    using Task = std::function<void(std::size_t)>;
+
+    /**
+     * @param count total number of threads doing work, including the thread
+     * that calls parallel_for(); 0 or 1 means everything runs on the caller
+     */
+    explicit WorkerPool(unsigned count);
+
+    WorkerPool(WorkerPool const&)            = delete;
+    WorkerPool& operator=(WorkerPool const&) = delete;
+
+    /**
+     * Call task(i) for every i in [0, count). Indices are handed out one at a
+     * time so uneven pieces of work balance out. Returns once every call has
+     * finished
+     */
+    void parallel_for(std::size_t count, Task const& task);
+
+    [[nodiscard]]
+    unsigned size() const noexcept;
+
+    ~WorkerPool();
+
+   private:
+    void work();
+
+    void drain();
+
+    std::vector<std::thread> threads;
+    std::mutex               mutex;
+    std::condition_variable  wake;
+    std::condition_variable  done;
+    Task const*              task  = nullptr;
+    std::size_t              count = 0;
+    std::atomic<std::size_t> next{0};
+    std::size_t              busy       = 0;
+    std::uint64_t            generation = 0;
+    bool                     stopping   = false;
+};
+
+}  // namespace tom
+
+#endif  // WORKERPOOL_H
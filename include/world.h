@@ -1,20 +1,32 @@
 #ifndef WORLD_H
 #define WORLD_H
 
+#include <array>
 #include <chrono>
 #include <functional>
+#include <memory>
 #include <ostream>
 #include <queue>
 #include <sstream>
 #include <unordered_map>
 #include <utility>
 #include <vector>
+#include "command.h"
+#include "countdown.h"
 #include "cyclic_num.h"
 #include "dna.h"
 #include "optionset.h"
+#include "perfcounters.h"
+#include "profiler.h"
+#include "randomstream.h"
+#include "tickrate.h"
+#include "tilegrid.h"
+#include "timeline.h"
 #include "windows_shim.h"
+#include "workerpool.h"
 
 #include "irenderer.h"
+#include "log.h"
 #include "utils.h"
 #include "vec2d.h"
 
@@ -22,6 +34,10 @@ namespace tom {
 
 class Vehicle;
 struct Food;
+class Checkpointer;
+class History;
+class Metrics;
+class MetricsServer;
 
 template <typename Callable, typename... Args>
 concept CallableWith = requires(Callable c, Args... args) { c(args...); };
@@ -34,6 +50,8 @@ struct World {
     using FoodIdType    = unsigned long;
     using Foods         = std::unordered_map<FoodIdType, Food>;
     using Vehicles      = std::unordered_map<VehicleIdType, Vehicle>;
+    using VehicleRefs   = TileGrid::VehicleRefs;
+    using FoodRefs      = TileGrid::FoodRefs;
     using Clock         = std::chrono::steady_clock;
     using Duration      = Clock::duration;
     using TimePoint     = Clock::time_point;
@@ -44,7 +62,10 @@ struct World {
     static OptionSet<ViewMode>              view_mode;
     static OptionSet<InteractMode>          interact_mode;
     static int                              kill_radius;
+    static constexpr double                 select_radius = 30.0;
     static double                           edge_threshold;
+    // chance that new food is poisonous
+    static double                           poison_chance;
     static bool                             was_interrupted;
     static bool                             unlimited_tps;
     static std::pair<VehicleIdType, double> max_fitness;
@@ -92,21 +113,57 @@ struct World {
     Clock::time_point              end_time;
     cyclic<decltype(tick_counter)> daytime{day_night_cycle_length};
 
+    // every issued command is written here when set, see issue()
+    CommandLog*    command_log    = nullptr;
+    // takes checkpoints while run() runs when set
+    Checkpointer*  checkpointer   = nullptr;
+    // keeps the recent past while run() runs when set, for rewinding
+    History*       history        = nullptr;
+    // records the numbers of every tick while run() runs when set
+    Metrics*       metrics        = nullptr;
+    // publishes the counters for scraping while run() runs when set
+    MetricsServer* metrics_server = nullptr;
+    /**
+     * Where the time of tick() goes, summed over every tick while
+     * phase_times is set. Nothing is timed when it is not
+     */
+    struct PhaseTimes {
+        Duration events{};    // delayed actions and the time of day
+        Duration prune{};     // removing dead vehicles and eaten food
+        Duration index{};     // sorting entities into tiles (tiled ticks)
+        Duration food{};      // food behaviour and movement
+        Duration vehicles{};  // vehicle behaviour, interactions and movement
+        int      ticks = 0;
+
+        // read around every phase when set
+        PerfCounters const* counters = nullptr;
+        // what they counted, by Profiler::Phase
+        std::array<PerfCounters::Values, Profiler::PHASES> counted{};
+    };
+
+    PhaseTimes* phase_times = nullptr;
+    // histograms of every phase, filled only when built with PROFILE_TICKS
+    Profiler    profiler;
+    // how fast run() ticks, see tps()
+    TickRate    tick_rate;
+    // told about every vehicle that is born and every one that dies when set
+    std::function<void(Vehicle const&)> on_birth;
+    std::function<void(Vehicle const&)> on_death;
+
+    /**
+     * The SIGINT handler of programs that run worlds; a world installs no
+     * handler of its own. Anything that replaces it must take care to set
+     * World::was_interrupted to true if it expects the program to end, for
+     * example tom::render::ConsoleRenderer sets a new SIGINT handler to show
+     * a menu, but handles the quit case by setting World::was_interrupted
+     */
     static void stop_running(int)
     {
-        output("Interrupting world...");
+        log_message(LogLevel::INFO, "Interrupting world...");
         game_running    = false;
         was_interrupted = true;
     }
 
-    /**
-     * Note that World::World() installs a signal handler on SIGINT
-     * If anything attempts to replace this handler it must take care to
-     * set World::was_interrupted to true if they expect the program to end
-     * for example tom::render::ConsoleRenderer sets a new SIGINT handler
-     * to show a menu, but handles the quit case by setting the variable
-     * World::was_interrupted to true to exit
-     */
     World(long seed, int width, int height);
 
     /**
@@ -124,13 +181,64 @@ struct World {
        etc.
 
        @param c A callable object with signature auto c(World *) -> void;
+       @param name What c does, as a string literal, for the Timeline
     */
     template <CallableWith<World*> Callable>
-    void delay(Callable c)
+    void delay(Callable c, char const* name = "action")
     {
-        actions.push(c);
+        if (Timeline::recording()) {
+            action_queue().push([c = std::move(c), name](World* world) {
+                Timeline::Span span("event", name);
+                c(world);
+            });
+            return;
+        }
+        action_queue().push(c);
     }
 
+    /**
+     * Something an entity does to another entity (or to itself) while it
+     * decides how to behave during a tick.
+     *
+     * Normally the interaction happens on the spot. While tiles are ticked in
+     * parallel (see enable_workers()) entities must not write to anything a
+     * neighbouring tile may be reading, so interactions are collected per
+     * tile instead and applied at the barrier that ends the behaviour phase,
+     * in tile order.
+     */
+    struct Interaction {
+        enum struct Kind {
+            HEALTH,    // vehicle health += amount (or -= for negative amounts)
+            DRAIN,     // vehicle health-- (one tick's worth)
+            KILL,      // vehicle dies
+            CONSUME,   // vehicle eats food
+            EXPIRE,    // food goes away
+            HIGHLIGHT  // vehicle is drawn highlighted
+        };
+
+        Kind     kind;
+        Vehicle* vehicle = nullptr;
+        Food*    food    = nullptr;
+        double   amount  = 0.0;
+    };
+
+    void interact(Interaction const& interaction);
+
+    /**
+     * Carry out a command from outside of the simulation (the UI, a replay)
+     * between two ticks. The command is stamped with the current tick and
+     * written to the command log, and whatever it draws comes from a stream
+     * of its own so that replaying it draws exactly the same numbers
+     */
+    void issue(Command command);
+
+    /**
+     * Tick with `count` threads by splitting the world into tiles (see
+     * TileGrid) instead of walking every entity on one thread. 0 switches
+     * back to the plain sequential tick
+     */
+    void enable_workers(unsigned count);
+
     void add_vehicle(Vehicle&& vehicle);
 
     void add_vehicle(Vec2D const& position, DNA const& dna);
@@ -142,12 +250,17 @@ struct World {
 
     Food const& new_random_food();
 
+    Food const& new_random_food(Vec2D const& position);
+
     Food& new_food(Vec2D food_position, double nutrition);
 
     Food const& new_food(double nutrition);
 
+    /**
+     * Whether food with this countdown spawns more food this tick
+     */
     [[nodiscard]]
-    bool should_spawn_food() const noexcept;
+    bool should_spawn_food(Countdown& countdown) const noexcept;
 
     auto prune_dead_vehicles() -> typename decltype(vehicles)::size_type;
 
@@ -170,6 +283,9 @@ struct World {
 
     void populate_world(int vehicle_count, int food_count);
 
+    /**
+     * The ticks run() achieved over the last second
+     */
     [[nodiscard]]
     double tps() const;
 
@@ -179,7 +295,7 @@ struct World {
     [[nodiscard]]
     std::stringstream info_stream(std::string delim) const;
 
-    void run(render::IRenderer& renderer, int target_tps = World::target_tps);
+    void run(render::IRenderer& renderer);
 
     static void pause()
     {
@@ -203,16 +319,70 @@ struct World {
 
     void clear_verbose_vehicles();
 
+    /**
+     * Run every action queued with delay(). tick() does this first thing, but
+     * callers that need the queue empty between ticks (for example before
+     * removing entities that a queued action may point to) can flush it early
+     * without changing the outcome of the next tick
+     */
+    void process_events();
+
     ~World();
 
    private:
-    double current_tps{};
+    friend class Snapshot;
+
+    // what a tile produced during a parallel phase, merged at the barrier
+    struct TileContext {
+        std::vector<Interaction>                interactions;
+        std::queue<std::function<void(World*)>> actions;
+        int                                     max_age = 0;
+        std::pair<VehicleIdType, double>        fittest{0, 0.0};
+    };
+
+    static thread_local TileContext* current_tile;
+
+    std::uint64_t               commands_issued = 0;
+    std::shared_ptr<WorkerPool> workers;
+    TileGrid                    tiles;
+    std::vector<TileContext>    tile_contexts;
 
     void food_tick(Foods& food_neighbors, Vehicles& vehicles);
 
     void vehicle_tick(Vehicles& neighbors, Foods& food_neighbors);
 
-    void process_events();
+    void tiled_food_tick();
+
+    void tiled_vehicle_tick();
+
+    void apply(Interaction const& interaction);
+
+    void execute(Command const& command);
+
+    // the random numbers drawn during the next tick outside of any entity
+    [[nodiscard]]
+    RandomStream world_stream() const noexcept;
+
+    /**
+     * Run the actions queued during the last tick now instead of first thing
+     * in the next tick, drawing the numbers the next tick would have drawn
+     * for them. Nothing changes except that the queue is empty afterwards
+     */
+    void flush_events();
+
+    // the random numbers an entity draws during this tick, see RandomStream
+    [[nodiscard]]
+    RandomStream vehicle_stream(VehicleIdType       id,
+                                RandomStream::Phase phase) const noexcept;
+
+    [[nodiscard]]
+    RandomStream food_stream(FoodIdType id) const noexcept;
+
+    void reset_tile_contexts();
+
+    void merge_tile_contexts();
+
+    auto action_queue() -> decltype(actions)&;
 
     static Duration one_tick_time();
 
@@ -0,0 +1,79 @@
+#include "allocations.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace tom {
+
+namespace {
+
+std::atomic<std::uint64_t> allocated{0};
+std::atomic<std::uint64_t> allocated_bytes{0};
+
+}  // namespace
+
+AllocationCounts AllocationCounts::so_far() noexcept
+{
+    return {.allocations = allocated.load(std::memory_order_relaxed),
+            .bytes       = allocated_bytes.load(std::memory_order_relaxed)};
+}
+
+}  // namespace tom
+
+#ifdef COUNT_ALLOCATIONS
+
+namespace {
+
+void count(std::size_t size) noexcept
+{
+    tom::allocated.fetch_add(1, std::memory_order_relaxed);
+    tom::allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+}  // namespace
+
+// the array and nothrow forms of the library call these two
+
+void* operator new(std::size_t size)
+{
+    count(size);
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    count(size);
+    auto const align = static_cast<std::size_t>(alignment);
+    // aligned_alloc wants a multiple of the alignment
+    auto const rounded = (size + align - 1) / align * align;
+    if (void* memory = std::aligned_alloc(align, rounded == 0 ? align
+                                                              : rounded)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+
+#endif  // COUNT_ALLOCATIONS
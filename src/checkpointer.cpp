@@ -0,0 +1,180 @@
+#include "checkpointer.h"
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <utility>
+#include <vector>
+#include "log.h"
+#include "snapshot.h"
+#include "world.h"
+
+namespace tom {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char const* PREFIX  = "checkpoint-";
+constexpr char const* SUFFIX  = ".snap";
+constexpr char const* PARTIAL = ".partial";
+
+// zero padded so that sorting by name sorts by tick
+std::string checkpoint_name(int tick)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%s%010d%s", PREFIX, tick, SUFFIX);
+    return name;
+}
+
+// every complete checkpoint in directory, oldest first
+std::vector<fs::path> checkpoints(fs::path const& directory)
+{
+    std::vector<fs::path> found;
+    std::error_code       error;
+    for (auto const& entry : fs::directory_iterator(directory, error)) {
+        auto const name = entry.path().filename().string();
+        if (name.starts_with(PREFIX) && name.ends_with(SUFFIX)) {
+            found.push_back(entry.path());
+        }
+    }
+    std::ranges::sort(found);
+    return found;
+}
+
+}  // namespace
+
+Checkpointer::Checkpointer(Config config) : config(std::move(config))
+{
+    fs::create_directories(this->config.directory);
+}
+
+Checkpointer::~Checkpointer()
+{
+    reap(true);
+}
+
+void Checkpointer::between_ticks(World& world)
+{
+    if (last_tick < 0) {
+        last_tick = world.tick_counter;
+        return;
+    }
+    // a checkpoint that is due while the last one is still being written
+    // is taken as soon as that one is done
+    if (!is_due(world) || !reap(false)) {
+        return;
+    }
+    last_tick = world.tick_counter;
+    last_time = Clock::now();
+
+    pid_t const pid = fork();
+    if (pid == 0) {
+        // only this thread lives on in the child. It must never return into
+        // the simulation and leaves through _exit() so that nothing the
+        // parent owns (windows, files, the terminal) is torn down
+        int status = EXIT_SUCCESS;
+        try {
+            write(world);
+            rotate();
+        } catch (std::exception const& e) {
+            log_message(LogLevel::ERROR, "Checkpoint failed: ", e.what());
+            status = EXIT_FAILURE;
+        }
+        _exit(status);
+    }
+    if (pid == -1) {
+        log_message(LogLevel::ERROR, "Could not fork to write a checkpoint");
+        return;
+    }
+    writer = pid;
+}
+
+std::optional<std::string> Checkpointer::latest(std::string const& directory)
+{
+    auto const found = checkpoints(directory);
+    if (found.empty()) {
+        return std::nullopt;
+    }
+    return found.back().string();
+}
+
+bool Checkpointer::is_due(World const& world) const
+{
+    auto const ticks = world.tick_counter - last_tick;
+    if (ticks <= 0) {
+        return false;
+    }
+    return (config.every_ticks > 0 && ticks >= config.every_ticks) ||
+           (config.every_seconds > 0.0 &&
+            Clock::now() - last_time >=
+                std::chrono::duration<double>(config.every_seconds));
+}
+
+bool Checkpointer::reap(bool block)
+{
+    if (writer == -1) {
+        return true;
+    }
+    int   status;
+    pid_t done;
+    do {
+        done = waitpid(writer, &status, block ? 0 : WNOHANG);
+    } while (done == -1 && errno == EINTR);
+    if (done == 0) {
+        return false;
+    }
+    writer = -1;
+    // last_tick is still the tick the writer saved
+    if (done == -1) {
+        log_message(LogLevel::ERROR, "Lost the checkpoint writer of tick ",
+                    last_tick, ": ", std::strerror(errno));
+    } else if (WIFSIGNALED(status)) {
+        log_message(LogLevel::ERROR, "The checkpoint of tick ", last_tick,
+                    " was not written, its writer got signal ",
+                    WTERMSIG(status), " (", strsignal(WTERMSIG(status)),
+                    ")");
+    } else if (WIFEXITED(status) && WEXITSTATUS(status) != EXIT_SUCCESS) {
+        log_message(LogLevel::ERROR, "The checkpoint of tick ", last_tick,
+                    " was not written, its writer exited with status ",
+                    WEXITSTATUS(status));
+    }
+    return true;
+}
+
+void Checkpointer::write(World& world) const
+{
+    auto const path = fs::path(config.directory) /
+                      checkpoint_name(world.tick_counter);
+    auto partial = path;
+    partial += PARTIAL;
+
+    Snapshot::save(world, partial.string());
+    // renaming is atomic: the checkpoint is either all there or not at all
+    fs::rename(partial, path);
+}
+
+void Checkpointer::rotate() const
+{
+    auto const found = checkpoints(config.directory);
+    auto const keep  = static_cast<std::size_t>(std::max(config.keep, 1));
+    for (std::size_t i = 0; i + keep < found.size(); i++) {
+        fs::remove(found[i]);
+    }
+
+    // left behind by a writer that did not finish; only one writes at a time
+    std::error_code error;
+    for (auto const& entry :
+         fs::directory_iterator(config.directory, error)) {
+        if (entry.path().filename().string().ends_with(PARTIAL)) {
+            fs::remove(entry.path(), error);
+        }
+    }
+}
+
+}  // namespace tom
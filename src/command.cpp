@@ -0,0 +1,80 @@
+#include "command.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "world.h"
+
+namespace tom {
+
+std::uint32_t CommandLog::Recording::end_tick() const noexcept
+{
+    return commands.empty() ? 0 : commands.back().tick;
+}
+
+CommandLog::CommandLog(std::string const& path, Header const& header)
+    : out(path, std::ios::binary | std::ios::trunc)
+{
+    if (!out) {
+        throw std::runtime_error("Could not open command log " + path);
+    }
+    out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    out.flush();
+}
+
+void CommandLog::append(Command const& command)
+{
+    out.write(reinterpret_cast<char const*>(&command), sizeof(command));
+    out.flush();
+}
+
+CommandLog::Recording CommandLog::load(std::string const& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Could not open command log " + path);
+    }
+
+    Recording recording;
+    Header&   header = recording.header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, Header{}.magic, sizeof(header.magic)) != 0) {
+        throw std::runtime_error(path + " is not a command log");
+    }
+    if (header.version != VERSION) {
+        throw std::runtime_error(path + " was written by another version");
+    }
+
+    // a partial command at the end is what a crash mid write leaves behind
+    Command command;
+    while (in.read(reinterpret_cast<char*>(&command), sizeof(command))) {
+        recording.commands.push_back(command);
+        if (command.kind == Command::Kind::END) {
+            break;
+        }
+    }
+    return recording;
+}
+
+void replay(World& world, CommandLog::Recording const& recording)
+{
+    auto const end  = recording.end_tick();
+    auto const last = recording.commands.end();
+    auto       next = recording.commands.begin();
+
+    world.start_time = World::Clock::now();
+    for (;;) {
+        auto const tick = static_cast<std::uint32_t>(world.tick_counter);
+        for (; next != last && next->tick == tick; ++next) {
+            world.issue(*next);
+        }
+        if (tick >= end || World::was_interrupted) {
+            break;
+        }
+        world.tick();
+    }
+    world.end_time      = World::Clock::now();
+    World::game_running = false;
+}
+
+}  // namespace tom
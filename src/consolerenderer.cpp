@@ -1,8 +1,10 @@
 #include "include/consolerenderer.h"
 #include <csignal>
 #include <iostream>
+#include <string>
 #include "checks.h"
 #include "include/world.h"
+#include "snapshot.h"
 #include "utils.h"
 
 static bool check_poll = false;
@@ -40,7 +42,7 @@ void tom::render::ConsoleRenderer::interrupt_ask()
     enter_alt_buff();
 reask:
     // show cursor for options
-    tom::clear_screen();
+    clear_screen();
     console_out("\033[?25h");
     console_out(world->info_stream().str());
     console_out("\n\nAvailable Commands:");
@@ -51,6 +53,7 @@ reask:
     console_out("\nf: change the food spawn chance");
     console_out("\nv: add a number of vehicles");
     console_out("\na: add an amount of new food");
+    console_out("\nw: write a snapshot of the world to a file");
     console_out("\ns: return to the simulation");
     console_out("\n\nEnter a command: ");
     char c;
@@ -74,42 +77,48 @@ reask:
             std::cin >> max;
             GUARD(max >= 0);
             GUARD(max <= 10000);
-            world->max_food = max;
+            world->issue({.kind  = Command::Kind::SET_MAX_FOOD,
+                          .value = static_cast<double>(max)});
         } break;
         case 'f': {
             tom::output("Enter the food spawn chance (0-100%): ");
             float chance;
             std::cin >> chance;
             GUARD(chance >= 0 && chance <= 100);
-            world->food_pct_chance = chance;
+            world->issue(
+                {.kind = Command::Kind::SET_FOOD_CHANCE, .value = chance});
         } break;
         case 'v': {
             tom::output("Enter number of new vehicles to add: ");
             int count;
             std::cin >> count;
             GUARD(count >= 0);
-            world->delay([this, count](auto*) {
-                for (int i = 0; i < count; i++) {
-                    world->create_vehicle(world->rand_pos_in_bounds());
-                }
-            });
+            world->issue({.kind  = Command::Kind::ADD_VEHICLES,
+                          .value = static_cast<double>(count)});
         } break;
         case 'a': {
             tom::output("Enter amount of new food to add: ");
             int count;
             std::cin >> count;
             GUARD(count >= 0);
-            world->delay([this, count](auto) {
-                for (int i = 0; i < count; i++) {
-                    world->new_random_food();
-                }
-            });
+            world->issue({.kind  = Command::Kind::ADD_FOOD,
+                          .value = static_cast<double>(count)});
+        } break;
+        case 'w': {
+            tom::output("Enter the file to write the snapshot to: ");
+            std::string path;
+            std::cin >> path;
+            try {
+                Snapshot::save(*world, path);
+            } catch (std::exception const& e) {
+                tom::output(e.what(), "\n");
+            }
         } break;
         case 's':
             check_poll = false;
             break;
     }
-    tom::clear_screen();
+    clear_screen();
     if (check_poll)
         goto reask;
     else
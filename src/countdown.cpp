@@ -0,0 +1,29 @@
+#include "countdown.h"
+
+#include <cmath>
+#include <limits>
+
+#include "utils.h"
+
+namespace tom {
+
+std::uint32_t Countdown::trials_until_event(double p) noexcept
+{
+    constexpr auto never = std::numeric_limits<std::uint32_t>::max();
+
+    if (!(p > 0.0)) {
+        // an event that cannot happen is postponed for as long as possible
+        // and drawn again as soon as its probability changes
+        return never;
+    }
+    if (p >= 1.0) {
+        return 1;
+    }
+
+    // inversion: floor(log(u) / log(1 - p)) + 1 with u in (0, 1]
+    double const u      = 1.0 - random_in_range(0, 1);
+    double const trials = std::floor(std::log(u) / std::log1p(-p)) + 1.0;
+    return trials >= never ? never : static_cast<std::uint32_t>(trials);
+}
+
+}  // namespace tom
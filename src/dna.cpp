@@ -4,107 +4,101 @@
 
 namespace tom {
 
-DNA::DNA() noexcept
-    : perception_radius(random_in_range(40, 100)),
-      max_speed(random_in_range(0.75, 3.0)),
+DNA::DNA() noexcept : DNA(random_uniforms<GENE_DRAWS>())
+{
+}
+
+DNA::DNA(GeneDraws u) noexcept
+    : perception_radius(uniform_to_range(u[0], 40, 100)),
+      max_speed(uniform_to_range(u[1], 0.75, 3.0)),
       mutation_rate(0.1),
-      reproduction_cost(random_in_range(5, 10.0)),
-      malice_desire(random_in_range(0.01, 0.1)),
-      altruism_desire(random_in_range(0.05, 0.5)),
-      malice_probability(random_in_range(-0.1, 0.05)),
-      altruism_probability(random_in_range(0.0, 0.1)),
-      malice_damage(random_in_range(0.8, 2.0)),
-      altruism_heal(random_in_range(0.8, 2.0)),
-      explosion_chance(random_in_range(0.001, 0.005)),
-      explosion_tries(random_in_range(2, 10)),
-      reproduction_cooldown(random_int(500, 1000)),
-      age_of_maturity(random_int(75, 200)),
-      edge_repulsion(
-          random_int(3 * Vehicle::MAX_FORCE / 2, Vehicle::MAX_FORCE * 5))
+      reproduction_cost(uniform_to_range(u[2], 5, 10.0)),
+      malice_desire(uniform_to_range(u[3], 0.01, 0.1)),
+      altruism_desire(uniform_to_range(u[4], 0.05, 0.5)),
+      malice_probability(uniform_to_range(u[5], -0.1, 0.05)),
+      altruism_probability(uniform_to_range(u[6], 0.0, 0.1)),
+      malice_damage(uniform_to_range(u[7], 0.8, 2.0)),
+      altruism_heal(uniform_to_range(u[8], 0.8, 2.0)),
+      explosion_chance(uniform_to_range(u[9], 0.001, 0.005)),
+      explosion_tries(uniform_to_range(u[10], 2, 10)),
+      reproduction_cooldown(uniform_to_int(u[11], 500, 1000)),
+      age_of_maturity(uniform_to_int(u[12], 75, 200)),
+      edge_repulsion(uniform_to_int(u[13],
+                                    3 * Vehicle::MAX_FORCE / 2,
+                                    Vehicle::MAX_FORCE * 5))
+{
+}
+
+DNA::DNA(RestoreTag) noexcept
 {
 }
 
 [[nodiscard]]
 DNA DNA::crossover(DNA const& partner) const noexcept
 {
-    DNA child;
+    // every gene is overwritten below, no need to draw random ones first
+    DNA  child(restore_tag);
+    auto bits = random_bits();
+    auto mine = [&bits] {
+        bool const pick = (bits & 1) == 0;
+        bits >>= 1;
+        return pick;
+    };
     child.perception_radius =
-        (random_bool()) ? perception_radius : partner.perception_radius;
-    child.max_speed = (random_bool()) ? max_speed : partner.max_speed;
-    child.mutation_rate =
-        (random_bool()) ? mutation_rate : partner.mutation_rate;
+        mine() ? perception_radius : partner.perception_radius;
+    child.max_speed     = mine() ? max_speed : partner.max_speed;
+    child.mutation_rate = mine() ? mutation_rate : partner.mutation_rate;
     child.reproduction_cost =
-        (random_bool()) ? reproduction_cost : partner.reproduction_cost;
+        mine() ? reproduction_cost : partner.reproduction_cost;
     child.reproduction_cooldown =
-        (random_bool()) ? reproduction_cooldown : partner.reproduction_cooldown;
-    child.age_of_maturity =
-        (random_bool()) ? age_of_maturity : partner.age_of_maturity;
-    child.malice_desire =
-        (random_bool()) ? malice_desire : partner.malice_desire;
-    child.altruism_desire =
-        (random_bool()) ? altruism_desire : partner.altruism_desire;
+        mine() ? reproduction_cooldown : partner.reproduction_cooldown;
+    child.age_of_maturity = mine() ? age_of_maturity : partner.age_of_maturity;
+    child.malice_desire   = mine() ? malice_desire : partner.malice_desire;
+    child.altruism_desire = mine() ? altruism_desire : partner.altruism_desire;
     child.malice_probability =
-        (random_bool()) ? malice_probability : partner.malice_probability;
+        mine() ? malice_probability : partner.malice_probability;
     child.altruism_probability =
-        (random_bool()) ? altruism_probability : partner.altruism_probability;
+        mine() ? altruism_probability : partner.altruism_probability;
     child.explosion_chance =
-        (random_bool()) ? explosion_chance : partner.explosion_chance;
-    child.explosion_tries =
-        (random_bool()) ? explosion_tries : partner.explosion_tries;
-    child.malice_damage =
-        (random_bool()) ? malice_damage : partner.malice_damage;
-    child.altruism_heal =
-        (random_bool()) ? altruism_heal : partner.altruism_heal;
-    child.edge_repulsion =
-        random_bool() ? edge_repulsion : partner.edge_repulsion;
+        mine() ? explosion_chance : partner.explosion_chance;
+    child.explosion_tries = mine() ? explosion_tries : partner.explosion_tries;
+    child.malice_damage   = mine() ? malice_damage : partner.malice_damage;
+    child.altruism_heal   = mine() ? altruism_heal : partner.altruism_heal;
+    child.edge_repulsion  = mine() ? edge_repulsion : partner.edge_repulsion;
     return child;
 }
 
 void DNA::mutate() noexcept
 {
-    if (random_in_range(0, 1) < mutation_rate) {
-        perception_radius += random_delta();
-    }
-    if (random_in_range(0, 1) < mutation_rate) {
-        max_speed += random_delta();
-    }
-    if (random_in_range(0, 1) < mutation_rate) {
-        malice_desire += random_delta();
-    }
-    if (random_in_range(0, 1) < mutation_rate) {
-        altruism_desire += random_delta();
-    }
+    mutate(random_uniforms<MUTATION_DRAWS>());
+}
+
+void DNA::mutate(MutationDraws uniforms) noexcept
+{
+    // every gene takes a pair of uniforms: whether it mutates and by how much
+    auto next  = uniforms.begin();
+    auto delta = [&](double scale = 0.1) {
+        double const chance = *next++;
+        double const amount = *next++;
+        return chance < mutation_rate ? uniform_to_range(amount, -scale, scale)
+                                      : 0.0;
+    };
+
+    perception_radius += delta();
+    max_speed += delta();
+    malice_desire += delta();
+    altruism_desire += delta();
 
-    if (random_in_range(0, 1) < mutation_rate) {
-        explosion_chance += random_delta() * 0.1;
-    }
-    if (random_in_range(0, 1) < mutation_rate) {
-        explosion_tries += static_cast<int>(random_delta() * 5);
-    }
+    explosion_chance += delta() * 0.1;
+    explosion_tries += static_cast<int>(delta() * 5);
 
-    if (random_in_range(0, 1) < mutation_rate) {
-        reproduction_cost += random_delta();
-    }
-    if (random_in_range(0, 1) < mutation_rate) {
-        reproduction_cooldown += static_cast<int>(random_delta() * 5);
-    }
-    if (random_in_range(0, 1) < mutation_rate) {
-        age_of_maturity += static_cast<int>(random_delta() * 5);
-    }
-    if (random_in_range(0, 1) < mutation_rate) {
-        malice_probability += random_delta() * 0.1;
-    }
-    if (random_in_range(0, 1) < mutation_rate) {
-        altruism_probability += random_delta() * 0.1;
-    }
-    if (random_in_range(0, 1) < mutation_rate) {
-        malice_damage += random_delta();
-    }
-    if (random_in_range(0, 1) < mutation_rate) {
-        altruism_heal += random_delta();
-    }
-    if (random_in_range(0, 1) < mutation_rate) {
-        edge_repulsion += random_delta(Vehicle::MAX_FORCE / 5);
-    }
+    reproduction_cost += delta();
+    reproduction_cooldown += static_cast<int>(delta() * 5);
+    age_of_maturity += static_cast<int>(delta() * 5);
+    malice_probability += delta() * 0.1;
+    altruism_probability += delta() * 0.1;
+    malice_damage += delta();
+    altruism_heal += delta();
+    edge_repulsion += delta(Vehicle::MAX_FORCE / 5);
 }
 }  // namespace tom
\ No newline at end of file
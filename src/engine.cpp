@@ -0,0 +1,129 @@
+#include "engine.h"
+#include <utility>
+#include "food.h"
+#include "snapshot.h"
+#include "utils.h"
+#include "vehicle.h"
+#include "world.h"
+
+namespace tom {
+
+Engine::Engine(Config const& config)
+{
+    World::edge_threshold = config.edge_threshold;
+    World::poison_chance  = config.poison_chance;
+    Vehicle::MAX_FORCE    = config.max_force;
+    Vehicle::MAX_HEALTH   = config.max_health;
+    set_seed(config.seed);
+
+    state = std::make_unique<World>(config.seed, config.width, config.height);
+    state->disable_night   = config.disable_night;
+    state->max_food        = config.max_food;
+    state->food_pct_chance = config.food_pct_chance;
+    state->populate_world(config.vehicles, config.food);
+    state->enable_workers(config.workers);
+}
+
+Engine::Engine(std::unique_ptr<World> world) : state(std::move(world))
+{
+}
+
+Engine Engine::load(std::string const& path, unsigned workers)
+{
+    Snapshot const snapshot(path);
+    auto const&    header = snapshot.header();
+    auto world = std::make_unique<World>(header.seed, header.width,
+                                         header.height);
+    snapshot.restore(*world);
+    world->enable_workers(workers);
+    return Engine(std::move(world));
+}
+
+Engine::Engine(Engine&&) noexcept            = default;
+Engine& Engine::operator=(Engine&&) noexcept = default;
+Engine::~Engine()                            = default;
+
+int Engine::step(int ticks)
+{
+    for (int i = 0; i < ticks; i++) {
+        auto const alive = state->tick();
+        if (hooks->ticked) {
+            hooks->ticked(stats());
+        }
+        if (!alive) {
+            return i + 1;
+        }
+    }
+    return ticks;
+}
+
+Engine::Stats Engine::stats() const noexcept
+{
+    return {.tick     = state->tick_counter,
+            .vehicles = state->vehicles.size(),
+            .food     = state->food.size(),
+            .births   = state->born_counter,
+            .deaths   = state->dead_counter,
+            .max_age  = state->max_age,
+            .day      = state->is_day()};
+}
+
+std::span<VehicleRecord const> Engine::vehicles()
+{
+    vehicle_records.clear();
+    vehicle_records.reserve(state->vehicles.size());
+    for (auto const& [id, vehicle] : state->vehicles) {
+        vehicle_records.push_back(VehicleRecord::capture(vehicle));
+    }
+    return vehicle_records;
+}
+
+std::span<FoodRecord const> Engine::food()
+{
+    food_records.clear();
+    food_records.reserve(state->food.size());
+    for (auto const& [id, item] : state->food) {
+        food_records.push_back(FoodRecord::capture(item));
+    }
+    return food_records;
+}
+
+void Engine::set_hooks(Hooks new_hooks)
+{
+    *hooks = std::move(new_hooks);
+    connect_hooks();
+}
+
+void Engine::save(std::string const& path)
+{
+    Snapshot::save(*state, path);
+}
+
+World& Engine::world() noexcept
+{
+    return *state;
+}
+
+World const& Engine::world() const noexcept
+{
+    return *state;
+}
+
+void Engine::connect_hooks()
+{
+    // the world only pays for the records when someone listens
+    state->on_birth = nullptr;
+    state->on_death = nullptr;
+    if (hooks->born) {
+        state->on_birth = [hooks = hooks.get()](Vehicle const& vehicle) {
+            hooks->born(VehicleRecord::capture(vehicle));
+        };
+    }
+    if (hooks->died) {
+        state->on_death = [hooks = hooks.get()](Vehicle const& vehicle) {
+            hooks->died(VehicleRecord::capture(vehicle));
+        };
+    }
+}
+
+}  // namespace tom
@@ -0,0 +1,183 @@
+#include "entityrecord.h"
+
+#include "food.h"
+#include "vehicle.h"
+
+namespace tom {
+
+DNARecord DNARecord::capture(DNA const& dna) noexcept
+{
+    return DNARecord{
+        .perception_radius     = dna.perception_radius,
+        .max_speed             = dna.max_speed,
+        .mutation_rate         = dna.mutation_rate,
+        .reproduction_cost     = dna.reproduction_cost,
+        .malice_desire         = dna.malice_desire,
+        .altruism_desire       = dna.altruism_desire,
+        .malice_probability    = dna.malice_probability,
+        .altruism_probability  = dna.altruism_probability,
+        .malice_damage         = dna.malice_damage,
+        .altruism_heal         = dna.altruism_heal,
+        .explosion_chance      = dna.explosion_chance,
+        .explosion_tries       = dna.explosion_tries,
+        .reproduction_cooldown = dna.reproduction_cooldown,
+        .age_of_maturity       = dna.age_of_maturity,
+        .edge_repulsion        = dna.edge_repulsion,
+    };
+}
+
+DNA DNARecord::restore() const noexcept
+{
+    DNA dna(restore_tag);
+    dna.perception_radius     = perception_radius;
+    dna.max_speed             = max_speed;
+    dna.mutation_rate         = mutation_rate;
+    dna.reproduction_cost     = reproduction_cost;
+    dna.malice_desire         = malice_desire;
+    dna.altruism_desire       = altruism_desire;
+    dna.malice_probability    = malice_probability;
+    dna.altruism_probability  = altruism_probability;
+    dna.malice_damage         = malice_damage;
+    dna.altruism_heal         = altruism_heal;
+    dna.explosion_chance      = explosion_chance;
+    dna.explosion_tries       = explosion_tries;
+    dna.reproduction_cooldown = reproduction_cooldown;
+    dna.age_of_maturity       = age_of_maturity;
+    dna.edge_repulsion        = edge_repulsion;
+    return dna;
+}
+
+std::array<double, DNARecord::GENES> DNARecord::genes() const noexcept
+{
+    return {perception_radius,     max_speed,
+            mutation_rate,         reproduction_cost,
+            malice_desire,         altruism_desire,
+            malice_probability,    altruism_probability,
+            malice_damage,         altruism_heal,
+            explosion_chance,      explosion_tries,
+            static_cast<double>(reproduction_cooldown),
+            static_cast<double>(age_of_maturity),
+            edge_repulsion};
+}
+
+FoodDNARecord FoodDNARecord::capture(FoodDNA const& dna) noexcept
+{
+    return FoodDNARecord{
+        .nutrition        = dna.nutrition,
+        .lifeticks        = dna.lifeticks,
+        .speed            = dna.speed,
+        .explosionChance  = dna.explosionChance,
+        .explosionCount   = dna.explosionCount,
+        .mutationRate     = dna.mutationRate,
+        .perceptionRadius = dna.perceptionRadius,
+        .fleeChance       = dna.fleeChance,
+        .fleeStrength     = dna.fleeStrength,
+    };
+}
+
+FoodDNA FoodDNARecord::restore() const noexcept
+{
+    FoodDNA dna(restore_tag);
+    dna.nutrition        = nutrition;
+    dna.lifeticks        = lifeticks;
+    dna.speed            = speed;
+    dna.explosionChance  = explosionChance;
+    dna.explosionCount   = explosionCount;
+    dna.mutationRate     = mutationRate;
+    dna.perceptionRadius = perceptionRadius;
+    dna.fleeChance       = fleeChance;
+    dna.fleeStrength     = fleeStrength;
+    return dna;
+}
+
+VehicleRecord VehicleRecord::capture(Vehicle const& vehicle) noexcept
+{
+    std::uint32_t state = 0;
+    for (auto s : vehicle.behavior_state.options) {
+        state |= static_cast<std::uint32_t>(s);
+    }
+    return VehicleRecord{
+        .id                     = vehicle.id,
+        .last_sought_vehicle_id = vehicle.last_sought_vehicle_id,
+        .last_sought_food_id    = vehicle.last_sought_food_id,
+        .position               = vehicle.position,
+        .velocity               = vehicle.velocity,
+        .acceleration           = vehicle.acceleration,
+        .wander_target          = vehicle.wanderTarget,
+        .health                 = vehicle.health.remaining(),
+        .mass                   = vehicle.mass,
+        .age                    = vehicle.age,
+        .time_since_last_reproduction =
+            vehicle.time_since_last_reproduction,
+        .generation          = vehicle.generation,
+        .behavior_state      = state,
+        .verbose             = vehicle.verbose,
+        .explosion_countdown = vehicle.explosion_countdown,
+        .dna                 = DNARecord::capture(vehicle.dna),
+    };
+}
+
+Vehicle VehicleRecord::restore(World* world) const
+{
+    using State = Vehicle::BehaviorState;
+
+    Vehicle v(restore_tag);
+    v.world                        = world;
+    v.id                           = id;
+    v.last_sought_vehicle_id       = last_sought_vehicle_id;
+    v.last_sought_food_id          = last_sought_food_id;
+    v.position                     = position;
+    v.velocity                     = velocity;
+    v.acceleration                 = acceleration;
+    v.wanderTarget                 = wander_target;
+    v.health                       = Vehicle::LifespanType(health);
+    v.mass                         = mass;
+    v.age                          = age;
+    v.time_since_last_reproduction = time_since_last_reproduction;
+    v.generation                   = generation;
+    v.verbose                      = verbose != 0;
+    v.explosion_countdown          = explosion_countdown;
+    v.dna                          = dna.restore();
+    for (auto s : {State::WANDERING, State::HUNGRY, State::OUTGOING,
+                   State::DESPERATE}) {
+        if (behavior_state & static_cast<std::uint32_t>(s)) {
+            v.behavior_state.add(s);
+        }
+    }
+    return v;
+}
+
+FoodRecord FoodRecord::capture(Food const& food) noexcept
+{
+    return FoodRecord{
+        .id                  = food.id,
+        .position            = food.position,
+        .velocity            = food.velocity,
+        .acceleration        = food.acceleration,
+        .velocity_dampening  = food.velocity_dampening,
+        .lifespan            = food.lifespan.remaining(),
+        .flee_countdown      = food.flee_countdown,
+        .spawn_countdown     = food.spawn_countdown,
+        .explosion_countdown = food.explosion_countdown,
+        .dna                 = FoodDNARecord::capture(food.dna),
+    };
+}
+
+Food FoodRecord::restore(World* world) const
+{
+    Food f(restore_tag);
+    f.world               = world;
+    f.id                  = id;
+    f.position            = position;
+    f.velocity            = velocity;
+    f.acceleration        = acceleration;
+    f.velocity_dampening  = velocity_dampening;
+    f.lifespan            = IntLifespan{lifespan};
+    f.flee_countdown      = flee_countdown;
+    f.spawn_countdown     = spawn_countdown;
+    f.explosion_countdown = explosion_countdown;
+    f.dna                 = dna.restore();
+    return f;
+}
+
+}  // namespace tom
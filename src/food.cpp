@@ -1,8 +1,13 @@
 #include "food.h"
 
+#include <algorithm>
+#include <span>
+#include <vector>
+
 #include "checks.h"
 #include "fooddna.h"
 #include "lifespan.h"
+#include "log.h"
 #include "utils.h"
 #include "vec2d.h"
 #include "vehicle.h"
@@ -23,6 +28,11 @@ bool Environmental::is_expired() const noexcept
 
 Environmental::IdType Environmental::global_id_counter = 1;
 
+Environmental::Environmental(RestoreTag) noexcept
+    : id(0), world(nullptr), position(), lifespan(0)
+{
+}
+
 Food::Food() noexcept
     : Environmental(nullptr, Vec2D::random(100), IntLifespan::random(750, 1500))
 {
@@ -41,6 +51,14 @@ Food::Food(World* world, Vec2D const& pos, FoodDNA const& dna) noexcept
     lifespan = IntLifespan{(int) dna.lifeticks};
 }
 
+Food::Food(RestoreTag) noexcept
+    : Environmental(restore_tag),
+      velocity_dampening(0.0),
+      dna(restore_tag),
+      velocity()
+{
+}
+
 bool Food::can_see(Vec2D const& position) const noexcept
 {
     auto d = Food::position.distance_to(position);
@@ -50,7 +68,7 @@ bool Food::can_see(Vec2D const& position) const noexcept
 void Food::try_flee(Vehicle const& source) noexcept
 {
     // TODO: is this better ?give chance every second not every tick
-    if (random_in_range(0, 1) < (dna.fleeChance / World::target_tps)) {
+    if (flee_countdown.trial(dna.fleeChance / World::target_tps)) {
         auto force = Vec2D::flee_force(source.position, position, velocity,
                                        dna.fleeStrength);
         apply_force(force);
@@ -76,6 +94,15 @@ void Food::behaviors(World::Vehicles const& vehicles)
     }
 }
 
+void Food::behaviors(World::VehicleRefs const& vehicles)
+{
+    for (auto const& [id, v] : vehicles) {
+        if (can_see(v->position)) {
+            try_flee(*v);
+        }
+    }
+}
+
 [[nodiscard]]
 double Food::get_nutrition() const noexcept
 {
@@ -113,8 +140,9 @@ void Food::update() noexcept
     avoid_edges();
 
     if (lifespan.remaining() < 10 &&
-        random_in_range(0, 1) < dna.explosionChance) {
-        world->delay([this](auto* world) { this->perform_explosion(world); });
+        explosion_countdown.trial(dna.explosionChance)) {
+        world->delay([this](auto* world) { this->perform_explosion(world); },
+                     "food_explosion");
         lifespan.expire();
         return;
     }
@@ -123,8 +151,9 @@ void Food::update() noexcept
         // dont let the poison food create more food
         // TODO: feels hacky, maybe subclass Environmental for poison but world
         // has only a map of Food
-        if (world->should_spawn_food()) {
-            world->delay([this](auto* world) { this->perform_spawn(world); });
+        if (world->should_spawn_food(spawn_countdown)) {
+            world->delay([this](auto* world) { this->perform_spawn(world); },
+                         "food_spawn");
         }
     }
     lifespan.update();
@@ -145,33 +174,39 @@ void Food::consume(Vehicle& consumer) noexcept
     consumer.health += (Vehicle::MAX_HEALTH * dna.nutrition) /
                        decltype(consumer.health)::tick_amount;
     if (consumer.verbose)
-        output("Was eaten by Vehicle ID: ", consumer.id,
-               " at position: ", consumer.get_position(),
-               " | Nutrition: ", dna.nutrition, " for ",
-               (Vehicle::MAX_HEALTH * dna.nutrition), "health.\n");
+        log_message(LogLevel::INFO, "Was eaten by Vehicle ID: ", consumer.id,
+                    " at position: ", consumer.get_position(),
+                    " | Nutrition: ", dna.nutrition, " for ",
+                    (Vehicle::MAX_HEALTH * dna.nutrition), "health.");
     lifespan.expire();
 }
 
 void Food::perform_explosion(World* world) const
 {
     GUARD(world->food.size() < world->max_food);
-    for (int i = this->dna.explosionCount; i > 0; i--) {
-        Food& f = world->new_food(this->position, this->get_nutrition());
-        f.dna   = this->dna;
-        f.dna.mutate();
-        if (random_in_range(0, 1) < this->dna.mutationRate) {
-            f.dna.nutrition *= -random_in_range(1.0, 3.0);
-        }
+    auto const count = std::max(0, static_cast<int>(dna.explosionCount));
+    // the whole litter draws its random numbers in one go
+    std::vector<double> uniforms(static_cast<std::size_t>(count) * SPAWN_DRAWS);
+    random_fill(uniforms);
+    for (auto draws = std::span<double const>(uniforms); !draws.empty();
+         draws      = draws.subspan(SPAWN_DRAWS)) {
+        spawn(world, draws.first<SPAWN_DRAWS>());
     }
 }
 
 void Food::perform_spawn(World* world) const
+{
+    spawn(world, random_uniforms<SPAWN_DRAWS>());
+}
+
+void Food::spawn(World* world, SpawnDraws uniforms) const
 {
     Food& f = world->new_food(position, this->get_nutrition());
     f.dna   = this->dna;
-    f.dna.mutate();
-    if (random_in_range(0, 1) < f.dna.mutationRate) {
-        f.dna.nutrition *= -random_in_range(1.0, 3.0);
+    f.dna.mutate(uniforms.first<FoodDNA::MUTATION_DRAWS>());
+    if (uniforms[FoodDNA::MUTATION_DRAWS] < f.dna.mutationRate) {
+        f.dna.nutrition *=
+            -uniform_to_range(uniforms[FoodDNA::MUTATION_DRAWS + 1], 1.0, 3.0);
     }
 }
 }  // namespace tom
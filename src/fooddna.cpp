@@ -2,13 +2,17 @@
 #include "utils.h"
 
 namespace tom {
-FoodDNA::FoodDNA()
+FoodDNA::FoodDNA() : FoodDNA(random_uniforms<GENE_DRAWS>())
+{
+}
+
+FoodDNA::FoodDNA(GeneDraws u) noexcept
     // nutrition is now a percentage of max health not an absolute value
-    : nutrition(random_in_range(0.05, 0.2)),
-      lifeticks(random_in_range(300, 1000)),
-      speed(random_in_range(1, 3)),
-      explosionChance(random_in_range(0.01, 0.1)),
-      explosionCount(random_in_range(5, 15)),
+    : nutrition(uniform_to_range(u[0], 0.05, 0.2)),
+      lifeticks(uniform_to_range(u[1], 300, 1000)),
+      speed(uniform_to_range(u[2], 1, 3)),
+      explosionChance(uniform_to_range(u[3], 0.01, 0.1)),
+      explosionCount(uniform_to_range(u[4], 5, 15)),
       mutationRate(0.1),
       perceptionRadius(50),
       fleeChance(0.1),
@@ -16,49 +20,57 @@ FoodDNA::FoodDNA()
 {
 }
 
+FoodDNA::FoodDNA(RestoreTag) noexcept
+{
+}
+
 FoodDNA FoodDNA::crossover(FoodDNA const& other) const noexcept
 {
-    FoodDNA child;
-    child.nutrition = random_bool() ? nutrition : other.nutrition;
-    child.lifeticks = random_bool() ? lifeticks : other.lifeticks;
-    child.speed     = random_bool() ? speed : other.speed;
-    child.explosionChance =
-        random_bool() ? explosionChance : other.explosionChance;
-    child.explosionCount =
-        random_bool() ? explosionCount : other.explosionCount;
+    // every gene is overwritten below, no need to draw random ones first
+    FoodDNA child(restore_tag);
+    auto    bits = random_bits();
+    auto    mine = [&bits] {
+        bool const pick = (bits & 1) == 0;
+        bits >>= 1;
+        return pick;
+    };
+    child.nutrition       = mine() ? nutrition : other.nutrition;
+    child.lifeticks       = mine() ? lifeticks : other.lifeticks;
+    child.speed           = mine() ? speed : other.speed;
+    child.explosionChance = mine() ? explosionChance : other.explosionChance;
+    child.explosionCount  = mine() ? explosionCount : other.explosionCount;
+    child.mutationRate    = mutationRate;
     child.perceptionRadius =
-        random_bool() ? perceptionRadius : other.perceptionRadius;
-    child.fleeChance   = random_bool() ? fleeChance : other.fleeChance;
-    child.fleeStrength = random_bool() ? fleeStrength : other.fleeStrength;
+        mine() ? perceptionRadius : other.perceptionRadius;
+    child.fleeChance   = mine() ? fleeChance : other.fleeChance;
+    child.fleeStrength = mine() ? fleeStrength : other.fleeStrength;
     return child;
 }
 
 void FoodDNA::mutate() noexcept
 {
-    if (random_in_range(0, 1) < mutationRate) {
-        nutrition += random_delta(0.01);
-    }
-    if (random_in_range(0, 1) < mutationRate) {
-        lifeticks += random_delta(20);
-    }
-    if (random_in_range(0, 1) < mutationRate) {
-        speed += random_delta(0.01);
-    }
-    if (random_in_range(0, 1) < mutationRate) {
-        explosionChance += random_delta(0.02);
-    }
-    if (random_in_range(0, 1) < mutationRate) {
-        explosionCount += random_delta(1);
-    }
-    if (random_in_range(0, 1) < mutationRate) {
-        perceptionRadius += random_delta(2);
-    }
-    if (random_in_range(0, 1) < mutationRate) {
-        fleeChance += random_delta(0.01);
-    }
-    if (random_in_range(0, 1) < mutationRate) {
-        fleeStrength += random_delta(0.1);
-    }
+    mutate(random_uniforms<MUTATION_DRAWS>());
+}
+
+void FoodDNA::mutate(MutationDraws uniforms) noexcept
+{
+    // every gene takes a pair of uniforms: whether it mutates and by how much
+    auto next  = uniforms.begin();
+    auto delta = [&](double scale) {
+        double const chance = *next++;
+        double const amount = *next++;
+        return chance < mutationRate ? uniform_to_range(amount, -scale, scale)
+                                     : 0.0;
+    };
+
+    nutrition += delta(0.01);
+    lifeticks += delta(20);
+    speed += delta(0.01);
+    explosionChance += delta(0.02);
+    explosionCount += delta(1);
+    perceptionRadius += delta(2);
+    fleeChance += delta(0.01);
+    fleeStrength += delta(0.1);
 }
 
 }  // namespace tom
@@ -0,0 +1,337 @@
+#include "history.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <numbers>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include "checks.h"
+#include "food.h"
+#include "snapshot.h"
+#include "utils.h"
+#include "vehicle.h"
+#include "world.h"
+
+namespace tom {
+
+namespace {
+
+// finest position step kept; worlds too large for 16 bits get coarser ones
+constexpr double FINEST_STEP = 1.0 / 8.0;
+
+constexpr std::uint64_t key_of(History::Sprite const& sprite) noexcept
+{
+    return sprite.id << 1 | static_cast<std::uint64_t>(sprite.vehicle);
+}
+
+// anything that strayed off the world is kept on its edge
+std::uint16_t quantize(double position, double step) noexcept
+{
+    return static_cast<std::uint16_t>(
+        std::clamp(std::lround(position / step), 0L, 0xFFFFL));
+}
+
+std::uint8_t size_of(double size) noexcept
+{
+    return static_cast<std::uint8_t>(
+        std::clamp(std::lround(size), 0L, long{History::MAX_SIZE}));
+}
+
+}  // namespace
+
+std::size_t History::Frame::bytes() const noexcept
+{
+    return sizeof(Frame) + deaths.size() * sizeof(std::uint32_t) +
+           births.size() * sizeof(Sprite) + moves.size() * sizeof(Move);
+}
+
+History::History(World const& world, Config config)
+    : config(config),
+      step(std::max(FINEST_STEP, std::max(world.width, world.height) /
+                                     static_cast<double>(0xFFFF)))
+{
+    REQUIRE(config.keyframe_ticks > 0);
+}
+
+void History::record(World& world)
+{
+    if (!keyframes.empty() && world.tick_counter == last_tick()) {
+        return;
+    }
+    if (keyframes.empty() || world.tick_counter != last_tick() + 1 ||
+        world.tick_counter - keyframes.back().tick >= config.keyframe_ticks) {
+        add_keyframe(world);
+    } else {
+        auto& keyframe = keyframes.back();
+        keyframe.frames.push_back(diff(world));
+        keyframe.bytes += keyframe.frames.back().bytes();
+        bytes          += keyframe.frames.back().bytes();
+    }
+    trim();
+}
+
+void History::record(Command const& command)
+{
+    if (rewinding || keyframes.empty()) {
+        return;
+    }
+    keyframes.back().commands.push_back(command);
+    keyframes.back().bytes += sizeof(Command);
+    bytes                  += sizeof(Command);
+}
+
+int History::first_tick() const noexcept
+{
+    return keyframes.empty() ? 0 : keyframes.front().tick;
+}
+
+int History::last_tick() const noexcept
+{
+    if (keyframes.empty()) {
+        return 0;
+    }
+    auto const& keyframe = keyframes.back();
+    return keyframe.tick + static_cast<int>(keyframe.frames.size());
+}
+
+std::vector<History::Sprite> History::view(int tick) const
+{
+    REQUIRE(!keyframes.empty() && tick >= first_tick() &&
+            tick <= last_tick());
+
+    auto const& keyframe = *std::prev(
+        std::ranges::upper_bound(keyframes, tick, {}, &Keyframe::tick));
+    auto sprites = keyframe.sprites;
+    for (auto const& frame :
+         keyframe.frames | std::views::take(tick - keyframe.tick)) {
+        apply(frame, sprites);
+    }
+    return sprites;
+}
+
+Vec2D History::position_of(Sprite const& sprite) const noexcept
+{
+    return {sprite.x * step, sprite.y * step};
+}
+
+std::size_t History::memory_use() const noexcept
+{
+    return bytes;
+}
+
+void History::rewind(World& world, int tick)
+{
+    REQUIRE(!keyframes.empty() && tick >= first_tick() &&
+            tick <= last_tick());
+
+    while (keyframes.back().tick > tick) {
+        bytes -= keyframes.back().bytes;
+        keyframes.pop_back();
+    }
+    auto& keyframe = keyframes.back();
+
+    Snapshot(std::span<std::byte const>(keyframe.snapshot)).restore(world);
+
+    // the commands stay where they are in case the same tick is wanted again
+    rewinding    = true;
+    auto command = keyframe.commands.begin();
+    while (world.tick_counter < tick) {
+        for (; command != keyframe.commands.end() &&
+               static_cast<int>(command->tick) == world.tick_counter;
+             ++command) {
+            world.issue(*command);
+        }
+        world.tick();
+    }
+    rewinding = false;
+
+    // whatever happened after tick did not happen anymore
+    for (auto const& frame :
+         keyframe.frames | std::views::drop(tick - keyframe.tick)) {
+        keyframe.bytes -= frame.bytes();
+        bytes          -= frame.bytes();
+    }
+    keyframe.frames.resize(tick - keyframe.tick);
+    auto const later = std::ranges::count_if(keyframe.commands, [&](auto& c) {
+        return static_cast<int>(c.tick) >= tick;
+    });
+    keyframe.commands.resize(keyframe.commands.size() - later);
+    keyframe.bytes -= later * sizeof(Command);
+    bytes          -= later * sizeof(Command);
+
+    remember(view(tick));
+}
+
+void History::add_keyframe(World& world)
+{
+    Keyframe keyframe{.tick     = world.tick_counter,
+                      .snapshot = Snapshot::capture(world),
+                      .sprites  = sprites_of(world),
+                      .frames   = {},
+                      .commands = {}};
+    keyframe.bytes = sizeof(Keyframe) + keyframe.snapshot.size() +
+                     keyframe.sprites.size() * sizeof(Sprite);
+    bytes += keyframe.bytes;
+
+    remember(keyframe.sprites);
+    keyframes.push_back(std::move(keyframe));
+}
+
+History::Frame History::diff(World const& world)
+{
+    Frame               frame;
+    std::vector<Sprite> next;
+    next.reserve(world.vehicles.size() + world.food.size());
+
+    auto const now = [&](Sprite const& sprite) -> std::optional<Sprite> {
+        if (sprite.vehicle) {
+            auto const found = world.vehicles.find(sprite.id);
+            if (found != world.vehicles.end()) {
+                return sprite_of(found->first, found->second);
+            }
+        } else {
+            auto const found = world.food.find(sprite.id);
+            if (found != world.food.end()) {
+                return sprite_of(found->first, found->second);
+            }
+        }
+        return std::nullopt;
+    };
+
+    // survivors keep their order and are described by how they changed;
+    // those that jumped further than a Move can tell are born again
+    for (std::uint32_t i = 0; i < current.size(); i++) {
+        auto const& then   = current[i];
+        auto const  sprite = now(then);
+        if (!sprite) {
+            frame.deaths.push_back(i);
+            continue;
+        }
+        auto const dx = sprite->x - then.x;
+        auto const dy = sprite->y - then.y;
+        if (dx < INT8_MIN || dx > INT8_MAX || dy < INT8_MIN || dy > INT8_MAX) {
+            frame.deaths.push_back(i);
+            frame.births.push_back(*sprite);
+            continue;
+        }
+        if (dx != 0 || dy != 0 || sprite->heading != then.heading ||
+            sprite->size != then.size || sprite->look != then.look) {
+            frame.moves.push_back(
+                {.index         = static_cast<std::uint32_t>(next.size()),
+                 .dx            = static_cast<std::int8_t>(dx),
+                 .dy            = static_cast<std::int8_t>(dy),
+                 .heading       = sprite->heading,
+                 .look_and_size = static_cast<std::uint8_t>(
+                     sprite->look << 4 | sprite->size)});
+        }
+        next.push_back(*sprite);
+    }
+
+    for (auto const& [id, vehicle] : world.vehicles) {
+        if (!known.contains(id << 1 | 1)) {
+            frame.births.push_back(sprite_of(id, vehicle));
+        }
+    }
+    for (auto const& [id, food] : world.food) {
+        if (!known.contains(id << 1)) {
+            frame.births.push_back(sprite_of(id, food));
+        }
+    }
+
+    next.insert(next.end(), frame.births.begin(), frame.births.end());
+    remember(std::move(next));
+    return frame;
+}
+
+void History::apply(Frame const& frame, std::vector<Sprite>& sprites)
+{
+    auto death = frame.deaths.begin();
+    auto kept  = sprites.begin();
+    for (std::uint32_t i = 0; i < sprites.size(); i++) {
+        if (death != frame.deaths.end() && *death == i) {
+            ++death;
+        } else {
+            *kept++ = sprites[i];
+        }
+    }
+    sprites.erase(kept, sprites.end());
+    sprites.insert(sprites.end(), frame.births.begin(), frame.births.end());
+
+    for (auto const& move : frame.moves) {
+        auto& sprite   = sprites[move.index];
+        sprite.x       = static_cast<std::uint16_t>(sprite.x + move.dx);
+        sprite.y       = static_cast<std::uint16_t>(sprite.y + move.dy);
+        sprite.heading = move.heading;
+        sprite.look    = move.look_and_size >> 4;
+        sprite.size    = move.look_and_size & 0xF;
+    }
+}
+
+History::Sprite History::sprite_of(std::uint64_t  id,
+                                   Vehicle const& vehicle) const noexcept
+{
+    using State = Vehicle::BehaviorState;
+
+    std::uint8_t look = 0;
+    for (auto state : {State::WANDERING, State::HUNGRY, State::OUTGOING,
+                       State::DESPERATE}) {
+        if (vehicle.feels(state)) {
+            look |= static_cast<std::uint8_t>(state);
+        }
+    }
+    auto const turns = vehicle.get_velocity().heading() / std::numbers::pi / 2;
+    return {.id      = id,
+            .x       = quantize(vehicle.get_position().x, step),
+            .y       = quantize(vehicle.get_position().y, step),
+            .heading = static_cast<std::uint8_t>(std::lround(turns * 256)),
+            .size    = size_of(remap(vehicle.get_health().remaining(), 0.0,
+                                     20.0, 4.0, 10.0)),
+            .look    = look,
+            .vehicle = true};
+}
+
+History::Sprite History::sprite_of(std::uint64_t id,
+                                   Food const&   food) const noexcept
+{
+    return {.id      = id,
+            .x       = quantize(food.position.x, step),
+            .y       = quantize(food.position.y, step),
+            .heading = 0,
+            .size    = size_of(remap(food.dna.nutrition, 1.0, 50.0, 5.0, 15.0)),
+            .look    = static_cast<std::uint8_t>(food.dna.nutrition < 0),
+            .vehicle = false};
+}
+
+std::vector<History::Sprite> History::sprites_of(World const& world) const
+{
+    std::vector<Sprite> sprites;
+    sprites.reserve(world.vehicles.size() + world.food.size());
+    for (auto const& [id, vehicle] : world.vehicles) {
+        sprites.push_back(sprite_of(id, vehicle));
+    }
+    for (auto const& [id, food] : world.food) {
+        sprites.push_back(sprite_of(id, food));
+    }
+    return sprites;
+}
+
+void History::remember(std::vector<Sprite> sprites)
+{
+    current = std::move(sprites);
+    known.clear();
+    for (auto const& sprite : current) {
+        known.insert(key_of(sprite));
+    }
+}
+
+void History::trim()
+{
+    while (bytes > config.memory_budget && keyframes.size() > 1) {
+        bytes -= keyframes.front().bytes;
+        keyframes.pop_front();
+    }
+}
+
+}  // namespace tom
@@ -0,0 +1,29 @@
+#include "log.h"
+#include <utility>
+
+namespace tom {
+
+namespace {
+
+LogSink sink;
+
+}  // namespace
+
+void set_log_sink(LogSink new_sink)
+{
+    sink = std::move(new_sink);
+}
+
+bool has_log_sink() noexcept
+{
+    return static_cast<bool>(sink);
+}
+
+void write_log(LogLevel level, std::string_view message)
+{
+    if (sink) {
+        sink(level, message);
+    }
+}
+
+}  // namespace tom
@@ -1,14 +1,35 @@
+#include <chrono>
+#include <csignal>
 #include <cstdlib>
+#include <exception>
 #include <iostream>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 #ifdef NOGUI
 #include "consolerenderer.h"
 #else
 #include <FL/Fl.H>
 #include "ui/fltkrenderer.h"
 #endif
+#include "checkpointer.h"
+#include "command.h"
 #include "food.h"
+#include "history.h"
 #include "irenderer.h"
+#include "log.h"
+#include "metrics.h"
+#include "metricsserver.h"
+#include "nullrenderer.h"
+#include "scenario.h"
+#include "shard.h"
+#include "snapshot.h"
+#include "sweep.h"
+#include "timeline.h"
+#include "trace.h"
 #include "utils.h"
 #include "vehicle.h"
 #include "windows_shim.h"
@@ -17,6 +38,9 @@
 struct arguments {
     double food_pct_chance   = 35.0;
     double edge_threshold    = 20.0;
+    double poison_chance     = 0.1;
+    double max_force         = 0.45;
+    double max_health        = 45.0;
     int    width             = 800;
     int    height            = 600;
     int    starting_vehicles = 20;
@@ -27,14 +51,258 @@ struct arguments {
     float  scale_factor      = 1.0f;
     bool   unlimited_tps     = false;
     bool   do_night_time     = true;
+    int    shards            = 0;
+    int    workers           = 0;
+    // fills the new world instead of World::populate_world()
+    tom::Scenario const* scenario = tom::scenarios().data();
+    // command log to write, or to read and run instead of a live simulation
+    std::string record;
+    std::string replay;
+    // snapshot to continue instead of creating a new world
+    std::string load;
+    // state hashes to write for --ticks ticks, or to check this build against
+    std::string trace;
+    std::string check_trace;
+    int         ticks = 0;
+    // Chrome trace events of what every thread did, see tom::Timeline
+    std::string timeline;
+    // the numbers of the run over time, see tom::Metrics
+    std::string        metrics;
+    tom::Metrics::Tier metrics_every = tom::Metrics::Tier::SECOND;
+    // a port of localhost or a Unix socket to scrape counters from
+    std::string serve_metrics;
+    // no renderer at all, until --ticks or --seconds run out (if given)
+    bool   headless = false;
+    double seconds  = 0.0;
+    // many headless runs over ranges of the world options, see tom::sweep
+    std::string                        sweep;
+    std::vector<tom::sweep::Parameter> sweep_parameters;
+    int                                sweep_seeds   = 1;
+    int                                sweep_samples = 0;
+    unsigned                           jobs          = 0;
+
+    // ... or a search of those ranges for the best settings
+    std::string           optimize;
+    tom::sweep::Objective objective   = tom::sweep::Objective::SURVIVAL;
+    int                   generations = 20;
+    int                   population  = 0;
+    // periodic checkpoints, see tom::Checkpointer
+    std::string checkpoint_dir;
+    int         checkpoint_ticks   = 0;
+    double      checkpoint_seconds = 0.0;
+    int         checkpoint_keep    = 3;
+    bool        resume             = false;
+    // the past kept for rewinding in the viewer, see tom::History
+    int history_mb     = 256;
+    int keyframe_ticks = 100;
+};
+
+// long options have no single character form, so they are numbered past char
+enum long_option {
+    OPT_SHARDS = 256,
+    OPT_WORKERS,
+    OPT_RECORD,
+    OPT_REPLAY,
+    OPT_LOAD,
+    OPT_CHECKPOINT,
+    OPT_CHECKPOINT_TICKS,
+    OPT_CHECKPOINT_SECONDS,
+    OPT_CHECKPOINT_KEEP,
+    OPT_RESUME,
+    OPT_HISTORY_MB,
+    OPT_KEYFRAME_TICKS,
+    OPT_TRACE,
+    OPT_CHECK_TRACE,
+    OPT_TICKS,
+    OPT_HEADLESS,
+    OPT_SECONDS,
+    OPT_SWEEP,
+    OPT_SWEEP_PARAM,
+    OPT_SWEEP_SEEDS,
+    OPT_SWEEP_SAMPLES,
+    OPT_JOBS,
+    OPT_OPTIMIZE,
+    OPT_OBJECTIVE,
+    OPT_GENERATIONS,
+    OPT_POPULATION,
+    OPT_POISON_CHANCE,
+    OPT_MAX_FORCE,
+    OPT_MAX_HEALTH,
+    OPT_SCENARIO,
+    OPT_TIMELINE,
+    OPT_METRICS,
+    OPT_METRICS_EVERY,
+    OPT_SERVE_METRICS
+};
+
+static option_shim const long_options[] = {
+    {"shards", 1, OPT_SHARDS},
+    {"workers", 1, OPT_WORKERS},
+    {"record", 1, OPT_RECORD},
+    {"replay", 1, OPT_REPLAY},
+    {"load", 1, OPT_LOAD},
+    {"checkpoint", 1, OPT_CHECKPOINT},
+    {"checkpoint-ticks", 1, OPT_CHECKPOINT_TICKS},
+    {"checkpoint-seconds", 1, OPT_CHECKPOINT_SECONDS},
+    {"checkpoint-keep", 1, OPT_CHECKPOINT_KEEP},
+    {"resume", 0, OPT_RESUME},
+    {"history-mb", 1, OPT_HISTORY_MB},
+    {"keyframe-ticks", 1, OPT_KEYFRAME_TICKS},
+    {"trace", 1, OPT_TRACE},
+    {"check-trace", 1, OPT_CHECK_TRACE},
+    {"ticks", 1, OPT_TICKS},
+    {"headless", 0, OPT_HEADLESS},
+    {"seconds", 1, OPT_SECONDS},
+    {"sweep", 1, OPT_SWEEP},
+    {"sweep-param", 1, OPT_SWEEP_PARAM},
+    {"sweep-seeds", 1, OPT_SWEEP_SEEDS},
+    {"sweep-samples", 1, OPT_SWEEP_SAMPLES},
+    {"jobs", 1, OPT_JOBS},
+    {"optimize", 1, OPT_OPTIMIZE},
+    {"objective", 1, OPT_OBJECTIVE},
+    {"generations", 1, OPT_GENERATIONS},
+    {"population", 1, OPT_POPULATION},
+    {"poison-chance", 1, OPT_POISON_CHANCE},
+    {"max-force", 1, OPT_MAX_FORCE},
+    {"max-health", 1, OPT_MAX_HEALTH},
+    {"scenario", 1, OPT_SCENARIO},
+    {"timeline", 1, OPT_TIMELINE},
+    {"metrics", 1, OPT_METRICS},
+    {"metrics-every", 1, OPT_METRICS_EVERY},
+    {"serve-metrics", 1, OPT_SERVE_METRICS},
+    {nullptr, 0, 0},
 };
 
 arguments parse_args(int argc, char const* argv[])
 {
     arguments args;
     int       c;
-    while ((c = getopt_shim(argc, argv, "uz:w:h:s:c:pr:e:f:x:nq")) != -1) {
+    while ((c = getopt_long_shim(argc, argv, "uz:w:h:s:c:pr:e:f:x:nq",
+                                 long_options)) != -1) {
         switch (c) {
+            case OPT_SHARDS:
+                args.shards = std::stoi(optarg_shim);
+                break;
+            case OPT_WORKERS:
+                args.workers = std::stoi(optarg_shim);
+                break;
+            case OPT_RECORD:
+                args.record = optarg_shim;
+                break;
+            case OPT_REPLAY:
+                args.replay = optarg_shim;
+                break;
+            case OPT_LOAD:
+                args.load = optarg_shim;
+                break;
+            case OPT_CHECKPOINT:
+                args.checkpoint_dir = optarg_shim;
+                break;
+            case OPT_CHECKPOINT_TICKS:
+                args.checkpoint_ticks = std::stoi(optarg_shim);
+                break;
+            case OPT_CHECKPOINT_SECONDS:
+                args.checkpoint_seconds = std::stod(optarg_shim);
+                break;
+            case OPT_CHECKPOINT_KEEP:
+                args.checkpoint_keep = std::stoi(optarg_shim);
+                break;
+            case OPT_RESUME:
+                args.resume = true;
+                break;
+            case OPT_HISTORY_MB:
+                args.history_mb = std::stoi(optarg_shim);
+                break;
+            case OPT_KEYFRAME_TICKS:
+                args.keyframe_ticks = std::stoi(optarg_shim);
+                break;
+            case OPT_TRACE:
+                args.trace = optarg_shim;
+                break;
+            case OPT_CHECK_TRACE:
+                args.check_trace = optarg_shim;
+                break;
+            case OPT_TICKS:
+                args.ticks = std::stoi(optarg_shim);
+                break;
+            case OPT_HEADLESS:
+                args.headless = true;
+                break;
+            case OPT_SECONDS:
+                args.seconds = std::stod(optarg_shim);
+                break;
+            case OPT_SWEEP:
+                args.sweep = optarg_shim;
+                break;
+            case OPT_SWEEP_PARAM:
+                try {
+                    args.sweep_parameters.push_back(
+                        tom::sweep::parse_parameter(optarg_shim));
+                } catch (std::exception const& e) {
+                    std::cerr << e.what() << "\n";
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case OPT_SWEEP_SEEDS:
+                args.sweep_seeds = std::stoi(optarg_shim);
+                break;
+            case OPT_SWEEP_SAMPLES:
+                args.sweep_samples = std::stoi(optarg_shim);
+                break;
+            case OPT_JOBS:
+                args.jobs = static_cast<unsigned>(std::stoi(optarg_shim));
+                break;
+            case OPT_OPTIMIZE:
+                args.optimize = optarg_shim;
+                break;
+            case OPT_OBJECTIVE:
+                try {
+                    args.objective = tom::sweep::parse_objective(optarg_shim);
+                } catch (std::exception const& e) {
+                    std::cerr << e.what() << "\n";
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case OPT_GENERATIONS:
+                args.generations = std::stoi(optarg_shim);
+                break;
+            case OPT_POPULATION:
+                args.population = std::stoi(optarg_shim);
+                break;
+            case OPT_POISON_CHANCE:
+                args.poison_chance = std::stod(optarg_shim);
+                break;
+            case OPT_MAX_FORCE:
+                args.max_force = std::stod(optarg_shim);
+                break;
+            case OPT_MAX_HEALTH:
+                args.max_health = std::stod(optarg_shim);
+                break;
+            case OPT_TIMELINE:
+                args.timeline = optarg_shim;
+                break;
+            case OPT_METRICS:
+                args.metrics = optarg_shim;
+                break;
+            case OPT_SERVE_METRICS:
+                args.serve_metrics = optarg_shim;
+                break;
+            case OPT_METRICS_EVERY:
+                try {
+                    args.metrics_every = tom::Metrics::parse_tier(optarg_shim);
+                } catch (std::exception const& e) {
+                    std::cerr << e.what() << "\n";
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case OPT_SCENARIO:
+                try {
+                    args.scenario = &tom::find_scenario(optarg_shim);
+                } catch (std::exception const& e) {
+                    std::cerr << e.what() << "\n";
+                    exit(EXIT_FAILURE);
+                }
+                break;
             case 'n':
                 args.do_night_time = false;
                 break;
@@ -48,7 +316,7 @@ arguments parse_args(int argc, char const* argv[])
                 args.scale_factor = std::stof(optarg_shim);
                 break;
             case 'e':
-                tom::World::edge_threshold = std::stod(optarg_shim);
+                args.edge_threshold = std::stod(optarg_shim);
                 break;
             case 'c':
                 args.food_pct_chance = std::stod(optarg_shim);
@@ -97,12 +365,85 @@ arguments parse_args(int argc, char const* argv[])
                        "that will prevent more spawning food\n"
                        "    [ -z scale_factor ]        (float) scaling of UI "
                        "(only applicable in FLTK mode)\n"
+                       "    [ --poison-chance p ]      (float) 0-1 chance "
+                       "that new food is poisonous (default 0.1)\n"
+                       "    [ --max-force f ]          (float) strongest "
+                       "steering force of a vehicle (default 0.45)\n"
+                       "    [ --max-health h ]         (float) most health a "
+                       "vehicle can have (default 45)\n"
+                       "    [ --scenario name ]          how to fill the new "
+                       "world: uniform (default), dense_cluster,\n"
+                       "                                 explosion_storm, "
+                       "food_flood or night_swarm\n"
+                       "    [ --shards count ]           (int) split the world "
+                       "into vertical strips, one process each (no UI)\n"
+                       "    [ --workers count ]          (int) split each tick "
+                       "into tiles run by this many threads\n"
+                       "    [ --record file ]            write the seed and "
+                       "every command given through the UI to file\n"
+                       "    [ --replay file ]            run a recorded "
+                       "simulation again without UI, as fast as possible\n"
+                       "    [ --load file ]              continue the world "
+                       "saved in a snapshot (ignores the world options)\n"
+                       "    [ --trace file ]             write the state hash "
+                       "of every tick to file, without UI\n"
+                       "    [ --ticks n ]                (int) ... for n ticks "
+                       "(default 1000); also ends --headless runs\n"
+                       "    [ --seconds s ]            (float) end --headless "
+                       "runs after s seconds\n"
+                       "    [ --sweep file.csv ]         run headless worlds "
+                       "over the --sweep-param values, one CSV row each\n"
+                       "    [ --sweep-param spec ]       name=first:last:step, "
+                       "name=a,b,c or name=low:high (repeatable)\n"
+                       "    [ --sweep-seeds n ]          (int) ... each with "
+                       "seeds -r to -r + n - 1 (default 1)\n"
+                       "    [ --sweep-samples n ]        (int) ... at n random "
+                       "points instead of the whole grid\n"
+                       "    [ --jobs n ]                 (int) runs at a time "
+                       "(default one per core)\n"
+                       "    [ --optimize file.csv ]      search the "
+                       "--sweep-param ranges for the best settings\n"
+                       "    [ --objective name ]         ... for survival "
+                       "(default), population or stability\n"
+                       "    [ --generations n ]          (int) ... for n "
+                       "generations (default 20)\n"
+                       "    [ --population n ]           (int) ... of n "
+                       "candidates (default 4 + 3 ln params, or --jobs)\n"
+                       "    [ --timeline file.json ]     record what every "
+                       "thread does for chrome://tracing or Perfetto,\n"
+                       "                                 written at the end "
+                       "and on SIGUSR1\n"
+                       "    [ --metrics file ]           write population, "
+                       "genes and TPS over time, as CSV for .csv files,\n"
+                       "                                 else binary\n"
+                       "    [ --metrics-every tier ]     ... one row per "
+                       "tick, second (default) or minute\n"
+                       "    [ --serve-metrics where ]    serve counters to "
+                       "Prometheus on a localhost port or Unix socket\n"
+                       "    [ --check-trace file ]       run a traced world "
+                       "again and report where it diverges\n"
+                       "    [ --checkpoint dir ]         write a snapshot to "
+                       "dir in the background now and then\n"
+                       "    [ --checkpoint-ticks n ]     (int) ... every n "
+                       "ticks\n"
+                       "    [ --checkpoint-seconds s ] (float) ... every s "
+                       "seconds (default 60 without -ticks)\n"
+                       "    [ --checkpoint-keep k ]      (int) number of "
+                       "checkpoints to keep (default 3)\n"
+                       "    [ --history-mb m ]           (int) memory kept for "
+                       "rewinding in the viewer (default 256, 0 for none)\n"
+                       "    [ --keyframe-ticks k ]       (int) ticks between "
+                       "full copies of the world in it (default 100)\n"
                     << "  Boolean options\n"
                        "    [ -p (pause) ]             start the game paused \n"
                        "    [ -u (unlimited_tps) ]     run the game without "
                        "tps limit (normal limit is ~80 tps)\n"
                        "    [ -n (disable night) ]     never allow night to "
-                       "happen during the simulation\n";
+                       "happen during the simulation\n"
+                       "    [ --resume ]               continue from the "
+                       "newest checkpoint in the --checkpoint dir\n"
+                       "    [ --headless ]             run as fast as possible "
+                       "without any output but a summary at the end\n";
                 exit(EXIT_FAILURE);
         }
     }
@@ -134,6 +475,91 @@ arguments parse_args(int argc, char const* argv[])
         std::cerr << "Food spawn chance must be between 0 and 100.\n";
         exit(EXIT_FAILURE);
     }
+    if (args.shards < 0 || args.shards > args.width) {
+        std::cerr << "Shard count must be between 0 and the world width.\n";
+        exit(EXIT_FAILURE);
+    }
+    if (args.workers < 0) {
+        std::cerr << "Worker count must not be negative.\n";
+        exit(EXIT_FAILURE);
+    }
+    if (args.shards > 0 && !(args.record.empty() && args.replay.empty() &&
+                             args.load.empty())) {
+        std::cerr << "Sharded runs cannot be recorded, replayed or loaded.\n";
+        exit(EXIT_FAILURE);
+    }
+    if (args.poison_chance < 0.0 || args.poison_chance > 1.0 ||
+        args.max_force <= 0.0 || args.max_health <= 0.0) {
+        std::cerr << "Poison chance must be between 0 and 1, max force and "
+                     "max health must be positive.\n";
+        exit(EXIT_FAILURE);
+    }
+    if (!(args.sweep.empty() && args.optimize.empty()) &&
+        (args.sweep_seeds < 1 || args.sweep_samples < 0 ||
+         args.generations < 1 || args.population < 0 ||
+         !(args.sweep.empty() || args.optimize.empty()) ||
+         !(args.record.empty() && args.replay.empty() && args.shards == 0 &&
+           args.trace.empty()))) {
+        std::cerr << "A sweep or search needs at least one seed and "
+                     "generation, cannot have negative counts, and cannot be "
+                     "recorded, replayed, sharded or both at once.\n";
+        exit(EXIT_FAILURE);
+    }
+    if (args.ticks < 0 || args.seconds < 0.0) {
+        std::cerr << "Tick count and seconds must not be negative.\n";
+        exit(EXIT_FAILURE);
+    }
+    if (!(args.trace.empty() && args.check_trace.empty()) &&
+        !(args.record.empty() && args.replay.empty() && args.load.empty() &&
+          args.shards == 0)) {
+        std::cerr << "Traced runs cannot be recorded, replayed, loaded or "
+                     "sharded.\n";
+        exit(EXIT_FAILURE);
+    }
+    if (args.scenario != tom::scenarios().data() &&
+        (args.shards > 0 || !args.load.empty() || !args.sweep.empty() ||
+         !args.optimize.empty())) {
+        std::cerr << "Only new worlds of a single process can be filled by a "
+                     "scenario: not sharded, loaded, swept or searched ones.\n";
+        exit(EXIT_FAILURE);
+    }
+    if (!(args.metrics.empty() && args.serve_metrics.empty()) &&
+        !(args.shards == 0 && args.replay.empty() && args.trace.empty() &&
+          args.check_trace.empty() && args.sweep.empty() &&
+          args.optimize.empty())) {
+        std::cerr << "Metrics are only written by runs with a UI or "
+                     "--headless.\n";
+        exit(EXIT_FAILURE);
+    }
+    if (!args.load.empty() && !(args.record.empty() && args.replay.empty())) {
+        std::cerr << "A loaded world cannot be recorded or replayed.\n";
+        exit(EXIT_FAILURE);
+    }
+    if (args.checkpoint_ticks < 0 || args.checkpoint_seconds < 0.0 ||
+        args.checkpoint_keep < 1) {
+        std::cerr << "Checkpoints must be taken at positive intervals and at "
+                     "least one must be kept.\n";
+        exit(EXIT_FAILURE);
+    }
+    if (!args.checkpoint_dir.empty() && args.shards > 0) {
+        std::cerr << "Sharded runs cannot be checkpointed.\n";
+        exit(EXIT_FAILURE);
+    }
+    if (args.resume && (args.checkpoint_dir.empty() || !args.load.empty() ||
+                        !args.replay.empty() || !args.record.empty())) {
+        std::cerr << "--resume needs --checkpoint and no other world to "
+                     "start from.\n";
+        exit(EXIT_FAILURE);
+    }
+    if (args.history_mb < 0 || args.keyframe_ticks < 1) {
+        std::cerr << "History memory must not be negative and keyframes must "
+                     "be at least one tick apart.\n";
+        exit(EXIT_FAILURE);
+    }
+    if (!args.checkpoint_dir.empty() && args.checkpoint_ticks == 0 &&
+        args.checkpoint_seconds == 0.0) {
+        args.checkpoint_seconds = 60.0;
+    }
     return args;
 }
 
@@ -141,32 +567,417 @@ tom::World initialize_world(arguments const& args)
 {
     tom::World::is_paused      = !(args.auto_start);
     tom::World::edge_threshold = args.edge_threshold;
+    tom::World::poison_chance  = args.poison_chance;
+    tom::Vehicle::MAX_FORCE    = args.max_force;
+    tom::Vehicle::MAX_HEALTH   = args.max_health;
     tom::World::unlimited_tps  = args.unlimited_tps;
     tom::World world(args.random_seed, args.width, args.height);
     world.disable_night   = !args.do_night_time;
     world.max_food        = args.max_food;
     world.food_pct_chance = args.food_pct_chance;
-    world.populate_world(args.starting_vehicles, args.start_food);
+    args.scenario->populate(world, args.starting_vehicles, args.start_food);
+    world.enable_workers(static_cast<unsigned>(args.workers));
     return world;
 }
 
-int main(int argc, char const* argv[])
+tom::Snapshot open_snapshot(std::string const& path)
 {
-    tom::ansi::cyan.output("./main.cpp use -q for usage information\n");
-    arguments args = parse_args(argc, argv);
+    try {
+        return tom::Snapshot(path);
+    } catch (std::exception const& e) {
+        std::cerr << e.what() << "\n";
+        exit(EXIT_FAILURE);
+    }
+}
 
-    tom::set_seed(args.random_seed);
+tom::World load_world(arguments const& args)
+{
+    auto const  snapshot = open_snapshot(args.load);
+    auto const& header   = snapshot.header();
+
+    tom::World::is_paused     = !(args.auto_start);
+    tom::World::unlimited_tps = args.unlimited_tps;
+    tom::World world(header.seed, header.width, header.height);
+    snapshot.restore(world);
+    world.enable_workers(static_cast<unsigned>(args.workers));
+    return world;
+}
+
+tom::CommandLog::Header log_header(arguments const& args)
+{
+    return {
+        .seed            = args.random_seed,
+        .width           = args.width,
+        .height          = args.height,
+        .vehicles        = args.starting_vehicles,
+        .food            = args.start_food,
+        .max_food        = static_cast<std::uint32_t>(args.max_food),
+        .workers         = static_cast<std::uint32_t>(args.workers),
+        .food_pct_chance = args.food_pct_chance,
+        .edge_threshold  = args.edge_threshold,
+        .poison_chance   = args.poison_chance,
+        .max_force       = args.max_force,
+        .max_health      = args.max_health,
+        .target_tps      = tom::World::target_tps,
+        .disable_night   = !args.do_night_time,
+        .scenario        = static_cast<std::uint32_t>(
+            args.scenario - tom::scenarios().data()),
+    };
+}
+
+// args for the world header was written for
+arguments with_header(arguments args, tom::CommandLog::Header const& header)
+{
+    args.random_seed       = static_cast<int>(header.seed);
+    args.width             = header.width;
+    args.height            = header.height;
+    args.starting_vehicles = header.vehicles;
+    args.start_food        = header.food;
+    args.max_food          = static_cast<int>(header.max_food);
+    args.food_pct_chance   = header.food_pct_chance;
+    args.edge_threshold    = header.edge_threshold;
+    args.poison_chance     = header.poison_chance;
+    args.max_force         = header.max_force;
+    args.max_health        = header.max_health;
+    args.do_night_time     = header.disable_night == 0;
+    args.auto_start        = true;
+    if (header.scenario >= tom::scenarios().size()) {
+        throw std::runtime_error("Unknown scenario in the header");
+    }
+    args.scenario = &tom::scenarios()[header.scenario];
+    tom::World::target_tps = header.target_tps;
+    return args;
+}
 
+int run_replay(arguments args)
+{
+    tom::CommandLog::Recording recording;
+    try {
+        recording = tom::CommandLog::load(args.replay);
+        args      = with_header(std::move(args), recording.header);
+        // any number of workers ticks alike, but not like no workers at all
+        if (args.workers == 0 || recording.header.workers == 0) {
+            args.workers = static_cast<int>(recording.header.workers);
+        }
+    } catch (std::exception const& e) {
+        std::cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    tom::set_seed(args.random_seed);
     tom::World world = initialize_world(args);
+    tom::replay(world, recording);
+    tom::output("\nReplay ended.\n", world.info_stream("\n").str(), "\n");
+
+    return 0;
+}
+
+int run_trace(arguments const& args)
+{
+    auto world = initialize_world(args);
+    try {
+        tom::trace(world,
+                   {.world = log_header(args),
+                    .ticks = args.ticks > 0 ? args.ticks : 1000},
+                   args.trace);
+    } catch (std::exception const& e) {
+        std::cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    tom::output("\nTraced ", world.tick_counter, " ticks to ", args.trace,
+                "\n");
+    return 0;
+}
+
+int run_check_trace(arguments args)
+{
+    try {
+        auto const header = tom::Trace::read_header(args.check_trace).world;
+        // any number of workers ticks alike, but not like no workers at all
+        if ((args.workers == 0) != (header.workers == 0)) {
+            throw std::runtime_error(
+                args.check_trace + " was traced " +
+                (header.workers == 0 ? "without --workers"
+                                     : "with --workers") +
+                ", and runs " +
+                (header.workers == 0 ? "with" : "without") +
+                " workers never match it; check it " +
+                (header.workers == 0 ? "without --workers"
+                                     : "with --workers N"));
+        }
+        args = with_header(std::move(args), header);
+        tom::set_seed(args.random_seed);
+        auto world = initialize_world(args);
+        if (auto diverged = tom::check_trace(world, args.check_trace)) {
+            std::cerr << "Diverged from " << args.check_trace << " at "
+                      << *diverged << "\n";
+            return EXIT_FAILURE;
+        }
+        tom::output("\nAll ", world.tick_counter + 1, " ticks match ",
+                    args.check_trace, "\n");
+    } catch (std::exception const& e) {
+        std::cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
+
+void run_headless(tom::World& world, arguments const& args)
+{
+    tom::World::unpause();
+    tom::World::unlimited_tps = true;
+
+    auto const first = world.tick_counter;
+    tom::render::NullRenderer renderer(
+        &world, {.ticks = args.ticks, .seconds = args.seconds});
+    world.run(renderer);
 
+    auto const ticks   = world.tick_counter - first;
+    auto const seconds = std::chrono::duration<double>(world.end_time -
+                                                       world.start_time)
+                             .count();
+    std::ostringstream rate;
+    world.tick_rate.write(rate);
+    tom::output("\n", ticks, " ticks in ", seconds, " s (",
+                seconds > 0.0 ? ticks / seconds : 0.0, " ticks/s)\n",
+                rate.str(), "\n");
+}
+
+void run_interactive(tom::World&                       world,
+                     [[maybe_unused]] arguments const& args)
+{
 #ifdef NOGUI
     tom::render::ConsoleRenderer renderer(&world);
 #else
+    // a recording cannot go back in time, so there is nothing to keep then
+    std::unique_ptr<tom::History> history;
+    if (args.history_mb > 0 && args.record.empty()) {
+        auto const budget = static_cast<std::size_t>(args.history_mb) << 20;
+        history = std::make_unique<tom::History>(
+            world, tom::History::Config{.keyframe_ticks = args.keyframe_ticks,
+                                        .memory_budget  = budget});
+        world.history = history.get();
+    }
     tom::render::FLTKRenderer renderer(&world, args.width, args.height,
                                        args.scale_factor);
 #endif
 
     world.run(renderer);
+    world.history = nullptr;
+}
+
+int run_sweep(arguments const& args)
+{
+    tom::sweep::Config config{
+        .parameters      = args.sweep_parameters,
+        .output          = args.optimize.empty() ? args.sweep : args.optimize,
+        .seed            = args.random_seed,
+        .seeds           = args.sweep_seeds,
+        .samples         = args.sweep_samples,
+        .ticks           = args.ticks > 0 ? args.ticks : 5000,
+        .jobs            = args.jobs,
+        .start           = nullptr,
+        .width           = args.width,
+        .height          = args.height,
+        .vehicles        = args.starting_vehicles,
+        .food            = args.start_food,
+        .max_food        = static_cast<unsigned int>(args.max_food),
+        .food_pct_chance = args.food_pct_chance,
+        .edge_threshold  = args.edge_threshold,
+        .poison_chance   = args.poison_chance,
+        .max_force       = args.max_force,
+        .max_health      = args.max_health,
+        .disable_night   = !args.do_night_time,
+    };
+
+    // mapped once here and shared by every forked run
+    std::unique_ptr<tom::Snapshot> start;
+    try {
+        if (!args.load.empty()) {
+            start        = std::make_unique<tom::Snapshot>(args.load);
+            config.start = start.get();
+            auto const& header     = start->header();
+            config.disable_night   = header.disable_night != 0;
+            config.max_food        = header.max_food;
+            config.food_pct_chance = header.food_pct_chance;
+            config.edge_threshold  = header.edge_threshold;
+            config.poison_chance   = header.poison_chance;
+            config.max_force       = header.max_force;
+            config.max_health      = header.max_health;
+        }
+        if (!args.optimize.empty()) {
+            return tom::sweep::optimize(
+                config, {.objective   = args.objective,
+                         .generations = args.generations,
+                         .population  = args.population});
+        }
+        return tom::sweep::run(config);
+    } catch (std::exception const& e) {
+        std::cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+}
+
+void dump_timeline()
+{
+    try {
+        tom::Timeline::stop();
+        tom::Timeline::dump();
+        tom::output("Timeline written\n");
+    } catch (std::exception const& e) {
+        std::cerr << e.what() << "\n";
+    }
+}
+
+int main(int argc, char const* argv[])
+{
+    tom::ansi::cyan.output("./main.cpp use -q for usage information\n");
+    arguments args = parse_args(argc, argv);
+    signal(SIGINT, tom::World::stop_running);
+    tom::set_log_sink([](tom::LogLevel level, std::string_view message) {
+        switch (level) {
+            case tom::LogLevel::STATUS:
+                // written over by the next one
+                tom::output(message, std::string(message.size(), '\b'),
+                            tom::ansi::erase_to_eol);
+                break;
+            case tom::LogLevel::INFO:
+                tom::output(message, "\n");
+                break;
+            case tom::LogLevel::ERROR:
+                std::cerr << message << "\n";
+                break;
+        }
+    });
+    if (!args.timeline.empty()) {
+        tom::Timeline::start(args.timeline);
+        std::atexit(dump_timeline);
+#ifdef SIGUSR1
+        signal(SIGUSR1, [](int) { tom::Timeline::request_dump(); });
+#endif
+    }
+
+    tom::set_seed(args.random_seed);
+
+    if (args.shards > 0) {
+        tom::World::edge_threshold = args.edge_threshold;
+        tom::World::poison_chance  = args.poison_chance;
+        tom::Vehicle::MAX_FORCE    = args.max_force;
+        tom::Vehicle::MAX_HEALTH   = args.max_health;
+        tom::World::unlimited_tps  = args.unlimited_tps;
+        return tom::shard::run_coordinator(tom::shard::Config{
+            .shards          = args.shards,
+            .width           = args.width,
+            .height          = args.height,
+            .seed            = args.random_seed,
+            .vehicles        = args.starting_vehicles,
+            .food            = args.start_food,
+            .max_food        = static_cast<unsigned int>(args.max_food),
+            .food_pct_chance = args.food_pct_chance,
+            .disable_night   = !args.do_night_time,
+        });
+    }
+
+    if (!args.replay.empty()) {
+        return run_replay(std::move(args));
+    }
+    if (!args.trace.empty()) {
+        return run_trace(args);
+    }
+    if (!(args.sweep.empty() && args.optimize.empty())) {
+        return run_sweep(args);
+    }
+    if (!args.check_trace.empty()) {
+        return run_check_trace(std::move(args));
+    }
+
+    if (args.resume) {
+        if (auto latest = tom::Checkpointer::latest(args.checkpoint_dir)) {
+            tom::output("Resuming from ", *latest, "\n");
+            args.load = *latest;
+        } else {
+            tom::output("No checkpoint to resume from, starting a new world\n");
+        }
+    }
+
+    tom::World world =
+        args.load.empty() ? initialize_world(args) : load_world(args);
+
+    std::unique_ptr<tom::CommandLog> log;
+    if (!args.record.empty()) {
+        try {
+            log = std::make_unique<tom::CommandLog>(args.record,
+                                                    log_header(args));
+        } catch (std::exception const& e) {
+            std::cerr << e.what() << "\n";
+            return EXIT_FAILURE;
+        }
+        world.command_log = log.get();
+    }
+
+    std::unique_ptr<tom::Checkpointer> checkpointer;
+    if (!args.checkpoint_dir.empty()) {
+        try {
+            checkpointer = std::make_unique<tom::Checkpointer>(
+                tom::Checkpointer::Config{
+                    .directory     = args.checkpoint_dir,
+                    .every_ticks   = args.checkpoint_ticks,
+                    .every_seconds = args.checkpoint_seconds,
+                    .keep          = args.checkpoint_keep,
+                });
+        } catch (std::exception const& e) {
+            std::cerr << e.what() << "\n";
+            return EXIT_FAILURE;
+        }
+        world.checkpointer = checkpointer.get();
+    }
+
+    std::unique_ptr<tom::Metrics> metrics;
+    if (!args.metrics.empty()) {
+        auto const format = args.metrics.ends_with(".csv")
+                                ? tom::Metrics::Format::CSV
+                                : tom::Metrics::Format::BINARY;
+        try {
+            metrics = std::make_unique<tom::Metrics>(
+                tom::Metrics::Config{.output = args.metrics,
+                                     .format = format,
+                                     .every  = args.metrics_every});
+        } catch (std::exception const& e) {
+            std::cerr << e.what() << "\n";
+            return EXIT_FAILURE;
+        }
+        world.metrics = metrics.get();
+    }
+
+    std::unique_ptr<tom::MetricsServer> metrics_server;
+    if (!args.serve_metrics.empty()) {
+        try {
+            metrics_server =
+                std::make_unique<tom::MetricsServer>(args.serve_metrics);
+        } catch (std::exception const& e) {
+            std::cerr << e.what() << "\n";
+            return EXIT_FAILURE;
+        }
+        metrics_server->publish_now(world);
+        world.metrics_server = metrics_server.get();
+    }
+
+    if (args.headless) {
+        run_headless(world, args);
+    } else {
+        run_interactive(world, args);
+    }
+    if (log) {
+        world.issue({.kind = tom::Command::Kind::END});
+    }
+    // nullptr if writing failed during the run
+    if (world.metrics) {
+        try {
+            world.metrics->finish();
+        } catch (std::exception const& e) {
+            std::cerr << e.what() << "\n";
+        }
+    }
     tom::output("\nSimulation ended.\n", world.info_stream("\n").str(), "\n");
 
     return 0;
@@ -0,0 +1,311 @@
+#include "metrics.h"
+#include <algorithm>
+#include <ostream>
+#include <ranges>
+#include <stdexcept>
+#include <utility>
+#include "entityrecord.h"
+#include "food.h"
+#include "vehicle.h"
+#include "world.h"
+
+namespace tom {
+
+namespace {
+
+constexpr std::array<Vehicle::BehaviorState, Metrics::STATES> BEHAVIORS = {
+    Vehicle::BehaviorState::WANDERING,
+    Vehicle::BehaviorState::HUNGRY,
+    Vehicle::BehaviorState::OUTGOING,
+    Vehicle::BehaviorState::DESPERATE,
+};
+
+constexpr std::array<std::string_view, Metrics::STATES> STATE_NAMES = {
+    "wandering", "hungry", "outgoing", "desperate"};
+
+constexpr std::array<std::string_view, Metrics::TIERS> TIER_NAMES = {
+    "tick", "second", "minute"};
+
+// how long a sample of each tier lasts, in seconds
+constexpr std::array<double, Metrics::TIERS> PERIODS = {0.0, 1.0, 60.0};
+
+template <typename Row>
+void write_row(std::ostream& out, Row const& row)
+{
+    char const* separator = "";
+    for (auto const& value : row) {
+        out << separator << value;
+        separator = ",";
+    }
+    out << "\n";
+}
+
+}  // namespace
+
+Metrics::Metrics(Config config) : config(std::move(config))
+{
+    for (auto& ring : rings) {
+        ring.samples.reserve(this->config.capacity);
+    }
+    if (this->config.output.empty()) {
+        return;
+    }
+
+    out.open(this->config.output, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Could not open " + this->config.output);
+    }
+    if (this->config.format == Format::BINARY) {
+        Header const header{.tier = static_cast<std::uint32_t>(
+                                this->config.every)};
+        out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        return;
+    }
+    std::vector<std::string> columns{"tick",   "ticks",  "seconds",
+                                     "vehicles", "food", "births",
+                                     "deaths", "poison", "tps"};
+    for (auto name : STATE_NAMES) {
+        columns.emplace_back(name);
+    }
+    for (auto name : DNARecord::GENE_NAMES) {
+        columns.push_back(std::string(name) + "_mean");
+        columns.push_back(std::string(name) + "_variance");
+    }
+    write_row(out, columns);
+}
+
+void Metrics::record(World const& world)
+{
+    if (world.tick_counter == last_tick) {
+        return;
+    }
+    auto const now = Clock::now();
+    if (last_tick < 0) {
+        first = now;
+    }
+
+    // rewinding goes back to fewer births and deaths than were counted
+    bool const continues = last_tick >= 0 && world.tick_counter > last_tick;
+    auto       sample    = measure(world);
+    sample.seconds = std::chrono::duration<double>(now - first).count();
+    sample.births  = continues ? world.born_counter - born : 0;
+    sample.deaths  = continues ? world.dead_counter - dead : 0;
+    sample.tps     = world.tps();
+    born           = world.born_counter;
+    dead           = world.dead_counter;
+    last_tick      = world.tick_counter;
+    push(Tier::TICK, sample);
+}
+
+void Metrics::push(Tier tier, Sample const& sample)
+{
+    auto& ring = rings[static_cast<std::size_t>(tier)];
+    if (ring.samples.size() < config.capacity) {
+        ring.samples.push_back(sample);
+    } else if (config.capacity > 0) {
+        ring.samples[ring.next] = sample;
+    }
+    ring.next = config.capacity > 0 ? (ring.next + 1) % config.capacity : 0;
+
+    if (tier == config.every && out.is_open()) {
+        write(sample);
+    }
+    if (tier != Tier::MINUTE) {
+        add(static_cast<Tier>(static_cast<std::size_t>(tier) + 1), sample);
+    }
+}
+
+void Metrics::add(Tier tier, Sample const& sample)
+{
+    auto&        next = pending[static_cast<std::size_t>(tier)];
+    auto&        sums = next.sums;
+    double const w    = sample.ticks;
+
+    sums.tick = sample.tick;
+    sums.ticks += sample.ticks;
+    sums.seconds = sample.seconds;
+    sums.vehicles += w * sample.vehicles;
+    sums.food += w * sample.food;
+    sums.births += sample.births;
+    sums.deaths += sample.deaths;
+    sums.poison += w * sample.poison;
+    for (std::size_t i = 0; i < BEHAVIORS.size(); i++) {
+        sums.states[i] += w * sample.states[i];
+    }
+    // the variance of all of them from the mean of each one's squares,
+    // over every vehicle of every tick
+    double const v = w * sample.vehicles;
+    next.vehicle_ticks += v;
+    for (std::size_t i = 0; i < GENES; i++) {
+        auto const& gene = sample.genes[i];
+        sums.genes[i].mean += v * gene.mean;
+        sums.genes[i].variance += v * (gene.variance + gene.mean * gene.mean);
+    }
+
+    auto const period = PERIODS[static_cast<std::size_t>(tier)];
+    if (next.ends == 0.0) {
+        next.ends = period;
+    }
+    if (sample.seconds < next.ends) {
+        return;
+    }
+    close(tier);
+}
+
+void Metrics::close(Tier tier)
+{
+    auto&      next = pending[static_cast<std::size_t>(tier)];
+    Sample     done = next.sums;
+    auto const n    = static_cast<double>(done.ticks);
+    auto const v    = next.vehicle_ticks;
+    done.vehicles /= n;
+    done.food /= n;
+    done.poison /= n;
+    for (auto& state : done.states) {
+        state /= n;
+    }
+    for (auto& gene : done.genes) {
+        gene.mean     = v > 0.0 ? gene.mean / v : 0.0;
+        gene.variance = v > 0.0 ? std::max(0.0, gene.variance / v -
+                                                    gene.mean * gene.mean)
+                                : 0.0;
+    }
+    done.tps = done.seconds > next.started
+                   ? n / (done.seconds - next.started)
+                   : 0.0;
+
+    auto const period  = PERIODS[static_cast<std::size_t>(tier)];
+    next.sums          = {};
+    next.vehicle_ticks = 0.0;
+    next.started       = done.seconds;
+    while (next.ends <= done.seconds) {
+        next.ends += period;
+    }
+    push(tier, done);
+}
+
+void Metrics::finish()
+{
+    for (auto tier : {Tier::SECOND, Tier::MINUTE}) {
+        if (pending[static_cast<std::size_t>(tier)].sums.ticks > 0) {
+            close(tier);
+        }
+    }
+    if (out.is_open()) {
+        out.flush();
+        if (!out) {
+            throw std::runtime_error("Could not write to " + config.output);
+        }
+    }
+}
+
+void Metrics::write(Sample const& sample)
+{
+    if (config.format == Format::BINARY) {
+        out.write(reinterpret_cast<char const*>(&sample), sizeof(sample));
+    } else {
+        std::vector<double> row{static_cast<double>(sample.tick),
+                                static_cast<double>(sample.ticks),
+                                sample.seconds,
+                                sample.vehicles,
+                                sample.food,
+                                sample.births,
+                                sample.deaths,
+                                sample.poison,
+                                sample.tps};
+        row.insert(row.end(), sample.states.begin(), sample.states.end());
+        for (auto const& gene : sample.genes) {
+            row.push_back(gene.mean);
+            row.push_back(gene.variance);
+        }
+        write_row(out, row);
+    }
+    // every sample of the coarser tiers and every 64 ticks, so that little
+    // is lost in a crash
+    if (config.every != Tier::TICK || sample.tick % 64 == 0) {
+        out.flush();
+    }
+    if (!out) {
+        throw std::runtime_error("Could not write to " + config.output);
+    }
+}
+
+std::vector<Metrics::Sample> Metrics::samples(Tier tier) const
+{
+    auto const& ring = rings[static_cast<std::size_t>(tier)];
+    if (ring.samples.size() < config.capacity) {
+        return ring.samples;
+    }
+    std::vector<Sample> ordered(ring.samples.begin() + ring.next,
+                                ring.samples.end());
+    ordered.insert(ordered.end(), ring.samples.begin(),
+                   ring.samples.begin() + ring.next);
+    return ordered;
+}
+
+Metrics::Sample Metrics::measure(World const& world)
+{
+    Sample sample{};
+    sample.tick  = world.tick_counter;
+    sample.ticks = 1;
+
+    // Welford's running mean and sum of squared differences
+    std::size_t n = 0;
+    for (auto const& vehicle : world.vehicles | std::views::values) {
+        if (vehicle.ghost) {
+            continue;
+        }
+        n++;
+        for (std::size_t i = 0; i < BEHAVIORS.size(); i++) {
+            sample.states[i] += vehicle.feels(BEHAVIORS[i]) ? 1.0 : 0.0;
+        }
+        auto const genes = DNARecord::capture(vehicle.get_dna()).genes();
+        for (std::size_t i = 0; i < GENES; i++) {
+            auto&       gene  = sample.genes[i];
+            auto const  delta = genes[i] - gene.mean;
+            gene.mean += delta / static_cast<double>(n);
+            gene.variance += delta * (genes[i] - gene.mean);
+        }
+    }
+    for (auto& gene : sample.genes) {
+        gene.variance = n > 0 ? gene.variance / static_cast<double>(n) : 0.0;
+    }
+    sample.vehicles = static_cast<double>(n);
+
+    std::size_t food = 0;
+    std::size_t poison = 0;
+    for (auto const& item : world.food | std::views::values) {
+        if (!item.ghost) {
+            food++;
+            poison += item.dna.nutrition < 0 ? 1 : 0;
+        }
+    }
+    sample.food   = static_cast<double>(food);
+    sample.poison = food > 0 ? static_cast<double>(poison) /
+                                   static_cast<double>(food)
+                             : 0.0;
+    return sample;
+}
+
+std::string_view Metrics::gene_name(std::size_t gene) noexcept
+{
+    return gene < GENES ? DNARecord::GENE_NAMES[gene] : "?";
+}
+
+std::string_view Metrics::state_name(std::size_t state) noexcept
+{
+    return state < STATE_NAMES.size() ? STATE_NAMES[state] : "?";
+}
+
+Metrics::Tier Metrics::parse_tier(std::string_view name)
+{
+    for (auto tier : {Tier::TICK, Tier::SECOND, Tier::MINUTE}) {
+        if (name == TIER_NAMES[static_cast<std::size_t>(tier)]) {
+            return tier;
+        }
+    }
+    throw std::invalid_argument("Unknown metrics tier " + std::string(name) +
+                                ", expected tick, second or minute");
+}
+
+}  // namespace tom
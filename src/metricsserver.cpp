@@ -0,0 +1,277 @@
+#include "metricsserver.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include "allocations.h"
+#include "world.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace tom {
+
+namespace {
+
+// how long the server waits before it looks whether to stop, and how long a
+// client gets to send its request
+constexpr int POLL_MS = 200;
+
+std::runtime_error system_error(std::string const& what)
+{
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+bool is_port(std::string const& address)
+{
+    return !address.empty() && address.size() <= 5 &&
+           std::ranges::all_of(address,
+                               [](char c) { return c >= '0' && c <= '9'; });
+}
+
+double seconds(Profiler::Duration duration)
+{
+    return std::chrono::duration<double>(duration).count();
+}
+
+void describe(std::ostream&    out,
+              std::string_view name,
+              std::string_view type,
+              std::string_view help)
+{
+    out << "# HELP " << name << " " << help << "\n"
+        << "# TYPE " << name << " " << type << "\n";
+}
+
+}  // namespace
+
+MetricsServer::MetricsServer(std::string address)
+    : address(std::move(address)), unix_socket(!is_port(this->address))
+{
+    if (unix_socket) {
+        sockaddr_un local{};
+        local.sun_family = AF_UNIX;
+        if (this->address.size() >= sizeof(local.sun_path)) {
+            throw std::runtime_error("Socket path too long: " +
+                                     this->address);
+        }
+        std::strncpy(local.sun_path, this->address.c_str(),
+                     sizeof(local.sun_path) - 1);
+        listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener < 0) {
+            throw system_error("Could not create a socket");
+        }
+        unlink(local.sun_path);
+        if (bind(listener, reinterpret_cast<sockaddr*>(&local),
+                 sizeof(local)) < 0) {
+            close(listener);
+            throw system_error("Could not bind " + this->address);
+        }
+    } else {
+        auto const port = std::stoi(this->address);
+        if (port < 1 || port > 65535) {
+            throw std::runtime_error("Not a port: " + this->address);
+        }
+        sockaddr_in local{};
+        local.sin_family      = AF_INET;
+        local.sin_port        = htons(static_cast<std::uint16_t>(port));
+        local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        listener              = socket(AF_INET, SOCK_STREAM, 0);
+        if (listener < 0) {
+            throw system_error("Could not create a socket");
+        }
+        int const yes = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        if (bind(listener, reinterpret_cast<sockaddr*>(&local),
+                 sizeof(local)) < 0) {
+            close(listener);
+            throw system_error("Could not bind 127.0.0.1:" + this->address);
+        }
+    }
+    if (listen(listener, 8) < 0) {
+        close(listener);
+        throw system_error("Could not listen on " + this->address);
+    }
+    thread = std::thread(&MetricsServer::serve, this);
+}
+
+MetricsServer::~MetricsServer()
+{
+    stopping.store(true, std::memory_order_relaxed);
+    thread.join();
+    close(listener);
+    if (unix_socket) {
+        unlink(address.c_str());
+    }
+}
+
+void MetricsServer::publish(World const& world)
+{
+    auto const now = Clock::now();
+    if (now < next_publish) {
+        return;
+    }
+    next_publish = now + PUBLISH_INTERVAL;
+    publish_now(world);
+}
+
+void MetricsServer::publish_now(World const& world)
+{
+    auto const allocated = AllocationCounts::so_far();
+    Counters   counters{
+          .tick            = world.tick_counter,
+          .vehicles        = static_cast<std::int64_t>(world.vehicles.size()),
+          .food            = static_cast<std::int64_t>(world.food.size()),
+          .births          = world.born_counter,
+          .deaths          = world.dead_counter,
+          .max_age         = world.max_age,
+          .tps             = world.tps(),
+          .allocations     = allocated.allocations,
+          .allocated_bytes = allocated.bytes,
+    };
+    if constexpr (Profiler::ENABLED) {
+        for (std::size_t i = 0; i < Profiler::PHASES; i++) {
+            counters.phases[i] = world.profiler.summary(
+                static_cast<Profiler::Phase>(i));
+        }
+    }
+    published.store(counters);
+}
+
+std::string MetricsServer::format(Counters const& counters)
+{
+    std::ostringstream out;
+    out.precision(9);
+
+    struct Metric {
+        std::string_view name;
+        std::string_view type;
+        std::string_view help;
+        double           value;
+    };
+    for (auto const& metric : {
+             Metric{"vehicles_tick", "gauge", "Ticks since the world began",
+                   static_cast<double>(counters.tick)},
+             Metric{"vehicles_population", "gauge", "Vehicles alive",
+                   static_cast<double>(counters.vehicles)},
+             Metric{"vehicles_food", "gauge", "Food in the world",
+                   static_cast<double>(counters.food)},
+             Metric{"vehicles_births_total", "counter", "Vehicles born",
+                   static_cast<double>(counters.births)},
+             Metric{"vehicles_deaths_total", "counter", "Vehicles that died",
+                   static_cast<double>(counters.deaths)},
+             Metric{"vehicles_max_age", "gauge", "Oldest vehicle, in ticks",
+                   static_cast<double>(counters.max_age)},
+             Metric{"vehicles_tps", "gauge", "Ticks per second",
+                   counters.tps},
+         }) {
+        describe(out, metric.name, metric.type, metric.help);
+        out << metric.name << " " << metric.value << "\n";
+    }
+
+    if constexpr (AllocationCounts::ENABLED) {
+        describe(out, "vehicles_allocations_total", "counter",
+                 "Heap allocations since the program started");
+        out << "vehicles_allocations_total " << counters.allocations << "\n";
+        describe(out, "vehicles_allocated_bytes_total", "counter",
+                 "Bytes allocated since the program started");
+        out << "vehicles_allocated_bytes_total " << counters.allocated_bytes
+            << "\n";
+    }
+
+    if constexpr (Profiler::ENABLED) {
+        // no _count or _sum: the profiler only knows its recent ticks
+        describe(out, "vehicles_phase_seconds", "summary",
+                 "Time of each phase of the last few thousand ticks");
+        for (std::size_t i = 0; i < Profiler::PHASES; i++) {
+            auto const& phase = counters.phases[i];
+            auto const  name  = Profiler::name(static_cast<Profiler::Phase>(i));
+            if (phase.samples == 0) {
+                continue;
+            }
+            for (auto const& [quantile, value] :
+                 {std::pair{"0.5", phase.p50}, std::pair{"0.95", phase.p95},
+                  std::pair{"0.99", phase.p99}, std::pair{"1", phase.max}}) {
+                out << "vehicles_phase_seconds{phase=\"" << name
+                    << "\",quantile=\"" << quantile << "\"} "
+                    << seconds(value) << "\n";
+            }
+        }
+    }
+    if constexpr (AllocationCounts::ENABLED) {
+        describe(out, "vehicles_phase_allocations", "gauge",
+                 "Heap allocations of each phase per tick, on average");
+        for (std::size_t i = 0; i < Profiler::PHASES; i++) {
+            auto const& phase = counters.phases[i];
+            if (phase.samples > 0) {
+                out << "vehicles_phase_allocations{phase=\""
+                    << Profiler::name(static_cast<Profiler::Phase>(i))
+                    << "\"} " << phase.allocations << "\n";
+            }
+        }
+    }
+    return out.str();
+}
+
+void MetricsServer::serve()
+{
+    pollfd waiting{.fd = listener, .events = POLLIN, .revents = 0};
+    while (!stopping.load(std::memory_order_relaxed)) {
+        if (poll(&waiting, 1, POLL_MS) <= 0) {
+            continue;
+        }
+        int const client = accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            continue;
+        }
+        answer(client);
+        close(client);
+    }
+}
+
+void MetricsServer::answer(int client) const
+{
+    // whatever was asked for (GET /metrics, most likely), as long as the
+    // request arrives in time
+    std::string request;
+    pollfd      reading{.fd = client, .events = POLLIN, .revents = 0};
+    while (request.find("\r\n\r\n") == std::string::npos &&
+           request.size() < 8192 && poll(&reading, 1, POLL_MS) > 0) {
+        char       buffer[1024];
+        auto const got = recv(client, buffer, sizeof(buffer), 0);
+        if (got <= 0) {
+            break;
+        }
+        request.append(buffer, static_cast<std::size_t>(got));
+    }
+    if (request.empty()) {
+        return;
+    }
+
+    auto const body     = format(counters());
+    auto const response = "HTTP/1.0 200 OK\r\n"
+                          "Content-Type: text/plain; version=0.0.4\r\n"
+                          "Content-Length: " +
+                          std::to_string(body.size()) + "\r\n\r\n" + body;
+    std::size_t sent = 0;
+    while (sent < response.size()) {
+        auto const n = send(client, response.data() + sent,
+                            response.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return;  // the client went away
+        }
+        sent += static_cast<std::size_t>(n);
+    }
+}
+
+}  // namespace tom
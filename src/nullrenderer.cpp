@@ -0,0 +1,37 @@
+#include "nullrenderer.h"
+#include "world.h"
+
+namespace tom::render {
+
+NullRenderer::NullRenderer(World* world, Budget budget)
+    : world(world), budget(budget), start_tick(world->tick_counter)
+{
+}
+
+void NullRenderer::clear_screen()
+{
+}
+
+void NullRenderer::render(bool transient)
+{
+    if (transient) {
+        return;
+    }
+    auto const ticks = world->tick_counter - start_tick;
+    if ((budget.ticks > 0 && ticks >= budget.ticks) ||
+        (budget.seconds > 0.0 &&
+         Clock::now() - start_time >=
+             std::chrono::duration<double>(budget.seconds))) {
+        World::game_running = false;
+    }
+}
+
+void NullRenderer::refresh()
+{
+}
+
+void NullRenderer::terminate()
+{
+}
+
+}  // namespace tom::render
@@ -0,0 +1,170 @@
+#include "perfcounters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace tom {
+
+PerfCounters::Values& PerfCounters::Values::operator+=(
+    Values const& other) noexcept
+{
+    for (std::size_t i = 0; i < EVENTS; i++) {
+        counts[i] += other.counts[i];
+    }
+    return *this;
+}
+
+PerfCounters::Values PerfCounters::Values::operator-(
+    Values const& earlier) const noexcept
+{
+    Values difference;
+    for (std::size_t i = 0; i < EVENTS; i++) {
+        difference.counts[i] = counts[i] - earlier.counts[i];
+    }
+    return difference;
+}
+
+#ifdef __linux__
+
+namespace {
+
+struct Config {
+    std::uint32_t type;
+    std::uint64_t config;
+};
+
+// in the order of PerfCounters::Event
+constexpr std::array<Config, PerfCounters::EVENTS> CONFIGS{{
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                             (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                             (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+}};
+
+int open_counter(Config const& config)
+{
+    perf_event_attr attr{};
+    attr.size   = sizeof(attr);
+    attr.type   = config.type;
+    attr.config = config.config;
+    attr.read_format =
+        PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // user space only, which perf_event_paranoid 2 (the usual default) allows
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    attr.inherit        = 1;
+    return static_cast<int>(
+        syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+}  // namespace
+
+PerfCounters::PerfCounters()
+{
+    fds.fill(-1);
+    for (std::size_t i = 0; i < EVENTS; i++) {
+        fds[i] = open_counter(CONFIGS[i]);
+        if (fds[i] < 0 && why.empty()) {
+            why = std::string(name(static_cast<Event>(i))) + ": " +
+                  std::strerror(errno);
+            if (errno == EACCES || errno == EPERM) {
+                why += " (see /proc/sys/kernel/perf_event_paranoid)";
+            }
+        }
+    }
+}
+
+PerfCounters::~PerfCounters()
+{
+    for (int fd : fds) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+PerfCounters::Values PerfCounters::read() const noexcept
+{
+    Values values;
+    for (std::size_t i = 0; i < EVENTS; i++) {
+        // value, time enabled, time running
+        std::uint64_t data[3]{};
+        if (fds[i] < 0 || ::read(fds[i], data, sizeof(data)) !=
+                              static_cast<ssize_t>(sizeof(data))) {
+            continue;
+        }
+        values.counts[i] =
+            data[2] == 0 || data[2] == data[1]
+                ? data[0]
+                : static_cast<std::uint64_t>(static_cast<double>(data[0]) *
+                                             static_cast<double>(data[1]) /
+                                             static_cast<double>(data[2]));
+    }
+    return values;
+}
+
+#else
+
+PerfCounters::PerfCounters()
+    : why("hardware counters are only read on Linux")
+{
+    fds.fill(-1);
+}
+
+PerfCounters::~PerfCounters() = default;
+
+PerfCounters::Values PerfCounters::read() const noexcept
+{
+    return {};
+}
+
+#endif  // __linux__
+
+bool PerfCounters::has(Event event) const noexcept
+{
+    return fds[static_cast<std::size_t>(event)] >= 0;
+}
+
+bool PerfCounters::available() const noexcept
+{
+    for (int fd : fds) {
+        if (fd >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string const& PerfCounters::error() const noexcept
+{
+    return why;
+}
+
+std::string_view PerfCounters::name(Event event) noexcept
+{
+    switch (event) {
+        case Event::CYCLES:
+            return "cycles";
+        case Event::INSTRUCTIONS:
+            return "instructions";
+        case Event::L1D_MISSES:
+            return "L1D misses";
+        case Event::LLC_MISSES:
+            return "LLC misses";
+        case Event::BRANCH_MISSES:
+            return "branch misses";
+        case Event::COUNT:
+            break;
+    }
+    return "?";
+}
+
+}  // namespace tom
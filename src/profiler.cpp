@@ -0,0 +1,209 @@
+#include "profiler.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <iomanip>
+
+namespace tom {
+
+void Histogram::record(std::uint64_t value) noexcept
+{
+    counts[bucket_of(value)]++;
+    total++;
+    largest = std::max(largest, value);
+}
+
+void Histogram::add(Histogram const& other) noexcept
+{
+    for (std::size_t i = 0; i < BUCKETS; i++) {
+        counts[i] += other.counts[i];
+    }
+    total += other.total;
+    largest = std::max(largest, other.largest);
+}
+
+void Histogram::clear() noexcept
+{
+    counts.fill(0);
+    total   = 0;
+    largest = 0;
+}
+
+std::uint64_t Histogram::at(double quantile) const noexcept
+{
+    if (total == 0) {
+        return 0;
+    }
+    auto const rank = std::max<std::uint64_t>(
+        1, static_cast<std::uint64_t>(
+               std::ceil(quantile * static_cast<double>(total))));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return std::min(value_of(i), largest);
+        }
+    }
+    return largest;
+}
+
+std::size_t Histogram::bucket_of(std::uint64_t value) noexcept
+{
+    if (value < SUB_BUCKETS) {
+        return value;
+    }
+    auto const bit = std::bit_width(value) - 1;
+    if (bit >= MAX_BITS) {
+        return BUCKETS - 1;
+    }
+    auto const shift = bit - SUB_BUCKET_BITS;
+    return (bit - SUB_BUCKET_BITS + 1) * SUB_BUCKETS +
+           ((value >> shift) - SUB_BUCKETS);
+}
+
+std::uint64_t Histogram::value_of(std::size_t bucket) noexcept
+{
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+    auto const shift = bucket / SUB_BUCKETS - 1;
+    auto const low   = (SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+    return low + (std::uint64_t{1} << shift) / 2;
+}
+
+void Profiler::Window::add(Window const& other) noexcept
+{
+    times.add(other.times);
+    allocated.allocations += other.allocated.allocations;
+    allocated.bytes += other.allocated.bytes;
+    most_allocations = std::max(most_allocations, other.most_allocations);
+}
+
+Profiler::Profiler(Profiler const& other)
+    : phases(other.phases ? std::make_unique<Phases>(*other.phases) : nullptr)
+{
+}
+
+Profiler& Profiler::operator=(Profiler const& other)
+{
+    if (this != &other) {
+        *this = Profiler(other);
+    }
+    return *this;
+}
+
+Profiler::Profiler()                               = default;
+Profiler::Profiler(Profiler&&) noexcept            = default;
+Profiler& Profiler::operator=(Profiler&&) noexcept = default;
+Profiler::~Profiler()                              = default;
+
+void Profiler::record(Phase            phase,
+                      Duration         elapsed,
+                      AllocationCounts allocated) noexcept
+{
+    if (!phases) {
+        phases = std::make_unique<Phases>();
+    }
+    auto& window = (*phases)[static_cast<std::size_t>(phase)].next();
+    window.allocated.allocations += allocated.allocations;
+    window.allocated.bytes += allocated.bytes;
+    window.most_allocations =
+        std::max(window.most_allocations, allocated.allocations);
+    auto const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        elapsed);
+    window.times.record(static_cast<std::uint64_t>(std::max(
+        ns.count(), std::chrono::nanoseconds::rep{})));
+}
+
+Profiler::Summary Profiler::summary(Phase phase) const noexcept
+{
+    if (!phases) {
+        return {};
+    }
+    auto const window = (*phases)[static_cast<std::size_t>(phase)].merged();
+    if (window.count() == 0) {
+        return {};
+    }
+    auto const& times   = window.times;
+    auto const  samples = static_cast<double>(times.count());
+
+    auto const duration = [](std::uint64_t ns) {
+        return std::chrono::duration_cast<Duration>(
+            std::chrono::nanoseconds(ns));
+    };
+    return {
+        .p50     = duration(times.at(0.50)),
+        .p95     = duration(times.at(0.95)),
+        .p99     = duration(times.at(0.99)),
+        .max     = duration(times.max()),
+        .samples = times.count(),
+        .allocations =
+            static_cast<double>(window.allocated.allocations) / samples,
+        .bytes = static_cast<double>(window.allocated.bytes) / samples,
+        .most_allocations = window.most_allocations,
+    };
+}
+
+void Profiler::reset() noexcept
+{
+    phases.reset();
+}
+
+std::string_view Profiler::name(Phase phase) noexcept
+{
+    switch (phase) {
+        case Phase::EVENTS:
+            return "events";
+        case Phase::TIME_OF_DAY:
+            return "time_of_day";
+        case Phase::PRUNE_FOOD:
+            return "prune_food";
+        case Phase::INDEX:
+            return "index";
+        case Phase::FOOD:
+            return "food";
+        case Phase::PRUNE_VEHICLES:
+            return "prune_vehicles";
+        case Phase::VEHICLES:
+            return "vehicles";
+        case Phase::RENDER:
+            return "render";
+        case Phase::COUNT:
+            break;
+    }
+    return "?";
+}
+
+void Profiler::write(std::ostream& out) const
+{
+    if (!phases) {
+        return;
+    }
+    auto const us = [](Duration duration) {
+        return std::chrono::duration<double, std::micro>(duration).count();
+    };
+    auto const flags     = out.flags();
+    auto const precision = out.precision();
+    out << "[PROFILE]  us p50/p95/p99/max:" << std::fixed
+        << std::setprecision(1);
+    for (std::size_t i = 0; i < PHASES; i++) {
+        auto const phase   = static_cast<Phase>(i);
+        auto const summary = this->summary(phase);
+        if (summary.samples == 0) {
+            continue;
+        }
+        out << " " << name(phase) << " " << us(summary.p50) << "/"
+            << us(summary.p95) << "/" << us(summary.p99) << "/"
+            << us(summary.max);
+        if constexpr (AllocationCounts::ENABLED) {
+            out << " allocs " << summary.allocations << " ("
+                << summary.bytes / 1024.0 << " KB, max "
+                << summary.most_allocations << ")";
+        }
+        out << ";";
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+}  // namespace tom
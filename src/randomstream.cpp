@@ -0,0 +1,79 @@
+#include "randomstream.h"
+
+#include <algorithm>
+
+namespace tom {
+
+thread_local RandomStream* RandomStream::bound = nullptr;
+
+// draws that happen outside of every tick, e.g. while populating the world
+thread_local RandomStream RandomStream::fallback{0, ~std::uint64_t{0}, 0};
+
+RandomStream::Scope::Scope(RandomStream& stream) noexcept : previous(bound)
+{
+    bound = &stream;
+}
+
+RandomStream::Scope::~Scope()
+{
+    bound = previous;
+}
+
+void RandomStream::fill_uniform(std::span<double> out) noexcept
+{
+    auto const block = Philox4x32::block(counter, key);
+    counter[0]++;
+    available = 0;
+
+    auto const seed = (std::uint64_t{block[0]} << 32 | block[1]) ^
+                      (std::uint64_t{block[2]} << 32 | block[3]);
+    Xoshiro256x4(seed).fill_uniform(out);
+}
+
+void RandomStream::reseed(std::uint64_t seed) noexcept
+{
+    fallback = RandomStream{seed, ~std::uint64_t{0}, 0};
+}
+
+static std::uint64_t splitmix64(std::uint64_t& state) noexcept
+{
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15);
+    z               = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+    z               = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+    return z ^ (z >> 31);
+}
+
+Xoshiro256x4::Xoshiro256x4(std::uint64_t seed) noexcept
+{
+    for (std::size_t lane = 0; lane < LANES; lane++) {
+        s0[lane] = splitmix64(seed);
+        s1[lane] = splitmix64(seed);
+        s2[lane] = splitmix64(seed);
+        s3[lane] = splitmix64(seed);
+    }
+}
+
+void Xoshiro256x4::fill_uniform(std::span<double> out) noexcept
+{
+    for (std::size_t i = 0; i < out.size(); i += LANES) {
+        Lane next;
+        for (std::size_t lane = 0; lane < LANES; lane++) {
+            next[lane] = s0[lane] + s3[lane];
+
+            auto const t = s1[lane] << 17;
+            s2[lane] ^= s0[lane];
+            s3[lane] ^= s1[lane];
+            s1[lane] ^= s2[lane];
+            s0[lane] ^= s3[lane];
+            s2[lane] ^= t;
+            s3[lane] = (s3[lane] << 45) | (s3[lane] >> 19);
+        }
+
+        auto const n = std::min(LANES, out.size() - i);
+        for (std::size_t lane = 0; lane < n; lane++) {
+            out[i + lane] = static_cast<double>(next[lane] >> 11) * 0x1.0p-53;
+        }
+    }
+}
+
+}  // namespace tom
@@ -0,0 +1,152 @@
+#include "scenario.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+#include "dna.h"
+#include "utils.h"
+#include "vec2d.h"
+#include "vehicle.h"
+#include "world.h"
+
+namespace tom {
+
+namespace {
+
+// a vehicle like create_vehicle() makes one, with change applied to its dna
+// and health before it ever ticks
+template <typename Change>
+void add_changed_vehicle(World& world, Vec2D const& position, Change&& change)
+{
+    auto&                 vehicle = world.create_vehicle(position);
+    DNA                   dna     = vehicle.get_dna();
+    Vehicle::LifespanType health  = vehicle.get_health();
+    change(dna, health);
+    vehicle.populate_in_place(vehicle.id, &world, position,
+                              vehicle.get_velocity(), dna,
+                              vehicle.get_generation(), health, false);
+}
+
+// uniformly inside the circle around centre
+Vec2D random_in_disc(Vec2D const& centre, double radius)
+{
+    auto const distance = radius * std::sqrt(random_in_range(0.0, 1.0));
+    auto const angle    = random_in_range(0.0, 2 * std::numbers::pi);
+    return {centre.x + distance * std::cos(angle),
+            centre.y + distance * std::sin(angle)};
+}
+
+void uniform(World& world, int vehicles, int food)
+{
+    world.populate_world(vehicles, food);
+}
+
+// every vehicle packed around the centre of the map, so that each one sees
+// most of the rest, and seeking them: healthy enough to be outgoing (above
+// half health) but not so healthy that it wanders (above 80%)
+void dense_cluster(World& world, int vehicles, int food)
+{
+    Vec2D const  centre{world.width / 2.0, world.height / 2.0};
+    double const radius = std::min({world.width / 2.0, world.height / 2.0,
+                                    10.0 * std::sqrt(vehicles)});
+    for (int i = 0; i < vehicles; i++) {
+        add_changed_vehicle(world, random_in_disc(centre, radius),
+                            [](DNA&, Vehicle::LifespanType& health) {
+                                health = 0.7 * Vehicle::MAX_HEALTH;
+                            });
+    }
+    for (int i = 0; i < food; i++) {
+        world.new_random_food();
+    }
+}
+
+// desperate vehicles (the only ones that explode) that explode about once
+// every 20 ticks. Their litters are just as desperate but inherit half the
+// chance; the storm burns out within a few dozen ticks
+void explosion_storm(World& world, int vehicles, int food)
+{
+    for (int i = 0; i < vehicles; i++) {
+        add_changed_vehicle(world, world.rand_pos_in_bounds(),
+                            [](DNA& dna, Vehicle::LifespanType& health) {
+                                dna.explosion_chance = 0.05;
+                                health = 0.09 * Vehicle::MAX_HEALTH;
+                            });
+    }
+    for (int i = 0; i < food; i++) {
+        world.new_random_food();
+    }
+}
+
+// the map full of food from the start and spawning more on every chance,
+// always at max_food
+void food_flood(World& world, int vehicles, int food)
+{
+    world.max_food        = static_cast<unsigned int>(food);
+    world.food_pct_chance = 100.0;
+    world.populate_world(vehicles, food);
+}
+
+// night falls on the first tick over vehicles too weak to seek each other
+// by day, so that only the dark drives them together
+void night_swarm(World& world, int vehicles, int food)
+{
+    world.disable_night = false;
+    world.daytime.set(World::day_tick_length());
+    for (int i = 0; i < vehicles; i++) {
+        add_changed_vehicle(world, world.rand_pos_in_bounds(),
+                            [](DNA&, Vehicle::LifespanType& health) {
+                                health = 0.4 * Vehicle::MAX_HEALTH;
+                            });
+    }
+    for (int i = 0; i < food; i++) {
+        world.new_random_food();
+    }
+}
+
+constexpr std::array ALL{
+    Scenario{"uniform", "vehicles and food scattered over the whole map",
+             uniform},
+    Scenario{"dense_cluster",
+             "vehicles packed around the centre, all seeking each other",
+             dense_cluster},
+    Scenario{"explosion_storm",
+             "vehicles exploding into litters every few ticks",
+             explosion_storm},
+    Scenario{"food_flood", "food at max_food and spawning on every chance",
+             food_flood},
+    Scenario{"night_swarm", "night from the first tick, weak vehicles swarm",
+             night_swarm},
+};
+
+}  // namespace
+
+std::span<Scenario const> scenarios() noexcept
+{
+    return ALL;
+}
+
+Scenario const& find_scenario(std::string_view name)
+{
+    for (auto const& scenario : ALL) {
+        if (scenario.name == name) {
+            return scenario;
+        }
+    }
+    throw std::invalid_argument("Unknown scenario " + std::string(name) +
+                                ", choose one of " + scenario_names());
+}
+
+std::string scenario_names()
+{
+    std::string names;
+    for (auto const& scenario : ALL) {
+        if (!names.empty()) {
+            names += ", ";
+        }
+        names += scenario.name;
+    }
+    return names;
+}
+
+}  // namespace tom
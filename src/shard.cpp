@@ -0,0 +1,662 @@
+#include "shard.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <iostream>
+#include <new>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "checks.h"
+#include "entityrecord.h"
+#include "food.h"
+#include "utils.h"
+#include "vehicle.h"
+#include "windows_shim.h"
+#include "world.h"
+
+namespace tom::shard {
+
+namespace {
+
+constexpr std::size_t HALO_VEHICLES    = 8192;
+constexpr std::size_t HALO_FOOD        = 16384;
+constexpr std::size_t HANDOFF_VEHICLES = 2048;
+constexpr std::size_t HANDOFF_FOOD     = 4096;
+constexpr std::size_t EFFECTS          = 16384;
+
+// every shard allocates entity ids from its own range so that handed off
+// entities never collide with local ones
+constexpr int ID_BASE_SHIFT = 40;
+
+enum Side { LEFT = 0, RIGHT = 1 };
+
+constexpr Side opposite(Side side)
+{
+    return side == LEFT ? RIGHT : LEFT;
+}
+
+struct Effect {
+    enum struct Kind : std::uint32_t { VEHICLE_HEALTH, FOOD_EXPIRED };
+
+    Kind          kind;
+    std::uint64_t id;
+    double        amount;  // ticks of health for VEHICLE_HEALTH
+};
+
+template <typename T, std::size_t N>
+struct Buffer {
+    std::uint32_t count;
+    T             items[N];
+
+    bool try_push(T const& item) noexcept
+    {
+        if (count == N) {
+            return false;
+        }
+        items[count++] = item;
+        return true;
+    }
+
+    // the segment cannot grow once the shards run, and a record that does
+    // not fit would be lost without a trace, so that ends the run instead
+    void push(T const& item, char const* capacity)
+    {
+        if (!try_push(item)) {
+            throw std::runtime_error(
+                std::string(capacity) + " (" + std::to_string(N) +
+                ") is too small for this world, raise it in shard.cpp");
+        }
+    }
+
+    std::span<T const> view() const noexcept
+    {
+        return {items, count};
+    }
+};
+
+struct Outbox {
+    Buffer<VehicleRecord, HALO_VEHICLES>    halo_vehicles;
+    Buffer<FoodRecord, HALO_FOOD>           halo_food;
+    Buffer<VehicleRecord, HANDOFF_VEHICLES> handoff_vehicles;
+    Buffer<FoodRecord, HANDOFF_FOOD>        handoff_food;
+    Buffer<Effect, EFFECTS>                 effects;
+
+    void clear() noexcept
+    {
+        halo_vehicles.count    = 0;
+        halo_food.count        = 0;
+        handoff_vehicles.count = 0;
+        handoff_food.count     = 0;
+        effects.count          = 0;
+    }
+};
+
+struct Stats {
+    long          tick;
+    long          vehicles;
+    long          food;
+    long          born;
+    long          dead;
+    long          max_age;
+    double        max_fitness;
+    std::uint64_t fittest_id;
+    double        max_perception;
+};
+
+struct Slot {
+    Stats  stats;
+    Outbox outbox[2];  // indexed by the side the receiving neighbour is on
+};
+
+struct Header {
+    std::atomic<int> arrived;
+    std::atomic<int> generation;
+    std::atomic<int> stop;
+    std::atomic<int> abort;
+    int              participants;
+};
+
+struct Segment {
+    void*       base;
+    std::size_t size;
+    Header*     header;
+    Slot*       slots;
+};
+
+Segment map_segment(int shards)
+{
+    auto const slots_offset =
+        (sizeof(Header) + alignof(Slot) - 1) / alignof(Slot) * alignof(Slot);
+    auto const size = slots_offset + shards * sizeof(Slot);
+
+    auto const name = "/vehicles-shards-" + std::to_string(getpid());
+    int const  fd   = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    REQUIRE(fd != -1);
+    // the mapping keeps the memory alive and is inherited by fork() so the
+    // name is not needed past this point
+    shm_unlink(name.c_str());
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        close(fd);
+        throw std::runtime_error("Could not size shared memory for shards");
+    }
+    void* base =
+        mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    REQUIRE(base != MAP_FAILED);
+
+    // ftruncate zero fills, so every buffer starts out empty
+    auto* header = new (base) Header{};
+    auto* slots  = reinterpret_cast<Slot*>(static_cast<char*>(base) +
+                                          slots_offset);
+    return Segment{base, size, header, slots};
+}
+
+/**
+ * Sense reversing barrier across processes. Returns false if the run was
+ * aborted while waiting; on_spin is called while waiting for the others
+ */
+template <typename Spin>
+bool barrier(Header* header, Spin on_spin)
+{
+    int const generation = header->generation.load(std::memory_order_acquire);
+    if (header->arrived.fetch_add(1, std::memory_order_acq_rel) + 1 ==
+        header->participants) {
+        header->arrived.store(0, std::memory_order_relaxed);
+        header->generation.fetch_add(1, std::memory_order_acq_rel);
+    } else {
+        while (header->generation.load(std::memory_order_acquire) ==
+               generation) {
+            if (header->abort.load(std::memory_order_relaxed)) {
+                return false;
+            }
+            on_spin();
+            std::this_thread::yield();
+        }
+    }
+    return header->abort.load(std::memory_order_relaxed) == 0;
+}
+
+class ShardProcess {
+   public:
+    ShardProcess(Segment const& segment, Config const& config, int index)
+        : header(segment.header),
+          slots(segment.slots),
+          config(config),
+          index(index),
+          lo(config.width * static_cast<double>(index) / config.shards),
+          hi(config.width * static_cast<double>(index + 1) / config.shards),
+          world(config.seed + index, config.width, config.height)
+    {
+        world.disable_night   = config.disable_night;
+        world.max_food        = config.max_food / config.shards;
+        world.food_pct_chance = config.food_pct_chance;
+    }
+
+    void run()
+    {
+        // the coordinator owns SIGINT and tells the shards when to stop
+        signal(SIGINT, SIG_IGN);
+        set_seed(config.seed + index);
+        auto const id_base = (static_cast<World::VehicleIdType>(index)
+                              << ID_BASE_SHIFT) +
+                             1;
+        Vehicle::set_id_base(id_base);
+        Environmental::set_id_base(id_base);
+
+        populate();
+        publish_stats();
+        // every shard has published its perception once this returns, so
+        // the halo is as wide as what the neighbours see right now
+        while (wait()) {
+            export_boundary();
+            if (!wait() || header->stop.load()) {
+                break;
+            }
+            import_neighbours();
+            world.tick();
+            // queued actions may point at ghosts, run them before the
+            // ghosts go away
+            world.process_events();
+            release_ghosts();
+            // everyone has read their inboxes once this returns
+            if (!wait()) {
+                break;
+            }
+            publish_stats();
+        }
+    }
+
+   private:
+    struct Ghost {
+        Side   from;
+        double health;
+    };
+
+    Header*      header;
+    Slot*        slots;
+    pid_t const  coordinator = getppid();
+    Config const config;
+    int          index;
+    double       lo;
+    double       hi;
+    double       halo_width = 0.0;
+    World        world;
+
+    std::unordered_map<World::VehicleIdType, Ghost> ghost_vehicles;
+    std::unordered_map<World::FoodIdType, Side>     ghost_food;
+    std::vector<Effect>                             effects[2];
+    // what the last exchange handed off, by id, and the side it went to
+    std::unordered_map<World::VehicleIdType, Side>  handed_vehicles;
+    std::unordered_map<World::FoodIdType, Side>     handed_food;
+
+    bool wait()
+    {
+        // a shard left behind by a crashed coordinator must not spin forever
+        return barrier(header, [this] {
+            if (getppid() != coordinator) {
+                header->abort = 1;
+            }
+        });
+    }
+
+    [[nodiscard]]
+    bool has_neighbour(Side side) const
+    {
+        return side == LEFT ? index > 0 : index < config.shards - 1;
+    }
+
+    [[nodiscard]]
+    Outbox const& inbox(Side side) const
+    {
+        return slots[side == LEFT ? index - 1 : index + 1]
+            .outbox[opposite(side)];
+    }
+
+    Outbox& outbox(Side side)
+    {
+        return slots[index].outbox[side];
+    }
+
+    void populate()
+    {
+        auto share = [this](int total) {
+            return total / config.shards +
+                   (index < total % config.shards ? 1 : 0);
+        };
+        double const margin = World::edge_threshold;
+
+        for (int i = share(config.vehicles); i > 0; i--) {
+            world.create_vehicle(Vec2D{random_in_range(lo, hi),
+                                       random_in_range(0, config.height)});
+        }
+        for (int i = share(config.food); i > 0; i--) {
+            world.new_random_food(Vec2D{
+                random_in_range(std::max(lo, margin),
+                                std::min(hi, config.width - margin)),
+                random_in_range(margin, config.height - margin)});
+        }
+    }
+
+    void import_neighbours()
+    {
+        for (auto side : {LEFT, RIGHT}) {
+            if (!has_neighbour(side)) {
+                continue;
+            }
+            Outbox const& in = inbox(side);
+            for (auto const& r : in.handoff_vehicles.view()) {
+                world.vehicles.insert_or_assign(r.id, r.restore(&world));
+            }
+            for (auto const& r : in.handoff_food.view()) {
+                world.food.insert_or_assign(r.id, r.restore(&world));
+            }
+            for (auto const& e : in.effects.view()) {
+                if (!apply(e)) {
+                    forward(e);
+                }
+            }
+            for (auto const& r : in.halo_vehicles.view()) {
+                auto [it, inserted] =
+                    world.vehicles.try_emplace(r.id, r.restore(&world));
+                if (inserted) {
+                    it->second.ghost = true;
+                    ghost_vehicles.emplace(r.id, Ghost{side, r.health});
+                }
+            }
+            for (auto const& r : in.halo_food.view()) {
+                auto [it, inserted] =
+                    world.food.try_emplace(r.id, r.restore(&world));
+                if (inserted) {
+                    it->second.ghost = true;
+                    ghost_food.emplace(r.id, side);
+                }
+            }
+        }
+    }
+
+    // false if the entity is not ours (any more)
+    bool apply(Effect const& effect)
+    {
+        switch (effect.kind) {
+            case Effect::Kind::VEHICLE_HEALTH:
+                if (auto it = world.vehicles.find(effect.id);
+                    it != world.vehicles.end() && !it->second.ghost) {
+                    it->second.change_health(effect.amount);
+                    return true;
+                }
+                break;
+            case Effect::Kind::FOOD_EXPIRED:
+                if (auto it = world.food.find(effect.id);
+                    it != world.food.end() && !it->second.ghost) {
+                    it->second.expire();
+                    return true;
+                }
+                break;
+        }
+        return false;
+    }
+
+    // an effect on an entity that we handed off in the same exchange follows
+    // it with the next one, as often as it is handed off again
+    void forward(Effect const& effect)
+    {
+        auto const& handed = effect.kind == Effect::Kind::VEHICLE_HEALTH
+                                 ? handed_vehicles
+                                 : handed_food;
+        if (auto it = handed.find(effect.id); it != handed.end()) {
+            effects[it->second].push_back(effect);
+        }
+    }
+
+    void release_ghosts()
+    {
+        using Lifespan = Vehicle::LifespanType;
+
+        for (auto const& [id, ghost] : ghost_vehicles) {
+            auto it = world.vehicles.find(id);
+            if (it == world.vehicles.end()) {
+                continue;
+            }
+            if (auto const now = it->second.get_health().remaining();
+                now != ghost.health) {
+                effects[ghost.from].push_back(
+                    Effect{Effect::Kind::VEHICLE_HEALTH, id,
+                           (now - ghost.health) / Lifespan::tick_amount});
+            }
+            world.vehicles.erase(it);
+        }
+        for (auto const& [id, from] : ghost_food) {
+            auto it = world.food.find(id);
+            if (it == world.food.end()) {
+                continue;
+            }
+            if (it->second.is_expired()) {
+                effects[from].push_back(
+                    Effect{Effect::Kind::FOOD_EXPIRED, id, 0.0});
+            }
+            world.food.erase(it);
+        }
+        ghost_vehicles.clear();
+        ghost_food.clear();
+    }
+
+    template <typename Map, typename HaloOf, typename HandoffOf>
+    void export_entities(
+        Map&                                              entities,
+        std::unordered_map<typename Map::key_type, Side>& handed,
+        HaloOf                                            halo_of,
+        char const*                                       halo_name,
+        HandoffOf                                         handoff_of)
+    {
+        using Record = std::remove_cvref_t<
+            decltype(handoff_of(outbox(LEFT)).items[0])>;
+
+        handed.clear();
+        for (auto const& [id, entity] : entities) {
+            double const x = entity.get_position().x;
+            // a handoff that does not fit waits for the next tick, and is
+            // shown to the neighbour as a ghost until then
+            if (x < lo && has_neighbour(LEFT) &&
+                handoff_of(outbox(LEFT)).try_push(Record::capture(entity))) {
+                handed.emplace(id, LEFT);
+                continue;
+            }
+            if (x >= hi && has_neighbour(RIGHT) &&
+                handoff_of(outbox(RIGHT)).try_push(Record::capture(entity))) {
+                handed.emplace(id, RIGHT);
+                continue;
+            }
+            if (has_neighbour(LEFT) && x < lo + halo_width) {
+                halo_of(outbox(LEFT)).push(Record::capture(entity), halo_name);
+            }
+            if (has_neighbour(RIGHT) && x >= hi - halo_width) {
+                halo_of(outbox(RIGHT)).push(Record::capture(entity), halo_name);
+            }
+        }
+        for (auto const& [id, side] : handed) {
+            entities.erase(id);
+        }
+    }
+
+    void export_boundary()
+    {
+        // the neighbours see as far as the perception published this tick
+        halo_width = 0.0;
+        for (int i = 0; i < config.shards; i++) {
+            halo_width = std::max(halo_width, slots[i].stats.max_perception);
+        }
+        for (auto side : {LEFT, RIGHT}) {
+            outbox(side).clear();
+        }
+        export_entities(
+            world.vehicles, handed_vehicles,
+            [](Outbox& o) -> auto& { return o.halo_vehicles; },
+            "HALO_VEHICLES",
+            [](Outbox& o) -> auto& { return o.handoff_vehicles; });
+        export_entities(
+            world.food, handed_food,
+            [](Outbox& o) -> auto& { return o.halo_food; }, "HALO_FOOD",
+            [](Outbox& o) -> auto& { return o.handoff_food; });
+        for (auto side : {LEFT, RIGHT}) {
+            if (has_neighbour(side)) {
+                for (auto const& e : effects[side]) {
+                    outbox(side).effects.push(e, "EFFECTS");
+                }
+            }
+            effects[side].clear();
+        }
+    }
+
+    void publish_stats()
+    {
+        double perception = 0.0;
+        for (auto const& [id, v] : world.vehicles) {
+            perception = std::max(perception, v.get_dna().perception_radius);
+        }
+        for (auto const& [id, f] : world.food) {
+            perception = std::max(perception, f.dna.perceptionRadius);
+        }
+
+        Stats& stats         = slots[index].stats;
+        stats.tick           = world.tick_counter;
+        stats.vehicles       = static_cast<long>(world.vehicles.size());
+        stats.food           = static_cast<long>(world.food.size());
+        stats.born           = world.born_counter;
+        stats.dead           = world.dead_counter;
+        stats.max_age        = world.max_age;
+        stats.max_fitness    = World::max_fitness.second;
+        stats.fittest_id     = World::max_fitness.first;
+        stats.max_perception = perception;
+    }
+};
+
+std::stringstream merged_info(Config const&      config,
+                              std::span<Slot const> slots,
+                              double             tps,
+                              std::string const& delim)
+{
+    Stats total{};
+    total.tick = slots.front().stats.tick;
+    for (auto const& slot : slots) {
+        auto const& s  = slot.stats;
+        total.tick     = std::min(total.tick, s.tick);
+        total.vehicles += s.vehicles;
+        total.food += s.food;
+        total.born += s.born;
+        total.dead += s.dead;
+        total.max_age        = std::max(total.max_age, s.max_age);
+        total.max_perception = std::max(total.max_perception, s.max_perception);
+        if (s.max_fitness > total.max_fitness) {
+            total.max_fitness = s.max_fitness;
+            total.fittest_id  = s.fittest_id;
+        }
+    }
+
+    std::stringstream ss;
+    ss << "[WORLD]    size: " << config.width << "x" << config.height << "; "
+       << "seed: " << config.seed << "; " << "target TPS: "
+       << (World::unlimited_tps ? 0 : World::target_tps) << delim;
+    ss << "[SHARDS]   " << config.shards << " processes; strip width "
+       << config.width / config.shards << "; halo "
+       << total.max_perception << delim;
+    ss << "[TICK]     " << total.tick << "; current TPS: " << tps << delim;
+    ss << "[VEHICLES] Current: " << total.vehicles << "; Dead: " << total.dead
+       << "; Borne: " << total.born << "; Oldest: " << total.max_age
+       << "; Fittest (id=" << total.fittest_id << ") " << total.max_fitness
+       << delim;
+    ss << "[FOOD]     Count: " << total.food << "; Spawn Chance "
+       << config.food_pct_chance << "%; Max: " << config.max_food << " ";
+    return ss;
+}
+
+[[nodiscard]]
+long total_vehicles(std::span<Slot const> slots)
+{
+    long count = 0;
+    for (auto const& slot : slots) {
+        count += slot.stats.vehicles;
+    }
+    return count;
+}
+
+}  // namespace
+
+int run_coordinator(Config const& config)
+{
+    using Clock = World::Clock;
+
+    REQUIRE(config.shards > 0);
+    Segment segment              = map_segment(config.shards);
+    segment.header->participants = config.shards + 1;
+
+    std::vector<pid_t> children;
+    for (int i = 0; i < config.shards; i++) {
+        pid_t const pid = fork();
+        if (pid == 0) {
+            try {
+                ShardProcess shard(segment, config, i);
+                shard.run();
+            } catch (std::exception const& e) {
+                std::cerr << "Shard " << i << ": " << e.what() << "\n";
+                segment.header->abort = 1;
+                _exit(EXIT_FAILURE);
+            }
+            _exit(EXIT_SUCCESS);
+        }
+        if (pid < 0) {
+            segment.header->abort = 1;
+            break;
+        }
+        children.push_back(pid);
+    }
+
+    signal(SIGINT, World::stop_running);
+
+    bool failed      = false;
+    auto watch_child = [&] {
+        int status;
+        if (waitpid(-1, &status, WNOHANG) > 0) {
+            failed                = true;
+            segment.header->abort = 1;
+        }
+    };
+    auto wait = [&] { return barrier(segment.header, watch_child); };
+
+    std::span<Slot const> const slots{segment.slots,
+                                      static_cast<std::size_t>(config.shards)};
+    auto const tick_time = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::seconds{1}) / World::target_tps;
+    auto   report_time  = Clock::now();
+    long   report_tick  = 0;
+    double tps          = 0.0;
+
+    while (!failed) {
+        auto const tick_start = Clock::now();
+        // the shards have published their stats once this returns, and
+        // leave them alone until they ticked again
+        if (!wait()) {
+            break;
+        }
+
+        if (auto const now = Clock::now();
+            now - report_time >= std::chrono::seconds{1}) {
+            auto const tick = slots.front().stats.tick;
+            auto const seconds =
+                std::chrono::duration<double>(now - report_time);
+            tps         = (tick - report_tick) / seconds.count();
+            report_tick = tick;
+            report_time = now;
+            output(merged_info(config, slots, tps, " | ").str(), "\n");
+        }
+        if (total_vehicles(slots) == 0 || World::was_interrupted) {
+            segment.header->stop = 1;
+        }
+        if (!wait() || segment.header->stop || !wait()) {
+            break;
+        }
+        if (!World::unlimited_tps) {
+            if (auto const spent = Clock::now() - tick_start;
+                spent < tick_time) {
+                usleep_shim(
+                    std::chrono::duration_cast<std::chrono::microseconds>(
+                        tick_time - spent)
+                        .count());
+            }
+        }
+    }
+
+    // a shard that fails says why and aborts before it exits
+    failed = failed || segment.header->abort;
+    if (failed) {
+        for (auto pid : children) {
+            kill(pid, SIGTERM);
+        }
+    }
+    for (auto pid : children) {
+        waitpid(pid, nullptr, 0);
+    }
+
+    output("\nSimulation ended.\n", merged_info(config, slots, tps, "\n").str(),
+           "\n");
+    munmap(segment.base, segment.size);
+    if (failed) {
+        std::cerr << "A shard process failed.\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+}  // namespace tom::shard
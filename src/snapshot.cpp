@@ -0,0 +1,257 @@
+#include "snapshot.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+#include <fstream>
+#include <ranges>
+#include <stdexcept>
+#include "checks.h"
+#include "food.h"
+#include "vehicle.h"
+#include "world.h"
+
+namespace tom {
+
+namespace {
+
+constexpr std::uint64_t RECORD_ALIGNMENT = 64;
+
+constexpr std::uint64_t align_record(std::uint64_t offset)
+{
+    return (offset + RECORD_ALIGNMENT - 1) / RECORD_ALIGNMENT *
+           RECORD_ALIGNMENT;
+}
+
+// header, padding and records in file order, each handed to write(bytes, n)
+template <typename Write>
+void write_snapshot(World const&            world,
+                    Snapshot::Header const& header,
+                    Write&&                 write)
+{
+    static constexpr char zeros[RECORD_ALIGNMENT]{};
+
+    std::uint64_t position = 0;
+    auto const    raw      = [&](void const* bytes, std::uint64_t count) {
+        write(static_cast<char const*>(bytes), count);
+        position += count;
+    };
+
+    // records go out in the order the maps iterate, see restore()
+    raw(&header, sizeof(header));
+    raw(zeros, header.vehicles_offset - position);
+    for (auto const& vehicle : world.vehicles | std::views::values) {
+        auto const record = VehicleRecord::capture(vehicle);
+        raw(&record, sizeof(record));
+    }
+    raw(zeros, header.food_offset - position);
+    for (auto const& food : world.food | std::views::values) {
+        auto const record = FoodRecord::capture(food);
+        raw(&record, sizeof(record));
+    }
+}
+
+}  // namespace
+
+Snapshot::Header Snapshot::header_of(World const& world)
+{
+    Header header;
+    header.vehicle_count   = world.vehicles.size();
+    header.vehicles_offset = align_record(sizeof(Header));
+    header.vehicle_buckets = world.vehicles.bucket_count();
+    header.food_count      = world.food.size();
+    header.food_offset     = align_record(
+        header.vehicles_offset + header.vehicle_count * sizeof(VehicleRecord));
+    header.food_buckets    = world.food.bucket_count();
+    header.seed            = world.seed;
+    header.width           = world.width;
+    header.height          = world.height;
+    header.disable_night   = world.disable_night;
+    header.max_food        = world.max_food;
+    header.food_pct_chance = world.food_pct_chance;
+    header.feed_count      = world.feed_count;
+    header.tick_counter    = world.tick_counter;
+    header.born_counter    = world.born_counter;
+    header.dead_counter    = world.dead_counter;
+    header.max_age         = world.max_age;
+    header.daytime         = *world.daytime;
+    header.target_tps      = World::target_tps;
+    header.edge_threshold  = World::edge_threshold;
+    header.poison_chance   = World::poison_chance;
+    header.max_force       = Vehicle::MAX_FORCE;
+    header.max_health      = Vehicle::MAX_HEALTH;
+    header.fittest_id      = World::max_fitness.first;
+    header.fittest_fitness = World::max_fitness.second;
+    header.vehicle_id_base = Vehicle::id_base();
+    header.food_id_base    = Environmental::id_base();
+    header.commands_issued = world.commands_issued;
+    header.unbound         = RandomStream::unbound();
+    return header;
+}
+
+void Snapshot::save(World& world, std::string const& path)
+{
+    world.flush_events();
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Could not open snapshot " + path);
+    }
+    write_snapshot(world, header_of(world),
+                   [&](char const* bytes, std::uint64_t count) {
+                       out.write(bytes, static_cast<std::streamsize>(count));
+                   });
+
+    out.flush();
+    if (!out) {
+        throw std::runtime_error("Could not write snapshot " + path);
+    }
+}
+
+std::vector<std::byte> Snapshot::capture(World& world)
+{
+    world.flush_events();
+
+    std::vector<std::byte> bytes;
+    auto const             header = header_of(world);
+    bytes.reserve(header.food_offset + header.food_count * sizeof(FoodRecord));
+    write_snapshot(world, header, [&](char const* data, std::uint64_t count) {
+        auto const* first = reinterpret_cast<std::byte const*>(data);
+        bytes.insert(bytes.end(), first, first + count);
+    });
+    return bytes;
+}
+
+Snapshot::Snapshot(std::string const& path)
+{
+    int const fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw std::runtime_error("Could not open snapshot " + path);
+    }
+    struct stat info{};
+    if (fstat(fd, &info) != 0 ||
+        static_cast<std::size_t>(info.st_size) < sizeof(Header)) {
+        close(fd);
+        throw std::runtime_error(path + " is not a snapshot");
+    }
+
+    size         = static_cast<std::size_t>(info.st_size);
+    void* memory = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    REQUIRE(memory != MAP_FAILED);
+    madvise(memory, size, MADV_WILLNEED);
+    base   = memory;
+    mapped = true;
+
+    validate(path);
+}
+
+Snapshot::Snapshot(std::span<std::byte const> bytes)
+    : base(bytes.data()), size(bytes.size())
+{
+    if (size < sizeof(Header)) {
+        throw std::runtime_error("Snapshot is truncated");
+    }
+    validate("Snapshot");
+}
+
+Snapshot::~Snapshot()
+{
+    if (mapped) {
+        munmap(const_cast<void*>(base), size);
+    }
+}
+
+void Snapshot::validate(std::string const& name)
+{
+    auto const& h    = header();
+    auto const  fits = [&](std::uint64_t offset, std::uint64_t bytes) {
+        return offset % RECORD_ALIGNMENT == 0 && offset <= size &&
+               bytes <= size - offset;
+    };
+
+    char const* problem = nullptr;
+    if (std::memcmp(h.magic, Header{}.magic, sizeof(h.magic)) != 0) {
+        problem = " is not a snapshot";
+    } else if (h.version != VERSION ||
+               h.vehicle_record_size != sizeof(VehicleRecord) ||
+               h.food_record_size != sizeof(FoodRecord)) {
+        problem = " was written by another version";
+    } else if (!fits(h.vehicles_offset,
+                     h.vehicle_count * sizeof(VehicleRecord)) ||
+               !fits(h.food_offset, h.food_count * sizeof(FoodRecord))) {
+        problem = " is truncated";
+    }
+    if (problem) {
+        if (mapped) {
+            munmap(const_cast<void*>(base), size);
+        }
+        throw std::runtime_error(name + problem);
+    }
+}
+
+Snapshot::Header const& Snapshot::header() const noexcept
+{
+    return *static_cast<Header const*>(base);
+}
+
+std::span<VehicleRecord const> Snapshot::vehicles() const noexcept
+{
+    auto const* bytes = static_cast<char const*>(base);
+    return {reinterpret_cast<VehicleRecord const*>(bytes +
+                                                   header().vehicles_offset),
+            header().vehicle_count};
+}
+
+std::span<FoodRecord const> Snapshot::food() const noexcept
+{
+    auto const* bytes = static_cast<char const*>(base);
+    return {reinterpret_cast<FoodRecord const*>(bytes + header().food_offset),
+            header().food_count};
+}
+
+void Snapshot::restore(World& world) const
+{
+    auto const& h = header();
+    REQUIRE(world.seed == h.seed && world.width == h.width &&
+            world.height == h.height);
+
+    // the order in which the maps iterate decides the order in which
+    // entities act and so the ids of everything they create. Inserting the
+    // records backwards into as many buckets as the saved maps had rebuilds
+    // exactly the same order
+    world.actions = {};
+    world.vehicles.clear();
+    world.vehicles.rehash(h.vehicle_buckets);
+    for (auto const& record : vehicles() | std::views::reverse) {
+        world.vehicles.emplace(record.id, record.restore(&world));
+    }
+    world.food.clear();
+    world.food.rehash(h.food_buckets);
+    for (auto const& record : food() | std::views::reverse) {
+        world.food.emplace(record.id, record.restore(&world));
+    }
+
+    world.disable_night   = h.disable_night != 0;
+    world.max_food        = h.max_food;
+    world.food_pct_chance = h.food_pct_chance;
+    world.feed_count      = h.feed_count;
+    world.tick_counter    = h.tick_counter;
+    world.born_counter    = h.born_counter;
+    world.dead_counter    = h.dead_counter;
+    world.max_age         = h.max_age;
+    world.daytime.set(h.daytime);
+    world.commands_issued = h.commands_issued;
+    World::target_tps     = h.target_tps;
+    World::edge_threshold = h.edge_threshold;
+    World::poison_chance  = h.poison_chance;
+    Vehicle::MAX_FORCE    = h.max_force;
+    Vehicle::MAX_HEALTH   = h.max_health;
+    World::max_fitness    = {h.fittest_id, h.fittest_fitness};
+    Vehicle::set_id_base(h.vehicle_id_base);
+    Environmental::set_id_base(h.food_id_base);
+    RandomStream::unbound() = h.unbound;
+}
+
+}  // namespace tom
@@ -0,0 +1,694 @@
+#include "sweep.h"
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <random>
+#include <ranges>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include "checks.h"
+#include "entityrecord.h"
+#include "food.h"
+#include "snapshot.h"
+#include "utils.h"
+#include "vehicle.h"
+#include "world.h"
+
+namespace tom::sweep {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// what a run sends back to the parent through its pipe
+struct Result {
+    std::int32_t                         survival_ticks;
+    std::int32_t                         peak_vehicles;
+    std::int32_t                         births;
+    std::int32_t                         deaths;
+    std::int32_t                         vehicles;
+    double                               mean_vehicles;
+    double                               vehicle_variance;
+    std::array<double, DNARecord::GENES> genes;
+};
+
+struct Run {
+    int                 index;
+    long                seed;
+    std::vector<double> values;  // one per Config::parameters
+};
+
+int count_of(double value) noexcept
+{
+    return static_cast<int>(std::lround(value));
+}
+
+// a world setting that can be swept, with the option that sets it in main
+struct Setting {
+    std::string_view name;
+    std::string_view option;
+    bool             new_worlds_only;  // cannot change a snapshot's world
+    void (*set)(Config&, double);
+};
+
+constexpr std::array SETTINGS = {
+    Setting{"width", "-w", true,
+            [](Config& c, double v) { c.width = count_of(v); }},
+    Setting{"height", "-h", true,
+            [](Config& c, double v) { c.height = count_of(v); }},
+    Setting{"vehicles", "-s", true,
+            [](Config& c, double v) { c.vehicles = count_of(v); }},
+    Setting{"food", "-f", true,
+            [](Config& c, double v) { c.food = count_of(v); }},
+    Setting{"max_food", "-x", false,
+            [](Config& c, double v) {
+                c.max_food = static_cast<unsigned>(std::max(count_of(v), 0));
+            }},
+    Setting{"food_pct_chance", "-c", false,
+            [](Config& c, double v) { c.food_pct_chance = v; }},
+    Setting{"edge_threshold", "-e", false,
+            [](Config& c, double v) { c.edge_threshold = v; }},
+    Setting{"poison_chance", "--poison-chance", false,
+            [](Config& c, double v) { c.poison_chance = v; }},
+    Setting{"max_force", "--max-force", false,
+            [](Config& c, double v) { c.max_force = v; }},
+    Setting{"max_health", "--max-health", false,
+            [](Config& c, double v) { c.max_health = v; }},
+};
+
+Setting const& setting(std::string const& name)
+{
+    auto const found = std::ranges::find(SETTINGS, name, &Setting::name);
+    if (found == SETTINGS.end()) {
+        throw std::invalid_argument(name + " cannot be swept");
+    }
+    return *found;
+}
+
+// settings that make no sense for the start world, or that do not exist
+void validate(Config const& config)
+{
+    for (auto const& parameter : config.parameters) {
+        if (config.start && setting(parameter.name).new_worlds_only) {
+            throw std::invalid_argument(parameter.name +
+                                        " is fixed by the loaded snapshot");
+        }
+    }
+}
+
+std::vector<Run> plan(Config const& config)
+{
+    auto const&                      parameters = config.parameters;
+    std::vector<std::vector<double>> points;
+
+    if (config.samples > 0) {
+        // a fixed generator so that a resumed sweep samples the same points
+        std::mt19937_64 generator(static_cast<std::uint64_t>(config.seed));
+        auto const      uniform = [&] {
+            return static_cast<double>(generator() >> 11) * 0x1.0p-53;
+        };
+        for (int i = 0; i < config.samples; i++) {
+            auto& point = points.emplace_back();
+            for (auto const& parameter : parameters) {
+                auto const& values = parameter.values;
+                point.push_back(
+                    values.empty()
+                        ? parameter.low +
+                              uniform() * (parameter.high - parameter.low)
+                        : values[generator() % values.size()]);
+            }
+        }
+    } else {
+        points.emplace_back();
+        for (auto const& parameter : parameters) {
+            if (parameter.values.empty()) {
+                throw std::invalid_argument(
+                    parameter.name +
+                    " needs a step or a list unless runs are sampled");
+            }
+            std::vector<std::vector<double>> grid;
+            for (auto const& point : points) {
+                for (double value : parameter.values) {
+                    grid.push_back(point);
+                    grid.back().push_back(value);
+                }
+            }
+            points = std::move(grid);
+        }
+    }
+
+    std::vector<Run> runs;
+    for (auto const& point : points) {
+        for (int i = 0; i < config.seeds; i++) {
+            runs.push_back({.index  = static_cast<int>(runs.size()),
+                            .seed   = config.seed + i,
+                            .values = point});
+        }
+    }
+    return runs;
+}
+
+std::string csv_header(Config const& config)
+{
+    std::string header = "run,seed";
+    for (auto const& parameter : config.parameters) {
+        header += "," + parameter.name;
+    }
+    header += ",survival_ticks,peak_vehicles,births,deaths,vehicles,"
+              "mean_vehicles,vehicle_variance";
+    for (auto gene : DNARecord::GENE_NAMES) {
+        header += ",mean_" + std::string(gene);
+    }
+    return header;
+}
+
+// the columns of a row that the plan decides: run, seed and the values
+std::string csv_key(Run const& run)
+{
+    std::ostringstream key;
+    key << std::setprecision(10) << run.index << "," << run.seed;
+    for (double value : run.values) {
+        key << "," << value;
+    }
+    return key.str();
+}
+
+std::string csv_row(Run const& run, Result const& result)
+{
+    std::ostringstream row;
+    row << std::setprecision(10) << csv_key(run) << ","
+        << result.survival_ticks << "," << result.peak_vehicles << ","
+        << result.births << "," << result.deaths << "," << result.vehicles
+        << "," << result.mean_vehicles << "," << result.vehicle_variance;
+    for (double gene : result.genes) {
+        row << "," << gene;
+    }
+    return row.str();
+}
+
+/**
+ * The runs already in the CSV at path, which is created with header if it
+ * is not there. A row cut short by a crash is removed. Throws if a row is
+ * not one of runs, seed and values included: resuming with another -r,
+ * --sweep-seeds or --sweep-samples would mix two sweeps in one file
+ */
+std::set<int> finished_runs(std::string const&      path,
+                            std::string const&      header,
+                            std::vector<Run> const& runs)
+{
+    std::set<int> finished;
+    if (!fs::exists(path) || fs::file_size(path) == 0) {
+        std::ofstream out(path);
+        if (!(out << header << "\n")) {
+            throw std::runtime_error("Could not write " + path);
+        }
+        return finished;
+    }
+
+    std::ifstream in(path);
+    std::string   line;
+    if (!std::getline(in, line) || line != header) {
+        throw std::runtime_error(path + " holds another sweep's results");
+    }
+    std::uintmax_t complete = in.tellg();
+    while (std::getline(in, line)) {
+        if (in.eof()) {
+            break;  // no newline: the row was not written completely
+        }
+        auto const index = std::stoi(line);
+        auto const i     = static_cast<std::size_t>(index);
+        if (index < 0 || i >= runs.size() ||
+            !line.starts_with(csv_key(runs[i]) + ",")) {
+            throw std::runtime_error(
+                path + " holds run " + std::to_string(index) +
+                " of another sweep; resume with the same -r, --sweep-seeds "
+                "and --sweep-samples, or write to another file");
+        }
+        finished.insert(index);
+        complete = static_cast<std::uintmax_t>(in.tellg());
+    }
+    in.close();
+    fs::resize_file(path, complete);
+    return finished;
+}
+
+World new_world(Config const& config, long seed)
+{
+    if (!config.start) {
+        return World(seed, config.width, config.height);
+    }
+    auto const& header = config.start->header();
+    return World(header.seed, header.width, header.height);
+}
+
+void configure(World& world, Config const& config) noexcept
+{
+    World::edge_threshold = config.edge_threshold;
+    World::poison_chance  = config.poison_chance;
+    Vehicle::MAX_FORCE    = config.max_force;
+    Vehicle::MAX_HEALTH   = config.max_health;
+    world.disable_night   = config.disable_night;
+    world.max_food        = config.max_food;
+    world.food_pct_chance = config.food_pct_chance;
+}
+
+// fill a world made by new_world()
+void populate(World& world, Config const& config, long seed)
+{
+    if (!config.start) {
+        world.populate_world(config.vehicles, config.food);
+        return;
+    }
+    config.start->restore(world);
+    // every seed continues the same world differently
+    world.seed = seed;
+    set_seed(seed);
+}
+
+Result simulate(Config config, Run const& run)
+{
+    for (std::size_t i = 0; i < config.parameters.size(); i++) {
+        setting(config.parameters[i].name).set(config, run.values[i]);
+    }
+
+    set_seed(run.seed);
+    World world = new_world(config, run.seed);
+    // the parent owns SIGINT and ends the runs itself
+    signal(SIGINT, SIG_IGN);
+    // before populating, which uses them, and again after, since restoring
+    // a snapshot sets them to its own
+    configure(world, config);
+    populate(world, config, run.seed);
+    configure(world, config);
+
+    // the population after every tick; ticks after the last vehicle died
+    // count as none left
+    Result     result{};
+    double     sum     = 0.0;
+    double     squares = 0.0;
+    auto const first   = world.tick_counter;
+    for (int i = 0; i < config.ticks; i++) {
+        if (!world.vehicles.empty()) {
+            world.tick();
+        }
+        auto const alive = static_cast<std::int32_t>(world.vehicles.size());
+        if (alive > 0) {
+            result.survival_ticks = world.tick_counter - first;
+        }
+        result.peak_vehicles  = std::max(result.peak_vehicles, alive);
+        sum                  += alive;
+        squares              += static_cast<double>(alive) * alive;
+    }
+    if (config.ticks > 0) {
+        result.mean_vehicles    = sum / config.ticks;
+        result.vehicle_variance = std::max(
+            0.0, squares / config.ticks -
+                     result.mean_vehicles * result.mean_vehicles);
+    }
+
+    result.births   = world.born_counter;
+    result.deaths   = world.dead_counter;
+    result.vehicles = static_cast<std::int32_t>(world.vehicles.size());
+    for (auto const& vehicle : world.vehicles | std::views::values) {
+        auto const genes = DNARecord::capture(vehicle.get_dna()).genes();
+        for (std::size_t i = 0; i < genes.size(); i++) {
+            result.genes[i] += genes[i] / result.vehicles;
+        }
+    }
+    return result;
+}
+
+unsigned job_count(Config const& config)
+{
+    return config.jobs > 0 ? config.jobs
+                           : std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * Run each of runs in a forked child, job_count() at a time, and hand every
+ * result to done as it comes in. Returns how many runs failed; runs that
+ * were cut short by an interrupt do not count
+ */
+int evaluate(Config const&                                    config,
+             std::vector<Run const*> const&                   runs,
+             std::function<void(Run const&, Result const&)> const& done)
+{
+    // not restarted after a signal, so that Ctrl-C is noticed at once
+    struct sigaction interrupt{};
+    interrupt.sa_handler = World::stop_running;
+    sigaction(SIGINT, &interrupt, nullptr);
+
+    struct Running {
+        Run const* run;
+        int        fd;  // the read end of its pipe
+    };
+    std::map<pid_t, Running> running;
+    auto const               jobs   = job_count(config);
+    auto                     next   = runs.begin();
+    int                      failed = 0;
+
+    for (;;) {
+        while (!World::was_interrupted && running.size() < jobs &&
+               next != runs.end()) {
+            auto const& run = **next++;
+            int         ends[2];
+            REQUIRE(pipe(ends) == 0);
+            pid_t const pid = fork();
+            if (pid == 0) {
+                close(ends[0]);
+                auto const result = simulate(config, run);
+                auto const wrote  = write(ends[1], &result, sizeof(result));
+                _exit(wrote == sizeof(result) ? EXIT_SUCCESS : EXIT_FAILURE);
+            }
+            close(ends[1]);
+            if (pid < 0) {
+                close(ends[0]);
+                throw std::runtime_error("Could not fork a run");
+            }
+            running[pid] = {&run, ends[0]};
+        }
+        if (running.empty()) {
+            break;
+        }
+
+        int         status;
+        pid_t const pid = waitpid(-1, &status, 0);
+        if (pid < 0) {
+            if (errno == EINTR) {
+                for (auto const& [child, _] : running) {
+                    kill(child, SIGTERM);
+                }
+                continue;
+            }
+            break;
+        }
+        auto const [run, fd] = running.at(pid);
+        running.erase(pid);
+
+        // a Result fits in a pipe's buffer, so it is all there by now
+        Result     result;
+        auto const got = read(fd, &result, sizeof(result));
+        close(fd);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS ||
+            got != sizeof(result)) {
+            failed += !World::was_interrupted;
+            continue;
+        }
+        done(*run, result);
+    }
+    return failed;
+}
+
+double score(Result const& result, Objective objective) noexcept
+{
+    switch (objective) {
+        case Objective::SURVIVAL:
+            return result.survival_ticks;
+        case Objective::POPULATION:
+            return result.mean_vehicles;
+        case Objective::STABILITY:
+            return result.mean_vehicles /
+                   (1.0 + std::sqrt(result.vehicle_variance));
+    }
+    return 0.0;
+}
+
+}  // namespace
+
+Parameter parse_parameter(std::string const& spec)
+{
+    auto const equals = spec.find('=');
+    if (equals == std::string::npos || equals == 0) {
+        throw std::invalid_argument("Expected name=values, got " + spec);
+    }
+    Parameter parameter;
+    parameter.name = spec.substr(0, equals);
+    setting(parameter.name);
+
+    auto const numbers = [&](char delimiter) {
+        std::vector<double> found;
+        std::stringstream   rest(spec.substr(equals + 1));
+        for (std::string number; std::getline(rest, number, delimiter);) {
+            found.push_back(std::stod(number));
+        }
+        return found;
+    };
+
+    if (spec.find(',') != std::string::npos) {
+        parameter.values = numbers(',');
+        return parameter;
+    }
+    auto const range = numbers(':');
+    if (range.size() == 1) {
+        parameter.values = range;
+    } else if (range.size() == 2 && range[0] <= range[1]) {
+        parameter.low  = range[0];
+        parameter.high = range[1];
+    } else if (range.size() == 3 && range[0] <= range[1] && range[2] > 0.0) {
+        // the step may not land on last exactly
+        for (double value = range[0]; value <= range[1] + range[2] * 1e-9;
+             value += range[2]) {
+            parameter.values.push_back(value);
+        }
+    } else {
+        throw std::invalid_argument("Expected first:last[:step] or a list, "
+                                    "got " +
+                                    spec);
+    }
+    return parameter;
+}
+
+int run(Config const& config)
+{
+    validate(config);
+    auto const runs   = plan(config);
+    auto const header = csv_header(config);
+    auto const done   = finished_runs(config.output, header, runs);
+
+    std::ofstream out(config.output, std::ios::app);
+    if (!out) {
+        throw std::runtime_error("Could not open " + config.output);
+    }
+    output(runs.size(), " runs, ", done.size(), " already done, ",
+           job_count(config), " at a time\n");
+
+    std::vector<Run const*> todo;
+    for (auto const& run : runs) {
+        if (!done.contains(run.index)) {
+            todo.push_back(&run);
+        }
+    }
+    auto const failed =
+        evaluate(config, todo, [&](Run const& run, Result const& result) {
+            out << csv_row(run, result) << "\n" << std::flush;
+            output("run ", run.index, " (seed ", run.seed, "): survived ",
+                   result.survival_ticks, " ticks, peak ",
+                   result.peak_vehicles, " vehicles\n");
+        });
+
+    if (failed > 0) {
+        std::cerr << failed << " runs failed.\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+Objective parse_objective(std::string const& name)
+{
+    if (name == "survival") {
+        return Objective::SURVIVAL;
+    }
+    if (name == "population") {
+        return Objective::POPULATION;
+    }
+    if (name == "stability") {
+        return Objective::STABILITY;
+    }
+    throw std::invalid_argument("Unknown objective " + name);
+}
+
+int optimize(Config const& config, Search const& search)
+{
+    validate(config);
+    auto const& parameters = config.parameters;
+    auto const  n          = parameters.size();
+    if (n == 0) {
+        throw std::invalid_argument("Nothing to optimize");
+    }
+
+    // searched in [0, 1] per parameter, mapped onto its range when run
+    std::vector<double> low;
+    std::vector<double> high;
+    for (auto const& parameter : parameters) {
+        if (parameter.values.empty()) {
+            low.push_back(parameter.low);
+            high.push_back(parameter.high);
+        } else {
+            low.push_back(std::ranges::min(parameter.values));
+            high.push_back(std::ranges::max(parameter.values));
+        }
+    }
+    auto const values_of = [&](std::vector<double> const& x) {
+        std::vector<double> values;
+        for (std::size_t j = 0; j < n; j++) {
+            values.push_back(low[j] + x[j] * (high[j] - low[j]));
+        }
+        return values;
+    };
+
+    // the usual population size of an evolution strategy, but enough to
+    // keep every core busy; the better half are the parents
+    auto const lambda = static_cast<std::size_t>(
+        search.population > 0
+            ? search.population
+            : std::max(4 + static_cast<int>(3 * std::log(n)),
+                       static_cast<int>(job_count(config))));
+    auto const          mu = std::max<std::size_t>(1, lambda / 2);
+    std::vector<double> weights;
+    for (std::size_t i = 0; i < mu; i++) {
+        weights.push_back(std::log(mu + 0.5) - std::log(i + 1.0));
+    }
+    auto const total = std::accumulate(weights.begin(), weights.end(), 0.0);
+    for (double& weight : weights) {
+        weight /= total;
+    }
+
+    std::ofstream out(config.output, std::ios::trunc);
+    std::string   header = "generation,candidate";
+    for (auto const& parameter : parameters) {
+        header += "," + parameter.name;
+    }
+    if (!(out << header << ",score,survival_ticks,mean_vehicles\n")) {
+        throw std::runtime_error("Could not write " + config.output);
+    }
+    output(lambda, " candidates per generation, ", config.seeds,
+           " seeds each, ", job_count(config), " runs at a time\n");
+
+    std::mt19937_64 generator(static_cast<std::uint64_t>(config.seed));
+    std::normal_distribution<double> normal;
+    std::vector<double>              mean(n, 0.5);
+    std::vector<double>              spread(n, 0.3);
+    std::vector<double>              best_values;
+    double best   = -std::numeric_limits<double>::infinity();
+    int    failed = 0;
+
+    for (int generation = 0;
+         generation < search.generations && !World::was_interrupted;
+         generation++) {
+        std::vector<std::vector<double>> candidates(lambda);
+        std::vector<Run>                 runs;
+        for (std::size_t k = 0; k < lambda; k++) {
+            for (std::size_t j = 0; j < n; j++) {
+                candidates[k].push_back(std::clamp(
+                    mean[j] + spread[j] * normal(generator), 0.0, 1.0));
+            }
+            for (int s = 0; s < config.seeds; s++) {
+                runs.push_back({.index  = static_cast<int>(runs.size()),
+                                .seed   = config.seed + s,
+                                .values = values_of(candidates[k])});
+            }
+        }
+
+        std::vector<Run const*> todo;
+        for (auto const& run : runs) {
+            todo.push_back(&run);
+        }
+        std::vector<double> scores(lambda, 0.0);
+        std::vector<double> survival(lambda, 0.0);
+        std::vector<double> population(lambda, 0.0);
+        std::vector<int>    finished(lambda, 0);
+        failed += evaluate(
+            config, todo, [&](Run const& run, Result const& result) {
+                auto const k = static_cast<std::size_t>(run.index) /
+                               static_cast<std::size_t>(config.seeds);
+                scores[k]     += score(result, search.objective);
+                survival[k]   += result.survival_ticks;
+                population[k] += result.mean_vehicles;
+                finished[k]++;
+            });
+        if (World::was_interrupted) {
+            break;  // a generation that was cut short says nothing
+        }
+
+        // candidates whose runs failed are ranked last
+        std::vector<std::size_t> ranked(lambda);
+        std::iota(ranked.begin(), ranked.end(), 0);
+        for (std::size_t k = 0; k < lambda; k++) {
+            scores[k] = finished[k] == config.seeds
+                            ? scores[k] / config.seeds
+                            : -std::numeric_limits<double>::infinity();
+        }
+        std::ranges::sort(ranked, std::greater{},
+                          [&](std::size_t k) { return scores[k]; });
+
+        for (std::size_t k = 0; k < lambda; k++) {
+            out << generation << "," << k << std::setprecision(10);
+            for (double value : values_of(candidates[k])) {
+                out << "," << value;
+            }
+            out << "," << scores[k] << "," << survival[k] / config.seeds
+                << "," << population[k] / config.seeds << "\n";
+        }
+        out << std::flush;
+
+        auto const leader = ranked.front();
+        if (scores[leader] > best) {
+            best        = scores[leader];
+            best_values = values_of(candidates[leader]);
+        }
+        output("generation ", generation, ": best ", scores[leader],
+               ", best so far ", best, "\n");
+
+        // the mean moves to the weighted parents and the spread becomes
+        // theirs around the old mean, half way, so that it neither collapses
+        // after one lucky generation nor stays wide forever
+        std::vector<double> moved(n, 0.0);
+        std::vector<double> deviation(n, 0.0);
+        for (std::size_t i = 0; i < mu; i++) {
+            auto const& x = candidates[ranked[i]];
+            for (std::size_t j = 0; j < n; j++) {
+                moved[j]     += weights[i] * x[j];
+                auto const d  = x[j] - mean[j];
+                deviation[j] += weights[i] * d * d;
+            }
+        }
+        for (std::size_t j = 0; j < n; j++) {
+            spread[j] =
+                std::max(0.01, (spread[j] + std::sqrt(deviation[j])) / 2);
+        }
+        mean = std::move(moved);
+    }
+
+    if (!best_values.empty()) {
+        std::ostringstream options;
+        for (std::size_t j = 0; j < n; j++) {
+            options << " " << setting(parameters[j].name).option << " "
+                    << best_values[j];
+        }
+        output("best score ", best, " with", options.str(), "\n");
+    }
+    if (failed > 0) {
+        std::cerr << failed << " runs failed.\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+}  // namespace tom::sweep
@@ -0,0 +1,110 @@
+#include "tickrate.h"
+#include <algorithm>
+#include <iomanip>
+
+namespace tom {
+
+namespace {
+
+TickRate::Duration duration(std::uint64_t ns)
+{
+    return std::chrono::duration_cast<TickRate::Duration>(
+        std::chrono::nanoseconds(ns));
+}
+
+}  // namespace
+
+void TickRate::record(TimePoint start,
+                      TimePoint done,
+                      Duration  deadline) noexcept
+{
+    if (last_slot < 0) {
+        first = start;
+    }
+    // slots that went by without a tick count none
+    auto const slot = slot_of(done);
+    for (auto s = std::max(last_slot + 1, slot - std::int64_t{SLOTS} + 1);
+         s <= slot; s++) {
+        counts[static_cast<std::size_t>(s) % SLOTS] = 0;
+    }
+    last_slot = std::max(last_slot, slot);
+    counts[static_cast<std::size_t>(slot) % SLOTS]++;
+
+    auto const elapsed = done - start;
+    auto const ns      = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        elapsed);
+    latencies.next().record(static_cast<std::uint64_t>(
+        std::max(ns.count(), std::chrono::nanoseconds::rep{})));
+
+    ticks++;
+    if (deadline > Duration::zero()) {
+        paced++;
+        missed += elapsed > deadline ? 1 : 0;
+    }
+}
+
+double TickRate::tps(Duration window, TimePoint now) const noexcept
+{
+    if (last_slot < 0 || now <= first) {
+        return 0.0;
+    }
+    auto const slots    = std::clamp<std::int64_t>(window / SLOT, 1, SLOTS);
+    auto const now_slot = slot_of(now);
+    auto const oldest   = std::max<std::int64_t>(now_slot - slots + 1, 0);
+
+    std::uint64_t counted = 0;
+    for (auto s = std::max(oldest, last_slot - std::int64_t{SLOTS} + 1);
+         s <= last_slot; s++) {
+        counted += counts[static_cast<std::size_t>(s) % SLOTS];
+    }
+    std::chrono::duration<double> const covered =
+        now - std::max(first, first + oldest * SLOT);
+    return covered.count() > 0.0 ? counted / covered.count() : 0.0;
+}
+
+TickRate::Summary TickRate::summary(TimePoint now) const noexcept
+{
+    auto const merged = latencies.merged();
+    return {
+        .tps_1s  = tps(std::chrono::seconds{1}, now),
+        .tps_10s = tps(std::chrono::seconds{10}, now),
+        .p50     = duration(merged.at(0.50)),
+        .p95     = duration(merged.at(0.95)),
+        .p99     = duration(merged.at(0.99)),
+        .max     = duration(merged.max()),
+        .ticks   = ticks,
+        .missed  = missed,
+        .paced   = paced,
+    };
+}
+
+void TickRate::reset() noexcept
+{
+    *this = {};
+}
+
+void TickRate::write(std::ostream& out) const
+{
+    auto const ms = [](Duration duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    };
+    auto const now       = summary();
+    auto const flags     = out.flags();
+    auto const precision = out.precision();
+    out << std::fixed << std::setprecision(1) << "TPS " << now.tps_1s
+        << " (1 s), " << now.tps_10s << " (10 s); tick ms p50/p95/p99/max: "
+        << std::setprecision(2) << ms(now.p50) << "/" << ms(now.p95) << "/"
+        << ms(now.p99) << "/" << ms(now.max);
+    if (now.paced > 0) {
+        out << "; missed deadlines: " << now.missed << " of " << now.paced;
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+std::int64_t TickRate::slot_of(TimePoint time) const noexcept
+{
+    return (time - first) / SLOT;
+}
+
+}  // namespace tom
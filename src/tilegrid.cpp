@@ -0,0 +1,95 @@
+#include "tilegrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "food.h"
+#include "utils.h"
+#include "vehicle.h"
+#include "world.h"
+
+namespace tom {
+
+// tiles never get smaller than this even if nothing can see very far
+static constexpr double MIN_TILE_SIZE = 16.0;
+
+void TileGrid::rebuild(World& world)
+{
+    double reach = MIN_TILE_SIZE;
+    for (auto const& [id, v] : world.vehicles) {
+        reach = std::max(reach, v.get_dna().perception_radius);
+    }
+    for (auto const& [id, f] : world.food) {
+        reach = std::max(reach, f.dna.perceptionRadius);
+    }
+
+    // vehicles may stray up to the edge threshold past the edges before
+    // they die and food is kept inside of it
+    margin    = World::edge_threshold;
+    tile_size = reach;
+    columns   = std::max(1, static_cast<int>(std::ceil(
+                                (world.width + 2 * margin) / tile_size)));
+    rows      = std::max(1, static_cast<int>(std::ceil(
+                             (world.height + 2 * margin) / tile_size)));
+
+    auto const tiles = tile_count();
+    vehicles.resize(tiles);
+    food.resize(tiles);
+    for (std::size_t t = 0; t < tiles; t++) {
+        vehicles[t].clear();
+        food[t].clear();
+    }
+
+    for (auto& [id, v] : world.vehicles) {
+        vehicles[tile_of(v.get_position())].emplace_back(id, &v);
+    }
+    for (auto& [id, f] : world.food) {
+        food[tile_of(f.get_position())].emplace_back(id, &f);
+    }
+}
+
+std::size_t TileGrid::tile_count() const noexcept
+{
+    return static_cast<std::size_t>(columns) * rows;
+}
+
+std::size_t TileGrid::tile_of(Vec2D const& position) const noexcept
+{
+    auto const column = constrain(
+        static_cast<int>(std::floor((position.x + margin) / tile_size)), 0,
+        columns - 1);
+    auto const row = constrain(
+        static_cast<int>(std::floor((position.y + margin) / tile_size)), 0,
+        rows - 1);
+    return static_cast<std::size_t>(row) * columns + column;
+}
+
+void TileGrid::neighbourhood(std::size_t tile, VehicleRefs& out) const
+{
+    gather(tile, vehicles, out);
+}
+
+void TileGrid::neighbourhood(std::size_t tile, FoodRefs& out) const
+{
+    gather(tile, food, out);
+}
+
+template <typename Refs>
+void TileGrid::gather(std::size_t              tile,
+                      std::vector<Refs> const& from,
+                      Refs&                    out) const
+{
+    out.clear();
+
+    int const column = static_cast<int>(tile % columns);
+    int const row    = static_cast<int>(tile / columns);
+    for (int r = std::max(0, row - 1); r <= std::min(rows - 1, row + 1); r++) {
+        for (int c = std::max(0, column - 1);
+             c <= std::min(columns - 1, column + 1); c++) {
+            auto const& refs = from[static_cast<std::size_t>(r) * columns + c];
+            out.insert(out.end(), refs.begin(), refs.end());
+        }
+    }
+}
+
+}  // namespace tom
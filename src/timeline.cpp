@@ -0,0 +1,144 @@
+#include "timeline.h"
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace tom {
+
+std::atomic<bool> Timeline::active{false};
+std::atomic<bool> Timeline::dump_requested{false};
+
+namespace {
+
+struct Event {
+    char const*                 category;
+    char const*                 name;
+    Timeline::Clock::time_point begin;
+    Timeline::Clock::time_point end;
+};
+
+// written only by its own thread; `written` counts every event ever
+// recorded, the last CAPACITY of which are still in the ring
+struct Ring {
+    explicit Ring(std::size_t thread) : thread(thread)
+    {
+    }
+
+    std::size_t                thread;
+    std::unique_ptr<Event[]>   events = std::make_unique<Event[]>(
+        Timeline::CAPACITY);
+    std::atomic<std::uint64_t> written{0};
+};
+
+std::mutex                         registry_mutex;
+// never freed, so that the spans of threads that ended can still be written
+std::vector<std::unique_ptr<Ring>> rings;
+std::string                        output;
+Timeline::Clock::time_point        epoch;
+
+thread_local Ring* ring = nullptr;
+
+Ring& this_thread_ring()
+{
+    if (!ring) {
+        std::lock_guard lock(registry_mutex);
+        rings.push_back(std::make_unique<Ring>(rings.size()));
+        ring = rings.back().get();
+    }
+    return *ring;
+}
+
+double microseconds(Timeline::Clock::duration duration)
+{
+    return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+}  // namespace
+
+void Timeline::start(std::string path)
+{
+    {
+        std::lock_guard lock(registry_mutex);
+        output = std::move(path);
+        epoch  = Clock::now();
+    }
+    active.store(true, std::memory_order_relaxed);
+}
+
+void Timeline::stop() noexcept
+{
+    active.store(false, std::memory_order_relaxed);
+}
+
+void Timeline::record(char const*       category,
+                      char const*       name,
+                      Clock::time_point begin,
+                      Clock::time_point end) noexcept
+{
+    auto&      mine = this_thread_ring();
+    auto const n    = mine.written.load(std::memory_order_relaxed);
+    mine.events[n % CAPACITY] = {category, name, begin, end};
+    mine.written.store(n + 1, std::memory_order_release);
+}
+
+void Timeline::write(std::ostream& out)
+{
+    std::lock_guard lock(registry_mutex);
+
+    auto const flags     = out.flags();
+    auto const precision = out.precision();
+    out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [" << std::fixed
+        << std::setprecision(3);
+    char const* separator = "\n";
+    for (auto const& ring : rings) {
+        out << separator << "{\"name\": \"thread_name\", \"ph\": \"M\", "
+            << "\"pid\": 1, \"tid\": " << ring->thread
+            << ", \"args\": {\"name\": \"thread " << ring->thread << "\"}}";
+        separator = ",\n";
+
+        auto const n    = ring->written.load(std::memory_order_acquire);
+        auto const from = n > CAPACITY ? n - CAPACITY : 0;
+        for (auto i = from; i < n; i++) {
+            auto const& event = ring->events[i % CAPACITY];
+            out << separator << "{\"name\": \"" << event.name
+                << "\", \"cat\": \"" << event.category
+                << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << ring->thread
+                << ", \"ts\": " << microseconds(event.begin - epoch)
+                << ", \"dur\": " << microseconds(event.end - event.begin)
+                << "}";
+        }
+    }
+    out << "\n]}\n";
+    out.flags(flags);
+    out.precision(precision);
+}
+
+void Timeline::dump()
+{
+    std::string path;
+    {
+        std::lock_guard lock(registry_mutex);
+        path = output;
+    }
+    std::ofstream out(path);
+    write(out);
+    if (!out) {
+        throw std::runtime_error("Could not write the timeline to " + path);
+    }
+}
+
+void Timeline::request_dump() noexcept
+{
+    dump_requested.store(true, std::memory_order_relaxed);
+}
+
+bool Timeline::take_dump_request() noexcept
+{
+    return dump_requested.exchange(false, std::memory_order_relaxed);
+}
+
+}  // namespace tom
@@ -0,0 +1,313 @@
+#include "trace.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <ranges>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "entityrecord.h"
+#include "food.h"
+#include "vehicle.h"
+#include "world.h"
+
+namespace tom {
+
+namespace {
+
+// folds values into 64 bits one at a time, splitmix64 style
+class Hasher {
+   public:
+    void add(std::uint64_t value) noexcept
+    {
+        state = mix((state + 0x9E3779B97F4A7C15) ^ value);
+    }
+
+    void add(double value) noexcept
+    {
+        // -0.0 and 0.0 behave alike, so they should not tell runs apart
+        add(value == 0.0 ? std::uint64_t{0}
+                         : std::bit_cast<std::uint64_t>(value));
+    }
+
+    void add(Vec2D const& value) noexcept
+    {
+        add(value.x);
+        add(value.y);
+    }
+
+    void add(Countdown const& countdown) noexcept
+    {
+        add(countdown.probability);
+        add(std::uint64_t{countdown.remaining});
+    }
+
+    [[nodiscard]]
+    std::uint64_t value() const noexcept
+    {
+        return state;
+    }
+
+   private:
+    static constexpr std::uint64_t mix(std::uint64_t x) noexcept
+    {
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+        return x ^ (x >> 31);
+    }
+
+    std::uint64_t state = 0;
+};
+
+template <typename Int>
+std::uint64_t bits(Int value) noexcept
+{
+    return static_cast<std::uint64_t>(value);
+}
+
+constexpr std::uint64_t vehicle_key(std::uint64_t id) noexcept
+{
+    return id << 1 | 1;
+}
+
+constexpr std::uint64_t food_key(std::uint64_t id) noexcept
+{
+    return id << 1;
+}
+
+std::string describe(World const& world, std::uint64_t key)
+{
+    std::ostringstream out;
+    auto const         id = key >> 1;
+    if (key & 1) {
+        out << "vehicle " << id;
+        if (auto found = world.vehicles.find(id);
+            found != world.vehicles.end()) {
+            auto const& vehicle = found->second;
+            out << " (now at " << vehicle.get_position().x << ", "
+                << vehicle.get_position().y << " with "
+                << vehicle.get_health().remaining() << " health)";
+        }
+    } else {
+        out << "food " << id;
+        if (auto found = world.food.find(id); found != world.food.end()) {
+            auto const& food = found->second;
+            out << " (now at " << food.position.x << ", " << food.position.y
+                << " with " << food.dna.nutrition << " nutrition)";
+        }
+    }
+    return out.str();
+}
+
+// the first entity that is not the same in both, by key
+std::string first_difference(World const&                     world,
+                             std::vector<Trace::Entity> const& expected,
+                             std::vector<Trace::Entity> const& actual)
+{
+    auto want = expected.begin();
+    auto have = actual.begin();
+    while (want != expected.end() || have != actual.end()) {
+        if (have == actual.end() ||
+            (want != expected.end() && want->key < have->key)) {
+            return describe(world, want->key) + " is missing";
+        }
+        if (want == expected.end() || have->key < want->key) {
+            return describe(world, have->key) + " should not be there";
+        }
+        if (want->hash != have->hash) {
+            return describe(world, want->key) + " is not the same";
+        }
+        ++want;
+        ++have;
+    }
+    return "no entity differs, the world around them does";
+}
+
+}  // namespace
+
+std::uint64_t state_hash(Vehicle const& vehicle) noexcept
+{
+    auto const  record = VehicleRecord::capture(vehicle);
+    auto const& dna    = record.dna;
+
+    Hasher hash;
+    hash.add(record.id);
+    hash.add(record.last_sought_vehicle_id);
+    hash.add(record.last_sought_food_id);
+    hash.add(record.position);
+    hash.add(record.velocity);
+    hash.add(record.acceleration);
+    hash.add(record.wander_target);
+    hash.add(record.health);
+    hash.add(record.mass);
+    hash.add(bits(record.age));
+    hash.add(bits(record.time_since_last_reproduction));
+    hash.add(bits(record.generation));
+    hash.add(bits(record.behavior_state));
+    hash.add(record.explosion_countdown);
+    for (double gene :
+         {dna.perception_radius, dna.max_speed, dna.mutation_rate,
+          dna.reproduction_cost, dna.malice_desire, dna.altruism_desire,
+          dna.malice_probability, dna.altruism_probability, dna.malice_damage,
+          dna.altruism_heal, dna.explosion_chance, dna.explosion_tries,
+          dna.edge_repulsion}) {
+        hash.add(gene);
+    }
+    hash.add(bits(dna.reproduction_cooldown));
+    hash.add(bits(dna.age_of_maturity));
+    return hash.value();
+}
+
+std::uint64_t state_hash(Food const& food) noexcept
+{
+    auto const  record = FoodRecord::capture(food);
+    auto const& dna    = record.dna;
+
+    Hasher hash;
+    hash.add(record.id);
+    hash.add(record.position);
+    hash.add(record.velocity);
+    hash.add(record.acceleration);
+    hash.add(record.velocity_dampening);
+    hash.add(bits(record.lifespan));
+    hash.add(record.flee_countdown);
+    hash.add(record.spawn_countdown);
+    hash.add(record.explosion_countdown);
+    for (double gene : {dna.nutrition, dna.lifeticks, dna.speed,
+                        dna.explosionChance, dna.explosionCount,
+                        dna.mutationRate, dna.perceptionRadius,
+                        dna.fleeChance, dna.fleeStrength}) {
+        hash.add(gene);
+    }
+    return hash.value();
+}
+
+std::uint64_t state_hash(World const& world) noexcept
+{
+    // sums do not care about the order they are added up in
+    std::uint64_t vehicles = 0;
+    for (auto const& vehicle : world.vehicles | std::views::values) {
+        vehicles += state_hash(vehicle);
+    }
+    std::uint64_t food = 0;
+    for (auto const& item : world.food | std::views::values) {
+        food += state_hash(item);
+    }
+
+    Hasher hash;
+    hash.add(bits(world.tick_counter));
+    hash.add(bits(world.born_counter));
+    hash.add(bits(world.dead_counter));
+    hash.add(bits(*world.daytime));
+    hash.add(bits(world.vehicles.size()));
+    hash.add(vehicles);
+    hash.add(bits(world.food.size()));
+    hash.add(food);
+    return hash.value();
+}
+
+Trace::Trace(std::string const& path, Header const& header)
+    : out(path, std::ios::binary | std::ios::trunc)
+{
+    if (!out) {
+        throw std::runtime_error("Could not open trace " + path);
+    }
+    out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+}
+
+void Trace::append(World const& world)
+{
+    auto const entities = entities_of(world);
+    Tick const tick{
+        .tick         = world.tick_counter,
+        .entity_count = static_cast<std::uint32_t>(entities.size()),
+        .hash         = state_hash(world),
+    };
+    out.write(reinterpret_cast<char const*>(&tick), sizeof(tick));
+    out.write(reinterpret_cast<char const*>(entities.data()),
+              static_cast<std::streamsize>(entities.size() * sizeof(Entity)));
+    if (!out) {
+        throw std::runtime_error("Could not write trace");
+    }
+}
+
+Trace::Header Trace::read_header(std::string const& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Could not open trace " + path);
+    }
+    Header header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, Header{}.magic, sizeof(header.magic)) != 0) {
+        throw std::runtime_error(path + " is not a trace");
+    }
+    if (header.version != VERSION) {
+        throw std::runtime_error(path + " was written by another version");
+    }
+    return header;
+}
+
+std::vector<Trace::Entity> Trace::entities_of(World const& world)
+{
+    std::vector<Entity> entities;
+    entities.reserve(world.vehicles.size() + world.food.size());
+    for (auto const& [id, vehicle] : world.vehicles) {
+        entities.push_back({vehicle_key(id), state_hash(vehicle)});
+    }
+    for (auto const& [id, food] : world.food) {
+        entities.push_back({food_key(id), state_hash(food)});
+    }
+    std::ranges::sort(entities, {}, &Entity::key);
+    return entities;
+}
+
+void trace(World& world, Trace::Header const& header, std::string const& path)
+{
+    Trace out(path, header);
+    out.append(world);
+    for (int i = 0; i < header.ticks && !World::was_interrupted; i++) {
+        world.tick();
+        out.append(world);
+    }
+}
+
+std::optional<std::string> check_trace(World& world, std::string const& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Could not open trace " + path);
+    }
+    in.seekg(sizeof(Trace::Header));
+
+    Trace::Tick                tick;
+    std::vector<Trace::Entity> expected;
+    while (in.read(reinterpret_cast<char*>(&tick), sizeof(tick))) {
+        expected.resize(tick.entity_count);
+        in.read(reinterpret_cast<char*>(expected.data()),
+                static_cast<std::streamsize>(expected.size() *
+                                             sizeof(Trace::Entity)));
+        if (!in) {
+            break;  // cut short; everything before it matched
+        }
+
+        while (world.tick_counter < tick.tick && !World::was_interrupted) {
+            world.tick();
+        }
+        if (World::was_interrupted) {
+            break;
+        }
+        if (world.tick_counter != tick.tick) {
+            throw std::runtime_error(path + " does not start at tick " +
+                                     std::to_string(world.tick_counter));
+        }
+        if (state_hash(world) != tick.hash) {
+            return "Tick " + std::to_string(tick.tick) + ": " +
+                   first_difference(world, expected,
+                                    Trace::entities_of(world));
+        }
+    }
+    return std::nullopt;
+}
+
+}  // namespace tom
@@ -1,8 +1,12 @@
 #include "ui/controls.h"
 
 #include <FL/fl_ask.H>
+#include <algorithm>
+#include <exception>
 #include <string>
 #include <utility>
+#include "history.h"
+#include "snapshot.h"
 #include "ui/fltkrenderer.h"
 #include "ui/qtbuttonbase.h"
 #include "ui/qttogglebutton.h"
@@ -24,7 +28,66 @@ void QtSeparator::draw()
     fl_rectf(Fl_Box::x(), Fl_Box::y(), Fl_Box::w(), Fl_Box::h());
 }
 
-bool ControlWindow::show_info = false;
+QtScrubber::QtScrubber(World* world, int w)
+    : QtBase(25),
+      Fl_Hor_Value_Slider(QtBase::x, QtBase::y, w, QtBase::h, "Rewind"),
+      world(world)
+{
+    precision(0);
+    align(FL_ALIGN_BOTTOM);
+    // the world is only rewound when the mouse lets go, so no keyboard
+    clear_visible_focus();
+    callback([](Fl_Widget* scrubber, void*) {
+        static_cast<QtScrubber*>(scrubber)->show_past();
+    });
+    QtBase::y += QtBase::h + 30;
+}
+
+int QtScrubber::handle(int event)
+{
+    if (event == FL_PUSH) {
+        if (world->history == nullptr) {
+            fl_alert("Nothing to rewind to: there is no history while "
+                     "recording or with --history-mb 0");
+            return 1;
+        }
+        World::pause();
+        window()->redraw();
+        bounds(world->history->first_tick(), world->history->last_tick());
+        value(world->tick_counter);
+    }
+    int const handled = Fl_Hor_Value_Slider::handle(event);
+    if (event == FL_RELEASE && ControlWindow::past_tick >= 0) {
+        go_back();
+    }
+    return handled;
+}
+
+void QtScrubber::show_past()
+{
+    if (world->history == nullptr) {
+        return;
+    }
+    ControlWindow::past_tick = static_cast<int>(value());
+    ControlWindow::past      = world->history->view(ControlWindow::past_tick);
+    FLTKRenderer::window->redraw();
+}
+
+void QtScrubber::go_back()
+{
+    try {
+        world->history->rewind(*world, ControlWindow::past_tick);
+    } catch (std::exception& e) {
+        fl_alert("%s", e.what());
+    }
+    ControlWindow::past_tick = -1;
+    ControlWindow::past.clear();
+    FLTKRenderer::window->redraw();
+}
+
+bool                         ControlWindow::show_info = false;
+int                          ControlWindow::past_tick = -1;
+std::vector<History::Sprite> ControlWindow::past;
 
 ControlWindow::ControlWindow(World* world, int start_x, int W, int H)
     : Fl_Window(start_x, 0, W, std::max(H, 750), "Control Window"), world(world)
@@ -68,10 +131,12 @@ ControlWindow::ControlWindow(World* world, int start_x, int W, int H)
                       return 1;  // Indicate handled
                   });
 
+    create_scrubber(button_width);
+
     create_separator(button_width);
 
     create_button(button_width, "Change target TPS", FL_BLACK, FL_BLACK,
-                  [this](int) {
+                  [this, world](int) {
                       auto s = fl_input("Enter target TPS");
                       if (s == nullptr) {
                           return 0;
@@ -80,7 +145,8 @@ ControlWindow::ControlWindow(World* world, int start_x, int W, int H)
                       if (count < 10 || count > 1000) {
                           return 0;
                       }
-                      World::target_tps = count;
+                      world->issue({.kind  = Command::Kind::SET_TARGET_TPS,
+                                    .value = static_cast<double>(count)});
                       redraw();
                       return 1;
                   });
@@ -98,7 +164,7 @@ ControlWindow::ControlWindow(World* world, int start_x, int W, int H)
         button_width, "Toggle Night Occurance", FL_BLACK,
         QtButtonBase::default_on_color,
         [this, world](int) {
-            world->disable_night = !world->disable_night;
+            world->issue({.kind = Command::Kind::TOGGLE_NIGHT});
             redraw();
             return 1;
         },
@@ -108,7 +174,7 @@ ControlWindow::ControlWindow(World* world, int start_x, int W, int H)
 
     create_button(button_width, "Clear Vehicle Selection", FL_BLACK, FL_GRAY,
                   [world](int) {
-                      world->clear_verbose_vehicles();
+                      world->issue({.kind = Command::Kind::CLEAR_SELECTION});
 
                       return 1;  // Indicate handled
                   });
@@ -146,9 +212,8 @@ ControlWindow::ControlWindow(World* world, int start_x, int W, int H)
                           return 0;
                       }
                       int count = std::stol(s);
-                      for (int i = 0; i < count; i++) {
-                          world->create_vehicle(world->rand_pos_in_bounds());
-                      }
+                      world->issue({.kind  = Command::Kind::ADD_VEHICLES,
+                                    .value = static_cast<double>(count)});
                       return 1;  // Indicate handled
                   });
 
@@ -159,9 +224,8 @@ ControlWindow::ControlWindow(World* world, int start_x, int W, int H)
                           return 0;
                       }
                       int count = std::stol(s);
-                      for (int i = 0; i < count; i++) {
-                          world->new_random_food();
-                      }
+                      world->issue({.kind  = Command::Kind::ADD_FOOD,
+                                    .value = static_cast<double>(count)});
                       return 1;  // Indicate handled
                   });
 
@@ -234,7 +298,8 @@ ControlWindow::ControlWindow(World* world, int start_x, int W, int H)
                     if (pct < 0.0 || pct > 100.0) {
                         throw std::out_of_range("Out of range");
                     }
-                    world->food_pct_chance = pct;
+                    world->issue({.kind  = Command::Kind::SET_FOOD_CHANCE,
+                                  .value = pct});
                     return 1;
                 } catch (std::exception&) {
                     fl_alert(
@@ -249,8 +314,9 @@ ControlWindow::ControlWindow(World* world, int start_x, int W, int H)
             auto s = fl_input("Enter new maximum food amount");
             if (s) {
                 try {
-                    auto count      = std::stoul(s);
-                    world->max_food = count;
+                    auto count = std::stoul(s);
+                    world->issue({.kind  = Command::Kind::SET_MAX_FOOD,
+                                  .value = static_cast<double>(count)});
                     return 1;
                 } catch (std::exception&) {
                     fl_alert("Invalid input. Must be a positive number");
@@ -261,12 +327,28 @@ ControlWindow::ControlWindow(World* world, int start_x, int W, int H)
 
     create_separator(button_width);
 
+    create_button(
+        button_width, "Save Snapshot", FL_BLACK, FL_BLACK, [world](int) {
+            auto s = fl_input("Enter the file to write the snapshot to");
+            if (s) {
+                try {
+                    Snapshot::save(*world, s);
+                    return 1;
+                } catch (std::exception& e) {
+                    fl_alert("%s", e.what());
+                }
+            }
+            return 0;
+        });
+
     create_button(button_width, "End Simulation",
                   QtButtonBase::default_warning_color, FL_GRAY, [](int) {
                       World::stop_running(0);
                       render::FLTKRenderer::teardown();
                       return 1;  // Indicate handled
                   });
+    // as tall as it needs to be for everything above
+    size(W, std::max(h(), QtBase::y));
     end();
 }
 
@@ -297,4 +379,9 @@ void ControlWindow::create_separator(int button_width)
     buttons.push_back(std::make_unique<QtSeparator>(button_width));
 }
 
+void ControlWindow::create_scrubber(int button_width)
+{
+    buttons.push_back(std::make_unique<QtScrubber>(world, button_width));
+}
+
 }  // namespace tom::render
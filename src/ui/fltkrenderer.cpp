@@ -2,8 +2,13 @@
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
+#include <numbers>
 #include <ranges>
 #include <sstream>
+#include <string>
+#include <utility>
+#include "history.h"
 #include "ui/controls.h"
 // #include "ui/qtbuttonbase.h"
 #include "utils.h"
@@ -127,7 +132,11 @@ void FLTKCustomDrawer::draw()
     }
     fl_rectf(x(), y(), w(), h());
 
-    draw_living_world();
+    if (ControlWindow::past_tick >= 0) {
+        draw_past_world();
+    } else {
+        draw_living_world();
+    }
 
     auto ss  = world->info_stream("\n");
     auto msg = ss.str();
@@ -166,20 +175,7 @@ void FLTKCustomDrawer::draw_vehicle(Vehicle const& vehicle)
     double heading = vehicle.get_velocity().heading();
     int    size = remap(vehicle.get_health().remaining(), 0.0, 20.0, 4.0, 10.0);
 
-    // Calculate triangle vertices
-    int x1 = static_cast<int>(pos.x + cos(heading) * size);
-    int y1 = static_cast<int>(pos.y + sin(heading) * size);
-    int x2 = static_cast<int>(pos.x + cos(heading + 2.5) * size);
-    int y2 = static_cast<int>(pos.y + sin(heading + 2.5) * size);
-    int x3 = static_cast<int>(pos.x + cos(heading - 2.5) * size);
-    int y3 = static_cast<int>(pos.y + sin(heading - 2.5) * size);
-
-    // Draw the triangle
-    fl_begin_polygon();
-    fl_vertex(x1, y1);
-    fl_vertex(x2, y2);
-    fl_vertex(x3, y3);
-    fl_end_polygon();
+    draw_triangle(pos, heading, size);
 
     auto rad = vehicle.get_dna().perception_radius;
     // Draw an empty circle with a thin line to represent perception radius
@@ -206,6 +202,26 @@ void FLTKCustomDrawer::draw_vehicle(Vehicle const& vehicle)
     }
 }
 
+void FLTKCustomDrawer::draw_triangle(Vec2D const& pos,
+                                     double       heading,
+                                     int          size)
+{
+    // Calculate triangle vertices
+    int x1 = static_cast<int>(pos.x + cos(heading) * size);
+    int y1 = static_cast<int>(pos.y + sin(heading) * size);
+    int x2 = static_cast<int>(pos.x + cos(heading + 2.5) * size);
+    int y2 = static_cast<int>(pos.y + sin(heading + 2.5) * size);
+    int x3 = static_cast<int>(pos.x + cos(heading - 2.5) * size);
+    int y3 = static_cast<int>(pos.y + sin(heading - 2.5) * size);
+
+    // Draw the triangle
+    fl_begin_polygon();
+    fl_vertex(x1, y1);
+    fl_vertex(x2, y2);
+    fl_vertex(x3, y3);
+    fl_end_polygon();
+}
+
 void FLTKCustomDrawer::draw_food(Food const& food_item)
 {
     auto s = remap(food_item.dna.nutrition, 1.0, 50.0, 5.0, 15.0);
@@ -225,6 +241,40 @@ void FLTKCustomDrawer::draw_living_world()
     }
 }
 
+void FLTKCustomDrawer::draw_past_world()
+{
+    using State = Vehicle::BehaviorState;
+
+    auto const& history = *world->history;
+    for (auto const& sprite : ControlWindow::past) {
+        auto const pos = history.position_of(sprite);
+        if (!sprite.vehicle) {
+            fl_rectf(static_cast<int>(pos.x), static_cast<int>(pos.y),
+                     sprite.size, sprite.size,
+                     sprite.look ? FL_RED : FL_GREEN);
+            continue;
+        }
+        // the colors of draw_vehicle, strongest feeling last
+        fl_color(FL_BLACK);
+        for (auto [state, color] : {std::pair{State::WANDERING, FL_GREEN},
+                                    std::pair{State::HUNGRY, FL_BLUE},
+                                    std::pair{State::OUTGOING, FL_RED},
+                                    std::pair{State::DESPERATE, FL_MAGENTA}}) {
+            if (sprite.look & static_cast<std::uint8_t>(state)) {
+                fl_color(color);
+            }
+        }
+        draw_triangle(pos, sprite.heading * std::numbers::pi / 128,
+                      sprite.size);
+    }
+
+    auto const caption = "Tick " + std::to_string(ControlWindow::past_tick) +
+                         ", let go to continue from here";
+    fl_color(FL_BLACK);
+    fl_font(FL_HELVETICA_BOLD, 14);
+    fl_draw(caption.c_str(), 10, h() - 10);
+}
+
 void FLTKCustomDrawer::draw_dead_world()
 {
     fl_color(FL_RED);
@@ -246,23 +296,23 @@ int FLTKCustomDrawer::handle(int i)
         double x = Fl::event_x();
         double y = Fl::event_y();
         if (World::interact_mode.contains(World::InteractMode::KILL)) {
-            for (auto& [id, vehicle] : world->vehicles) {
-                if (vehicle.get_position().distance_to(Vec2D{x, y}) <
-                    World::kill_radius) {
-                    vehicle.kill();
-                }
-            }
+            world->issue({.kind  = Command::Kind::KILL,
+                          .x     = x,
+                          .y     = y,
+                          .value = static_cast<double>(World::kill_radius)});
             return 1;
         }
         if (World::interact_mode.contains(World::InteractMode::FEED)) {
-            for (int idx = 0; idx < world->feed_count; idx++) {
-                world->new_food(Vec2D{x, y} + Vec2D::random(5), 5.0 / 0.05);
-            }
+            world->issue({.kind  = Command::Kind::FEED,
+                          .x     = x,
+                          .y     = y,
+                          .value = static_cast<double>(world->feed_count)});
             return 1;
         }
         for (auto& vehicle : world->vehicles | std::views::values) {
-            if (vehicle.get_position().distance_to(Vec2D{x, y}) < 30) {
-                vehicle.verbose = !vehicle.verbose;
+            if (vehicle.get_position().distance_to(Vec2D{x, y}) <
+                World::select_radius) {
+                world->issue({.kind = Command::Kind::SELECT, .x = x, .y = y});
                 return 1;
             }
         }
@@ -46,66 +46,36 @@ std::ostream& operator<<(std::ostream& os, ANSICode const& c)
 
 }  // namespace ansi
 
-void clear_screen()
-{
-    std::cout << "\033[2J\033[1;1H";
-}
-
-#ifdef FAST_RANDOM
 bool random_bool() noexcept
 {
-    return (rand() & 1) == 0;
+    return (RandomStream::current().next_u32() & 1) == 0;
 }
 
 double random_delta(double scale) noexcept
 {
-    return ((random_in_range(0, 200) / 100.0) - 1.0) * scale;
+    return RandomStream::current().uniform(-scale, scale);
 }
 
 double random_in_range(double min, double max) noexcept
 {
-    return min + (rand() / (RAND_MAX / (max - min)));
+    return RandomStream::current().uniform(min, max);
 }
 
-using twice_int = typename std::conditional<
-    sizeof(long) == 2 * sizeof(int),
-    long,
-    std::conditional<sizeof(long long) == 2 * sizeof(int), long long, void>>::
-    type;
-
 int random_int(int min, int max) noexcept
 {
-    return ((twice_int(rand()) * twice_int(max)) >> 31) + min;
+    // inclusive of max, like std::uniform_int_distribution
+    auto const span = static_cast<std::uint32_t>(max - min) + 1;
+    return min + static_cast<int>(RandomStream::current().below(span));
 }
-#else
 
-#include <random>
-
-bool random_bool() noexcept
+std::uint32_t random_bits() noexcept
 {
-    std::uniform_int_distribution<> dis(0, 1);
-    return dis(gen) == 1;
+    return RandomStream::current().next_u32();
 }
 
-double random_delta(double scale) noexcept
+void random_fill(std::span<double> out) noexcept
 {
-    // return ((rand() % 200) / 100.0 - 1.0) * scale;  // small random change
-    std::uniform_real_distribution<> dis(-scale, scale);
-    return dis(gen);
+    RandomStream::current().fill_uniform(out);
 }
 
-double random_in_range(double min, double max) noexcept
-{
-    // return min + (rand() / (RAND_MAX / (max - min)));
-    std::uniform_real_distribution<> dis(min, max);
-    return dis(gen);
-}
-
-int random_int(int min, int max) noexcept
-{
-    std::uniform_int_distribution<> dis(min, max);
-    return dis(gen);
-}
-#endif
-
 }  // namespace tom
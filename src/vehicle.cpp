@@ -1,14 +1,18 @@
 
 #include "vehicle.h"
 
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <ostream>
+#include <span>
 #include <sstream>
+#include <vector>
 
 #include "checks.h"
 #include "food.h"
 #include "lifespan.h"
+#include "log.h"
 #include "optionset.h"
 #include "utils.h"
 #include "vec2d.h"
@@ -16,8 +20,9 @@
 
 namespace tom {
 
-static int edge_kill_count      = 0;
-static int last_tick_edge_death = 0;
+// atomic because vehicles of different tiles update concurrently
+static std::atomic<int> edge_kill_count      = 0;
+static std::atomic<int> last_tick_edge_death = 0;
 
 template <typename T, T amount>
 static Lifespan<T, amount> min(Lifespan<T, amount> const& lifespan, T d)
@@ -37,17 +42,17 @@ static Lifespan<T, amount> max(Lifespan<T, amount> const& lifespan, T d)
     return lifespan;
 }
 
-int const    Vehicle::WANDER_DISTANCE = 50;
-double const Vehicle::MAX_FORCE       = 0.45;
-double const Vehicle::MAX_HEALTH      = 45.0;
+int const Vehicle::WANDER_DISTANCE = 50;
+double    Vehicle::MAX_FORCE       = 0.45;
+double    Vehicle::MAX_HEALTH      = 45.0;
 
 Vehicle::Vehicle(Vec2D const& position)
-    : position(position),
-      velocity(random_in_range(0, dna.max_speed),
-               random_in_range(0, dna.max_speed)),
-      id(global_id_counter++)
+    : position(position), id(global_id_counter++)
 {
-    if (auto const changer = random_int(1, 3) % 3; changer == 0) {
+    auto const u = random_uniforms<3>();
+    velocity     = Vec2D{uniform_to_range(u[0], 0, dna.max_speed),
+                     uniform_to_range(u[1], 0, dna.max_speed)};
+    if (auto const changer = uniform_to_int(u[2], 1, 3) % 3; changer == 0) {
         // flip x-velocity
         velocity.x *= -1;
     } else if (changer == 1) {
@@ -67,6 +72,10 @@ Vehicle::Vehicle() : Vehicle(Vec2D{0.0, 0.0})
     // output("Default constructor called. Vehicle id is ", id, "\n");
 }
 
+Vehicle::Vehicle(RestoreTag) noexcept : dna(restore_tag), id(0)
+{
+}
+
 [[nodiscard]]
 Vehicle::LifespanType Vehicle::get_health() const
 {
@@ -243,8 +252,7 @@ void Vehicle::update()
           << " will_seek_vehicle()=" << will_seek_vehicle() << " age " << age
           << " is_hungry()=" << is_hungry()
           << " BehaviorState=" << behavior_state;
-        auto msg = s.str();
-        tom::output(msg, std::string(msg.size(), '\b'), "\033[0K");
+        log_message(LogLevel::STATUS, s.str());
     }
     GUARD(health != 0);
 
@@ -255,7 +263,8 @@ void Vehicle::update()
         world->delay(
             [position = this->position, age = this->age](World* world) {
                 world->new_food(position, age / 100.0 + 1.0);
-            });
+            },
+            "decay");
         return;
     }
 
@@ -274,20 +283,18 @@ void Vehicle::update()
         return;
     }
 
-    DEBUG_USE(auto s = tom::ansi::erase_to_eol.stringify(
-                  "Killed ", edge_kill_count, " by edges. Last death ",
-                  world->tick_counter - last_tick_edge_death, "\r"));
-    debug_output(s);
+    DEBUG_USE(log_message(LogLevel::STATUS, "Killed ",
+                          edge_kill_count.load(), " by edges. Last death ",
+                          world->tick_counter - last_tick_edge_death.load()));
 
     // Reset acceleration after each update
     acceleration.reset();
 
     avoid_edges();
 
-    // Update world's max age if necessary
-    using std::max, std::min;
-    world->max_age = max(world->max_age, age);
-    health         = min(health, MAX_HEALTH);
+    // the world keeps track of the oldest vehicle after updating them
+    using std::min;
+    health = min(health, MAX_HEALTH);
 }
 
 void Vehicle::kill()
@@ -295,6 +302,15 @@ void Vehicle::kill()
     health.expire();
 }
 
+void Vehicle::change_health(double ticks)
+{
+    if (ticks < 0) {
+        health -= -ticks;
+    } else {
+        health += ticks;
+    }
+}
+
 void Vehicle::avoid_edges()
 {
 #ifdef NEW_EDGE_AVOIDANCE
@@ -385,6 +401,18 @@ void Vehicle::determine_behavior()
 void Vehicle::behaviors(
     std::unordered_map<World::VehicleIdType, Vehicle>& vehicles,
     std::unordered_map<World::FoodIdType, Food>&       food_positions)
+{
+    behaviors_among(vehicles, food_positions);
+}
+
+void Vehicle::behaviors(World::VehicleRefs& vehicles,
+                        World::FoodRefs&    food_positions)
+{
+    behaviors_among(vehicles, food_positions);
+}
+
+template <class VehicleRange, class FoodRange>
+void Vehicle::behaviors_among(VehicleRange& vehicles, FoodRange& food_positions)
 {
     check_sought_food();
     check_sought_vehicle();
@@ -439,7 +467,9 @@ void Vehicle::seek_for_eat(Food* target, double record)
     if (can_touch(record)) {
         // Already at target; captured food
         // health += 50.0;  // Increase health on reaching target
-        target->consume(*this);
+        world->interact({.kind    = World::Interaction::Kind::CONSUME,
+                         .vehicle = this,
+                         .food    = target});
     } else if (can_see(record)) {
         Vec2D steer = seek(target->position);
         apply_force(steer);
@@ -450,8 +480,12 @@ void Vehicle::flee_poison(Food* target, double record)
 {
     if (can_see(record)) {
         if (random_in_range(0, 1) < dna.altruism_probability) {
-            target->expire();  // altruistically remove poison food
-            health--;          // slight health cost to self
+            // altruistically remove poison food
+            world->interact({.kind = World::Interaction::Kind::EXPIRE,
+                             .food = target});
+            // slight health cost to self
+            world->interact({.kind    = World::Interaction::Kind::DRAIN,
+                             .vehicle = this});
             return;
         }
         Vec2D steer = flee(target->position);
@@ -464,8 +498,12 @@ void Vehicle::seek_for_malice(Vehicle* target, double record)
     if (random_in_range(0, 1) < dna.malice_probability) {
         // ATTACK!
         if (can_touch(record)) {
-            target->health -= dna.malice_damage;
-            this->health += dna.malice_damage;
+            world->interact({.kind    = World::Interaction::Kind::HEALTH,
+                             .vehicle = target,
+                             .amount  = -dna.malice_damage});
+            world->interact({.kind    = World::Interaction::Kind::HEALTH,
+                             .vehicle = this,
+                             .amount  = dna.malice_damage});
         } else if (can_see(record)) {
             // if vehicle is far away, try to seek it
             Vec2D steer = seek(target->position);
@@ -484,9 +522,13 @@ void Vehicle::seek_for_altruism(Vehicle* target, double record)
     if (random_in_range(0, 1) < dna.altruism_probability) {
         if (can_touch(record)) {
             if (random_in_range(0, 1) < dna.altruism_probability) {
-                target->health += dna.altruism_heal;
+                world->interact({.kind    = World::Interaction::Kind::HEALTH,
+                                 .vehicle = target,
+                                 .amount  = dna.altruism_heal});
                 // Slight cost to self
-                this->health -= (dna.altruism_heal * 1.1);
+                world->interact({.kind    = World::Interaction::Kind::HEALTH,
+                                 .vehicle = this,
+                                 .amount  = -(dna.altruism_heal * 1.1)});
             }
         } else if (can_see(record)) {
             Vec2D steer = seek(target->position);
@@ -510,12 +552,16 @@ void Vehicle::seek_for_reproduction(Vehicle* target, double record)
     }
     if (can_touch(record)) {
         // Reproduce
-        health -= dna.reproduction_cost;
+        world->interact({.kind    = World::Interaction::Kind::HEALTH,
+                         .vehicle = this,
+                         .amount  = -dna.reproduction_cost});
         time_since_last_reproduction = 0;
-        world->delay([this, mom = this, dad = target](auto*) {
-            GUARD(mom != nullptr && dad != nullptr);
-            this->perform_reproduction(*mom, *dad);
-        });
+        world->delay(
+            [this, mom = this, dad = target](auto*) {
+                GUARD(mom != nullptr && dad != nullptr);
+                this->perform_reproduction(*mom, *dad);
+            },
+            "reproduction");
     } else {
         auto steer = seek(target->position);
         apply_force(steer);
@@ -546,7 +592,8 @@ Food& Vehicle::last_sought_food(double& record) const
     return f;
 }
 
-void Vehicle::food_behaviors(Foods& food_positions)
+template <class FoodRange>
+void Vehicle::food_behaviors(FoodRange& food_positions)
 {
     // WARN: Must call check_sought_food first!
     double record      = std::numeric_limits<double>::max();
@@ -607,7 +654,8 @@ void Vehicle::check_sought_food()
     }
 }
 
-void Vehicle::vehicle_behaviors(Vehicles& vehicles)
+template <class VehicleRange>
+void Vehicle::vehicle_behaviors(VehicleRange& vehicles)
 {
     double record = -1.0;  // if we are pursing the same vehicle, assume we are
                            // close enough due to prior knowledge
@@ -625,7 +673,8 @@ void Vehicle::vehicle_behaviors(Vehicles& vehicles)
     last_sought_vehicle_id = target_vehicle->id;
 
     if (verbose) {
-        target_vehicle->highlighted = true;
+        world->interact({.kind    = World::Interaction::Kind::HIGHLIGHT,
+                         .vehicle = target_vehicle});
     }
 
     if (target_vehicle->health < 5.0) {
@@ -642,9 +691,11 @@ void Vehicle::vehicle_behaviors(Vehicles& vehicles)
 
 void Vehicle::try_explosion()
 {
-    if (random_in_range(0, 1) < dna.explosion_chance) {
-        kill();
-        world->delay([this](auto* world) { this->perform_explosion(world); });
+    if (explosion_countdown.trial(dna.explosion_chance)) {
+        world->interact(
+            {.kind = World::Interaction::Kind::KILL, .vehicle = this});
+        world->delay([this](auto* world) { this->perform_explosion(world); },
+                     "explosion");
     }
 }
 
@@ -669,6 +720,9 @@ void Vehicle::perform_reproduction(Vehicle const& mom, Vehicle const& dad) const
         Vehicle::next_id(), mom.world, child_pos, Vec2D::random(2.0), child_dna,
         std::max(mom.generation, dad.generation) + 1,
         midpoint(mom.health, dad.health).remaining() * 1.2, false);
+    if (world->on_birth) {
+        world->on_birth(offspring);
+    }
     world->born_counter++;
     world->add_vehicle(std::move(offspring));
 }
@@ -685,17 +739,25 @@ void Vehicle::perform_explosion(World* world) const
         }
     }
     std::vector children{count, Vehicle(start_pos)};
+    // the whole litter draws its mutations in one go
+    std::vector<double> uniforms(count * DNA::MUTATION_DRAWS);
+    random_fill(uniforms);
     for (unsigned long i = 0; i < count; i++) {
         Vehicle& offspring = children[i];
         offspring.position += Vec2D::random(dna.perception_radius / 2.0);
         DNA child_dna = this->dna;
-        child_dna.mutate();
+        child_dna.mutate(std::span<double const>(uniforms)
+                             .subspan(i * DNA::MUTATION_DRAWS)
+                             .first<DNA::MUTATION_DRAWS>());
         // reduce the likelihood of chained explosions
         child_dna.explosion_chance /= 2;
         offspring.populate_in_place(Vehicle::next_id(), this->world, start_pos,
                                     Vec2D::random(2.0), child_dna,
                                     this->generation + 1,
                                     max(this->health, 2.0), this->verbose);
+        if (world->on_birth) {
+            world->on_birth(offspring);
+        }
         world->born_counter++;
     }
     world->add_all_vehicles(std::move(children));
@@ -0,0 +1,257 @@
+#include "vehicles_c.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "engine.h"
+#include "food.h"
+#include "vehicle.h"
+#include "world.h"
+
+namespace {
+
+// an export laid out as the caller wants it, by the first call after a
+// step, so that every further call until the next step is a single memcpy
+template <typename T>
+struct Export {
+    std::vector<T> values;
+    bool           stale = true;
+};
+
+}  // namespace
+
+struct vw_world {
+    tom::Engine               engine;
+    mutable Export<float>     positions;
+    mutable Export<float>     food_positions;
+    mutable Export<vw_traits> traits;
+};
+
+namespace {
+
+thread_local std::string last_error;
+
+// run f, turning anything it throws into `failed` and a message
+template <typename F, typename R>
+R guarded(R failed, F&& f) noexcept
+{
+    try {
+        last_error.clear();
+        return f();
+    } catch (std::exception const& e) {
+        last_error = e.what();
+    } catch (...) {
+        last_error = "unknown error";
+    }
+    return failed;
+}
+
+constexpr float narrow(double value) noexcept
+{
+    return static_cast<float>(value);
+}
+
+vw_traits traits_of(std::uint64_t id, tom::Vehicle const& vehicle) noexcept
+{
+    auto const& dna = vehicle.get_dna();
+    return {
+        .id                = id,
+        .health            = narrow(vehicle.get_health().remaining()),
+        .age               = vehicle.get_age(),
+        .generation        = vehicle.get_generation(),
+        .perception_radius = narrow(dna.perception_radius),
+        .max_speed         = narrow(dna.max_speed),
+        .mutation_rate     = narrow(dna.mutation_rate),
+        .reproduction_cost = narrow(dna.reproduction_cost),
+        .malice_desire     = narrow(dna.malice_desire),
+        .altruism_desire   = narrow(dna.altruism_desire),
+        .explosion_chance  = narrow(dna.explosion_chance),
+        .edge_repulsion    = narrow(dna.edge_repulsion),
+    };
+}
+
+template <typename World>
+World& checked(World* world)
+{
+    if (world == nullptr) {
+        throw std::invalid_argument("No world");
+    }
+    return *world;
+}
+
+// per values in out make one entity, which write appends to the layout;
+// returns how many entities there are
+template <typename T, typename Map, typename Write>
+std::size_t export_from(Export<T>&  cache,
+                        Map const&  entities,
+                        std::size_t per,
+                        T*          out,
+                        std::size_t cap,
+                        Write&&     write)
+{
+    if (out == nullptr || cap == 0) {
+        return entities.size();
+    }
+    if (cache.stale) {
+        cache.values.clear();
+        cache.values.reserve(per * entities.size());
+        for (auto const& [id, entity] : entities) {
+            write(cache.values, id, entity);
+        }
+        cache.stale = false;
+    }
+    std::memcpy(out, cache.values.data(),
+                std::min(cap, entities.size()) * per * sizeof(T));
+    return entities.size();
+}
+
+vw_world* created(tom::Engine engine)
+{
+    return new vw_world{std::move(engine), {}, {}, {}};
+}
+
+}  // namespace
+
+extern "C" {
+
+vw_config vw_default_config(void)
+{
+    tom::Engine::Config const defaults;
+    return {
+        .seed            = defaults.seed,
+        .width           = defaults.width,
+        .height          = defaults.height,
+        .vehicles        = defaults.vehicles,
+        .food            = defaults.food,
+        .max_food        = defaults.max_food,
+        .food_pct_chance = defaults.food_pct_chance,
+        .edge_threshold  = defaults.edge_threshold,
+        .poison_chance   = defaults.poison_chance,
+        .max_force       = defaults.max_force,
+        .max_health      = defaults.max_health,
+        .disable_night   = defaults.disable_night,
+        .workers         = defaults.workers,
+    };
+}
+
+vw_world* vw_create(vw_config const* config)
+{
+    return guarded<>(static_cast<vw_world*>(nullptr), [&] {
+        if (config == nullptr) {
+            throw std::invalid_argument("No config");
+        }
+        return created(tom::Engine({
+            .seed            = config->seed,
+            .width           = config->width,
+            .height          = config->height,
+            .vehicles        = config->vehicles,
+            .food            = config->food,
+            .max_food        = config->max_food,
+            .food_pct_chance = config->food_pct_chance,
+            .edge_threshold  = config->edge_threshold,
+            .poison_chance   = config->poison_chance,
+            .max_force       = config->max_force,
+            .max_health      = config->max_health,
+            .disable_night   = config->disable_night != 0,
+            .workers         = config->workers,
+        }));
+    });
+}
+
+vw_world* vw_load(char const* path, uint32_t workers)
+{
+    return guarded<>(static_cast<vw_world*>(nullptr), [&] {
+        return created(tom::Engine::load(path, workers));
+    });
+}
+
+int vw_save(vw_world* world, char const* path)
+{
+    return guarded<>(-1, [&] {
+        checked(world).engine.save(path);
+        return 0;
+    });
+}
+
+void vw_destroy(vw_world* world)
+{
+    delete world;
+}
+
+int vw_step(vw_world* world, int n)
+{
+    return guarded<>(-1, [&] {
+        auto& stepped = checked(world);
+        stepped.positions.stale      = true;
+        stepped.food_positions.stale = true;
+        stepped.traits.stale         = true;
+        return stepped.engine.step(n);
+    });
+}
+
+vw_stats vw_get_stats(vw_world const* world)
+{
+    return guarded<>(vw_stats{}, [&] {
+        auto const stats = checked(world).engine.stats();
+        return vw_stats{
+            .tick     = stats.tick,
+            .births   = stats.births,
+            .deaths   = stats.deaths,
+            .max_age  = stats.max_age,
+            .vehicles = stats.vehicles,
+            .food     = stats.food,
+            .day      = stats.day,
+        };
+    });
+}
+
+size_t vw_export_positions(vw_world const* world, float* xy, size_t cap)
+{
+    return guarded<>(std::size_t{0}, [&] {
+        auto const& from = checked(world);
+        return export_from(
+            from.positions, from.engine.world().vehicles, 2, xy, cap,
+            [](std::vector<float>& out, auto, tom::Vehicle const& vehicle) {
+                auto const& position = vehicle.get_position();
+                out.push_back(narrow(position.x));
+                out.push_back(narrow(position.y));
+            });
+    });
+}
+
+size_t vw_export_food_positions(vw_world const* world, float* xy, size_t cap)
+{
+    return guarded<>(std::size_t{0}, [&] {
+        auto const& from = checked(world);
+        return export_from(
+            from.food_positions, from.engine.world().food, 2, xy, cap,
+            [](std::vector<float>& out, auto, tom::Food const& food) {
+                out.push_back(narrow(food.position.x));
+                out.push_back(narrow(food.position.y));
+            });
+    });
+}
+
+size_t vw_export_traits(vw_world const* world, vw_traits* out, size_t cap)
+{
+    return guarded<>(std::size_t{0}, [&] {
+        auto const& from = checked(world);
+        return export_from(
+            from.traits, from.engine.world().vehicles, 1, out, cap,
+            [](std::vector<vw_traits>& out, std::uint64_t id,
+               tom::Vehicle const& vehicle) {
+                out.push_back(traits_of(id, vehicle));
+            });
+    });
+}
+
+char const* vw_last_error(void)
+{
+    return last_error.c_str();
+}
+
+}  // extern "C"
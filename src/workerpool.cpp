@@ -0,0 +1,86 @@
+#include "workerpool.h"
+#include "timeline.h"
+
+namespace tom {
+
+WorkerPool::WorkerPool(unsigned count)
+{
+    for (unsigned i = 1; i < count; i++) {
+        threads.emplace_back([this] { work(); });
+    }
+}
+
+void WorkerPool::parallel_for(std::size_t count, Task const& task)
+{
+    if (threads.empty() || count <= 1) {
+        for (std::size_t i = 0; i < count; i++) {
+            task(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard lock(mutex);
+        this->task  = &task;
+        this->count = count;
+        next        = 0;
+        busy        = threads.size();
+        generation++;
+    }
+    wake.notify_all();
+    drain();
+
+    std::unique_lock lock(mutex);
+    done.wait(lock, [this] { return busy == 0; });
+    this->task = nullptr;
+}
+
+unsigned WorkerPool::size() const noexcept
+{
+    return static_cast<unsigned>(threads.size()) + 1;
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+void WorkerPool::work()
+{
+    std::uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock lock(mutex);
+            wake.wait(lock,
+                      [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+        drain();
+        {
+            std::lock_guard lock(mutex);
+            if (--busy == 0) {
+                done.notify_one();
+            }
+        }
+    }
+}
+
+void WorkerPool::drain()
+{
+    Timeline::Span span("worker", "parallel_for");
+    for (auto i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+        (*task)(i);
+    }
+}
+
+}  // namespace tom
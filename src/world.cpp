@@ -1,27 +1,116 @@
 #include "world.h"
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <chrono>
-#include <csignal>
 #include <cstdlib>
-#include <iostream>
+#include <ostream>
 #include <ranges>
 #include <vector>
 
+#include "checkpointer.h"
 #include "food.h"
 #include "fooddna.h"
+#include "history.h"
 #include "irenderer.h"
+#include "log.h"
+#include "metrics.h"
+#include "metricsserver.h"
 #include "optionset.h"
+#include "timeline.h"
 #include "utils.h"
 #include "vec2d.h"
 #include "vehicle.h"
 
 namespace tom {
 
+namespace {
+
+using Phase = Profiler::Phase;
+
+// where each phase of the profiler is summed up in World::PhaseTimes
+constexpr std::array<World::Duration World::PhaseTimes::*, Profiler::PHASES>
+    PHASE_TOTALS{
+        &World::PhaseTimes::events,    // EVENTS
+        &World::PhaseTimes::events,    // TIME_OF_DAY
+        &World::PhaseTimes::prune,     // PRUNE_FOOD
+        &World::PhaseTimes::index,     // INDEX
+        &World::PhaseTimes::food,      // FOOD
+        &World::PhaseTimes::prune,     // PRUNE_VEHICLES
+        &World::PhaseTimes::vehicles,  // VEHICLES
+        nullptr,                       // RENDER is not part of a tick
+    };
+
+// adds the time until the end of its scope to one phase, to the profiler
+// when built with PROFILE_TICKS, to the world's phase_times when set (with
+// the hardware counters it reads) and to the timeline when it records
+class PhaseTimer {
+   public:
+    PhaseTimer(World& world, Phase phase) noexcept
+        : world(world),
+          phase(phase),
+          timeline(Timeline::recording()),
+          timed(Profiler::ENABLED || world.phase_times || timeline)
+    {
+        if constexpr (Profiler::ENABLED) {
+            allocated = AllocationCounts::so_far();
+        }
+        if (counters()) {
+            counted = counters()->read();
+        }
+        if (timed) {
+            start = World::Clock::now();
+        }
+    }
+    PhaseTimer(PhaseTimer const&)            = delete;
+    PhaseTimer& operator=(PhaseTimer const&) = delete;
+    ~PhaseTimer()
+    {
+        if (counters()) {
+            world.phase_times->counted[static_cast<std::size_t>(phase)] +=
+                counters()->read() - counted;
+        }
+        if (!timed) {
+            return;
+        }
+        auto const end     = World::Clock::now();
+        auto const elapsed = end - start;
+        if constexpr (Profiler::ENABLED) {
+            world.profiler.record(phase, elapsed,
+                                  AllocationCounts::so_far() - allocated);
+        }
+        auto const total = PHASE_TOTALS[static_cast<std::size_t>(phase)];
+        if (world.phase_times && total) {
+            world.phase_times->*total += elapsed;
+        }
+        if (timeline) {
+            Timeline::record(total ? "tick" : "render",
+                             Profiler::name(phase).data(), start, end);
+        }
+    }
+
+   private:
+    PerfCounters const* counters() const noexcept
+    {
+        return world.phase_times ? world.phase_times->counters : nullptr;
+    }
+
+    World&               world;
+    Phase                phase;
+    bool                 timeline;
+    bool                 timed;
+    World::TimePoint     start;
+    AllocationCounts     allocated;  // before the phase began
+    PerfCounters::Values counted;    // likewise
+};
+
+}  // namespace
+
 bool                                    World::game_running    = true;
 bool                                    World::is_paused       = false;
 int                                     World::kill_radius     = 100;
 double                                  World::edge_threshold  = 25.0;
+double                                  World::poison_chance   = 0.1;
 bool                                    World::was_interrupted = false;
 bool                                    World::unlimited_tps   = false;
 std::pair<World::VehicleIdType, double> World::max_fitness     = {0, 0.0};
@@ -32,12 +121,11 @@ OptionSet<World::ViewMode> World::view_mode = OptionSet(World::ViewMode::PLAIN);
 OptionSet<World::InteractMode> World::interact_mode =
     OptionSet(World::InteractMode::NONE);
 
-#define POISON_CHANCE 0.1
+thread_local World::TileContext* World::current_tile = nullptr;
 
 World::World(long seed, int width, int height)
     : seed(seed), width(width), height(height)
 {
-    signal(SIGINT, stop_running);
 }
 
 World::Duration World::one_tick_time()
@@ -79,11 +167,18 @@ Vec2D World::rand_pos_in_bounds(double margin) const
 Food const& World::new_random_food()
 {
     // see Food class for information on how nutrition works
-    return new_food(random_in_range(0, 1) < POISON_CHANCE
+    return new_food(random_in_range(0, 1) < poison_chance
                         ? -2.0
                         : random_in_range(0.05, 0.2));
 }
 
+Food const& World::new_random_food(Vec2D const& position)
+{
+    return new_food(position, random_in_range(0, 1) < poison_chance
+                                  ? -2.0
+                                  : random_in_range(0.05, 0.2));
+}
+
 Food& World::new_food(Vec2D food_position, double nutrition)
 {
     auto  id        = Environmental::next_id();
@@ -101,9 +196,9 @@ Food const& World::new_food(double nutrition)
     return new_food(food_position, nutrition);
 }
 
-bool World::should_spawn_food() const noexcept
+bool World::should_spawn_food(Countdown& countdown) const noexcept
 {
-    return (random_in_range(0, 1) < (food_pct_chance / 100.0 / target_tps) &&
+    return (countdown.trial(food_pct_chance / 100.0 / target_tps) &&
             food.size() < max_food);
 }
 
@@ -112,14 +207,21 @@ auto World::prune_dead_vehicles() -> typename decltype(vehicles)::size_type
     auto const initial_size = vehicles.size();
 
     for (auto& [id, v] : vehicles) {
-        if (v.last_sought_vehicle_id != 0 &&
-            vehicles[v.last_sought_vehicle_id].is_dead()) {
+        if (v.last_sought_vehicle_id == 0) {
+            continue;
+        }
+        // the target may already be gone (handed to another shard)
+        if (auto it = vehicles.find(v.last_sought_vehicle_id);
+            it == vehicles.end() || it->second.is_dead()) {
             v.last_sought_vehicle_id = 0;
         }
     }
 
     std::erase_if(vehicles, [this](auto& p) {
-        if (auto& v = p.second; v.is_dead()) {
+        if (auto& v = p.second; v.is_dead() && !v.ghost) {
+            if (on_death) {
+                on_death(v);
+            }
             dead_counter++;
             return true;
         }
@@ -133,7 +235,7 @@ auto World::prune_eaten_food() -> decltype(food)::size_type
     auto initial_size = food.size();
     std::erase_if(food, [](auto const& p) {
         auto const& f = p.second;
-        return f.is_expired();
+        return f.is_expired() && !f.ghost;
     });
     return initial_size - food.size();
 }
@@ -180,7 +282,7 @@ void World::populate_world(int vehicle_count, int food_count)
 
 double World::tps() const
 {
-    return current_tps;
+    return tick_rate.tps(std::chrono::seconds{1});
 }
 
 std::stringstream World::info_stream() const
@@ -202,7 +304,9 @@ std::stringstream World::info_stream(std::string delim) const
 
     ss << "[TIME]     Elapsed: " << elapsed_seconds << "s" << "; "
        << (is_night() ? "Night" : "Day") << delim;
-    ss << "[TICK]     " << tick_counter << "; current TPS: " << tps() << delim;
+    ss << "[TICK]     " << tick_counter << "; ";
+    tick_rate.write(ss);
+    ss << delim;
 
     ss << "[VEHICLES] Current: " << vehicles.size()
        << "; Dead: " << dead_counter << "; Borne: " << born_counter
@@ -217,6 +321,11 @@ std::stringstream World::info_stream(std::string delim) const
         ss << delim << "ALL VEHICLES HAVE PERISHED.";
     }
 
+    if constexpr (Profiler::ENABLED) {
+        profiler.write(ss);
+        ss << delim;
+    }
+
     if (World::is_paused) {
         ss << delim << "PAUSED ";
     }
@@ -229,36 +338,56 @@ std::stringstream World::info_stream(std::string delim) const
     return ss;
 }
 
-long double calc_tps_from_tick_duration(World::TimePoint const tick_start,
-                                        World::TimePoint const tick_end)
-{
-    return 1e6l /
-           std::chrono::duration_cast<
-               std::chrono::microseconds>(  // NOLINT(*-narrowing-conversions)
-               tick_end - tick_start)
-               .count();
-}
-
-void World::run(render::IRenderer& renderer, int target_tps)
+void World::run(render::IRenderer& renderer)
 {
     start_time = Clock::now();
     while (game_running) {
-        auto tick_start = Clock::now();
-        if (!is_paused) {
+        auto       tick_start = Clock::now();
+        bool const ticking    = !is_paused;
+        if (ticking) {
             tick();  // continue running even if all vehicles die
         }
-        renderer.render();
+        if (checkpointer) {
+            checkpointer->between_ticks(*this);
+        }
+        if (history) {
+            history->record(*this);
+        }
+        if (metrics) {
+            try {
+                metrics->record(*this);
+            } catch (std::exception const& e) {
+                log_message(LogLevel::ERROR, e.what());
+                metrics = nullptr;  // rather than fail every tick
+            }
+        }
+        if (metrics_server) {
+            metrics_server->publish(*this);
+        }
+        {
+            PhaseTimer timer(*this, Phase::RENDER);
+            renderer.render();
+        }
         if (was_interrupted) {
             renderer.terminate();
             break;
         }
+        if (Timeline::take_dump_request()) {
+            try {
+                Timeline::dump();
+            } catch (std::exception const& e) {
+                log_message(LogLevel::ERROR, e.what());
+            }
+        }
+        // the sleep is left out of the tick's duration, but not its rate
+        if (ticking) {
+            tick_rate.record(tick_start, Clock::now(),
+                             unlimited_tps ? Duration::zero()
+                                           : one_tick_time());
+        }
         if (!World::unlimited_tps) {
             tps_target_wait(tick_start);
         }
-        if (tick_counter % (target_tps / 2 + 1) == 0) {
-            auto tick_end = Clock::now();
-            current_tps   = calc_tps_from_tick_duration(tick_start, tick_end);
-        }
     }
     renderer.render(true);
     end_time = Clock::now();
@@ -266,8 +395,12 @@ void World::run(render::IRenderer& renderer, int target_tps)
 
 void World::check_time_of_day()
 {
+    // ghosts arrive with the day/night adjustment already applied by their
+    // owner
+    auto is_owned = [](auto const& p) { return !p.second.ghost; };
+
     if (daytime == day_tick_length()) {
-        for (auto& [id, vehicle] : vehicles) {
+        for (auto& [id, vehicle] : vehicles | std::views::filter(is_owned)) {
             // see less at night
             vehicle.dna.max_speed /= 2;
             vehicle.dna.perception_radius /= 2;
@@ -277,7 +410,7 @@ void World::check_time_of_day()
             vehicle.dna.reproduction_cost /= 2;
         }
     } else if (daytime == 0) {
-        for (auto& [id, vehicle] : vehicles) {
+        for (auto& [id, vehicle] : vehicles | std::views::filter(is_owned)) {
             vehicle.dna.max_speed *= 2;
             vehicle.dna.perception_radius *= 2;
             vehicle.dna.malice_desire *= 2;
@@ -290,19 +423,39 @@ void World::check_time_of_day()
 
 bool World::tick()
 {
+    // whatever is not drawn by an entity (food spawning, delayed actions)
+    Timeline::Span      span("tick", "tick");
+    auto                stream = world_stream();
+    RandomStream::Scope world_scope(stream);
+
     // events are adding during ticks to be processed at the next tick, but
     // they should be thought about as belonging to the world of the prior tick
     // so they must be processed before the tick starts
-    process_events();
-    check_time_of_day();
-
-    /* food is pruned then the tick occurs. once food is pruned, events
-     * are then added, when the tick loop repeats, the events are then
-     * processed before the next pruning to prevent iterator invalidation */
-    food_tick(food, vehicles);
+    {
+        PhaseTimer timer(*this, Phase::EVENTS);
+        process_events();
+    }
+    {
+        PhaseTimer timer(*this, Phase::TIME_OF_DAY);
+        check_time_of_day();
+    }
 
-    /* vehicle pruning occurs like food pruning, see above */
-    vehicle_tick(vehicles, food);
+    if (workers) {
+        tiled_food_tick();
+        tiled_vehicle_tick();
+    } else {
+        /* food is pruned then the tick occurs. once food is pruned, events
+         * are then added, when the tick loop repeats, the events are then
+         * processed before the next pruning to prevent iterator invalidation
+         */
+        food_tick(food, vehicles);
+
+        /* vehicle pruning occurs like food pruning, see above */
+        vehicle_tick(vehicles, food);
+    }
+    if (phase_times) {
+        phase_times->ticks++;
+    }
     tick_counter++;
     ++daytime;
     return !vehicles.empty();
@@ -326,9 +479,18 @@ World::~World() = default;
 
 void World::food_tick(Foods& food, Vehicles& vehicles)
 {
-    prune_eaten_food();
+    {
+        PhaseTimer timer(*this, Phase::PRUNE_FOOD);
+        prune_eaten_food();
+    }
 
+    PhaseTimer timer(*this, Phase::FOOD);
     for (auto& [id, food] : food) {
+        if (food.ghost) {
+            continue;
+        }
+        auto                stream = food_stream(id);
+        RandomStream::Scope scope(stream);
         food.behaviors(vehicles);
         food.update();
     }
@@ -336,12 +498,32 @@ void World::food_tick(Foods& food, Vehicles& vehicles)
 
 void World::vehicle_tick(Vehicles& neighbors, Foods& food_neighbors)
 {
-    prune_dead_vehicles();
+    {
+        PhaseTimer timer(*this, Phase::PRUNE_VEHICLES);
+        prune_dead_vehicles();
+    }
 
+    PhaseTimer timer(*this, Phase::VEHICLES);
     for (auto& [id, vehicle] : vehicles) {
+        if (vehicle.ghost) {
+            continue;
+        }
         vehicle.highlighted = false;
-        vehicle.behaviors(neighbors, food_neighbors);
-        vehicle.update();
+        {
+            auto                stream =
+                vehicle_stream(id, RandomStream::Phase::BEHAVIOR);
+            RandomStream::Scope scope(stream);
+            vehicle.behaviors(neighbors, food_neighbors);
+        }
+        {
+            auto                stream =
+                vehicle_stream(id, RandomStream::Phase::UPDATE);
+            RandomStream::Scope scope(stream);
+            vehicle.update();
+        }
+        if (!vehicle.is_dead()) {
+            max_age = std::max(max_age, vehicle.get_age());
+        }
         if (vehicle.get_fitness() > World::max_fitness.second) {
             World::max_fitness.first  = vehicle.id;
             World::max_fitness.second = vehicle.get_fitness();
@@ -350,6 +532,295 @@ void World::vehicle_tick(Vehicles& neighbors, Foods& food_neighbors)
     }
 }
 
+void World::tiled_food_tick()
+{
+    {
+        PhaseTimer timer(*this, Phase::PRUNE_FOOD);
+        prune_eaten_food();
+    }
+    {
+        PhaseTimer timer(*this, Phase::INDEX);
+        tiles.rebuild(*this);
+        reset_tile_contexts();
+    }
+
+    PhaseTimer timer(*this, Phase::FOOD);
+    workers->parallel_for(tiles.tile_count(), [this](std::size_t tile) {
+        static thread_local VehicleRefs neighbours;
+
+        current_tile = &tile_contexts[tile];
+        tiles.neighbourhood(tile, neighbours);
+        for (auto& [id, food] : tiles.food[tile]) {
+            if (food->ghost) {
+                continue;
+            }
+            auto                stream = food_stream(id);
+            RandomStream::Scope scope(stream);
+            food->behaviors(neighbours);
+            food->update();
+        }
+        current_tile = nullptr;
+    });
+    merge_tile_contexts();
+}
+
+void World::tiled_vehicle_tick()
+{
+    {
+        PhaseTimer timer(*this, Phase::PRUNE_VEHICLES);
+        prune_dead_vehicles();
+    }
+    {
+        PhaseTimer timer(*this, Phase::INDEX);
+        tiles.rebuild(*this);
+        reset_tile_contexts();
+    }
+
+    PhaseTimer timer(*this, Phase::VEHICLES);
+
+    // every vehicle decides what to do while the world holds still: nothing
+    // moves and whatever vehicles do to each other waits for the barrier
+    workers->parallel_for(tiles.tile_count(), [this](std::size_t tile) {
+        static thread_local VehicleRefs vehicle_neighbours;
+        static thread_local FoodRefs    food_neighbours;
+
+        current_tile = &tile_contexts[tile];
+        tiles.neighbourhood(tile, vehicle_neighbours);
+        tiles.neighbourhood(tile, food_neighbours);
+        for (auto& [id, vehicle] : tiles.vehicles[tile]) {
+            if (vehicle->ghost) {
+                continue;
+            }
+            vehicle->highlighted = false;
+            auto                stream =
+                vehicle_stream(id, RandomStream::Phase::BEHAVIOR);
+            RandomStream::Scope scope(stream);
+            vehicle->behaviors(vehicle_neighbours, food_neighbours);
+        }
+        current_tile = nullptr;
+    });
+
+    for (auto const& context : tile_contexts) {
+        for (auto const& interaction : context.interactions) {
+            apply(interaction);
+        }
+    }
+
+    // then every vehicle moves, which only touches the vehicle itself
+    workers->parallel_for(tiles.tile_count(), [this](std::size_t tile) {
+        auto& context = tile_contexts[tile];
+        current_tile  = &context;
+        for (auto& [id, vehicle] : tiles.vehicles[tile]) {
+            if (vehicle->ghost) {
+                continue;
+            }
+            auto                stream =
+                vehicle_stream(id, RandomStream::Phase::UPDATE);
+            RandomStream::Scope scope(stream);
+            vehicle->update();
+            if (!vehicle->is_dead()) {
+                context.max_age = std::max(context.max_age, vehicle->get_age());
+            }
+            if (vehicle->get_fitness() > context.fittest.second) {
+                context.fittest = {id, vehicle->get_fitness()};
+            }
+        }
+        current_tile = nullptr;
+    });
+    merge_tile_contexts();
+}
+
+void World::interact(Interaction const& interaction)
+{
+    if (current_tile) {
+        current_tile->interactions.push_back(interaction);
+        return;
+    }
+    apply(interaction);
+}
+
+void World::apply(Interaction const& interaction)
+{
+    using Kind = Interaction::Kind;
+
+    switch (interaction.kind) {
+        case Kind::HEALTH:
+            interaction.vehicle->change_health(interaction.amount);
+            break;
+        case Kind::DRAIN:
+            interaction.vehicle->health--;
+            break;
+        case Kind::KILL:
+            interaction.vehicle->kill();
+            break;
+        case Kind::CONSUME:
+            interaction.food->consume(*interaction.vehicle);
+            break;
+        case Kind::EXPIRE:
+            interaction.food->expire();
+            break;
+        case Kind::HIGHLIGHT:
+            interaction.vehicle->highlighted = true;
+            break;
+    }
+}
+
+void World::issue(Command command)
+{
+    command.tick = static_cast<std::uint32_t>(tick_counter);
+    if (command_log) {
+        command_log->append(command);
+    }
+    if (history) {
+        history->record(command);
+    }
+
+    // a command always sees the world with the last tick's actions done, so
+    // that it does the same whether or not something flushed them early
+    flush_events();
+
+    auto stream = RandomStream::for_entity(
+        static_cast<std::uint64_t>(seed), RandomStream::Domain::COMMAND,
+        commands_issued++, RandomStream::Phase::BEHAVIOR, command.tick);
+    RandomStream::Scope scope(stream);
+    execute(command);
+}
+
+void World::execute(Command const& command)
+{
+    using Kind = Command::Kind;
+
+    Vec2D const at{command.x, command.y};
+    auto const  count = static_cast<int>(command.value);
+
+    switch (command.kind) {
+        case Kind::KILL:
+            for (auto& vehicle : vehicles | std::views::values) {
+                if (vehicle.get_position().distance_to(at) < command.value) {
+                    vehicle.kill();
+                }
+            }
+            break;
+        case Kind::FEED:
+            for (int i = 0; i < count; i++) {
+                new_food(at + Vec2D::random(5), 5.0 / 0.05);
+            }
+            break;
+        case Kind::SELECT: {
+            // the nearest rather than the first one found, which would
+            // depend on the order of the map
+            Vehicle* nearest  = nullptr;
+            double   distance = select_radius;
+            for (auto& [id, vehicle] : vehicles) {
+                auto const d = vehicle.get_position().distance_to(at);
+                if (d < distance || (d == distance && nearest &&
+                                     id < nearest->id)) {
+                    nearest  = &vehicle;
+                    distance = d;
+                }
+            }
+            if (nearest) {
+                nearest->verbose = !nearest->verbose;
+            }
+        } break;
+        case Kind::CLEAR_SELECTION:
+            clear_verbose_vehicles();
+            break;
+        case Kind::ADD_VEHICLES:
+            for (int i = 0; i < count; i++) {
+                create_vehicle(rand_pos_in_bounds());
+            }
+            break;
+        case Kind::ADD_FOOD:
+            for (int i = 0; i < count; i++) {
+                new_random_food();
+            }
+            break;
+        case Kind::SET_FOOD_CHANCE:
+            food_pct_chance = command.value;
+            break;
+        case Kind::SET_MAX_FOOD:
+            max_food = static_cast<unsigned int>(command.value);
+            break;
+        case Kind::SET_TARGET_TPS:
+            target_tps = count;
+            break;
+        case Kind::TOGGLE_NIGHT:
+            disable_night = !disable_night;
+            break;
+        case Kind::END:
+            break;
+    }
+}
+
+RandomStream World::world_stream() const noexcept
+{
+    return RandomStream::for_world(static_cast<std::uint64_t>(seed),
+                                   static_cast<std::uint32_t>(tick_counter));
+}
+
+void World::flush_events()
+{
+    auto                stream = world_stream();
+    RandomStream::Scope scope(stream);
+    process_events();
+}
+
+RandomStream World::vehicle_stream(VehicleIdType       id,
+                                   RandomStream::Phase phase) const noexcept
+{
+    return RandomStream::for_entity(static_cast<std::uint64_t>(seed),
+                                    RandomStream::Domain::VEHICLE, id, phase,
+                                    static_cast<std::uint32_t>(tick_counter));
+}
+
+RandomStream World::food_stream(FoodIdType id) const noexcept
+{
+    return RandomStream::for_entity(static_cast<std::uint64_t>(seed),
+                                    RandomStream::Domain::FOOD, id,
+                                    RandomStream::Phase::BEHAVIOR,
+                                    static_cast<std::uint32_t>(tick_counter));
+}
+
+void World::enable_workers(unsigned count)
+{
+    if (count == 0) {
+        workers.reset();
+    } else {
+        workers = std::make_shared<WorkerPool>(count);
+    }
+}
+
+void World::reset_tile_contexts()
+{
+    tile_contexts.resize(tiles.tile_count());
+    for (auto& context : tile_contexts) {
+        context.interactions.clear();
+        context.max_age = 0;
+        context.fittest = {0, 0.0};
+    }
+}
+
+void World::merge_tile_contexts()
+{
+    // tile order keeps the result independent of which thread ran what
+    for (auto& context : tile_contexts) {
+        while (!context.actions.empty()) {
+            actions.push(std::move(context.actions.front()));
+            context.actions.pop();
+        }
+        max_age = std::max(max_age, context.max_age);
+        if (context.fittest.second > World::max_fitness.second) {
+            World::max_fitness = context.fittest;
+        }
+    }
+}
+
+auto World::action_queue() -> decltype(actions)&
+{
+    return current_tile ? current_tile->actions : actions;
+}
+
 void World::process_events()
 {
     while (!actions.empty()) {